@@ -1,7 +1,573 @@
 /* This is a standard, safe library of utility functions that are to be used*/
 /* by AIs in preference over the default, unsafe C equivalents.             */
+#if defined(__linux__) && !defined(_GNU_SOURCE) && !defined(AIUTILS_HEADER_ONLY)
+#define _GNU_SOURCE                     /* for memrchr()                    */
+#endif
 #include "aiutils.h"
 
+#if defined(_WIN32) || defined(_MSC_VER)
+#if !defined(WIN32_LEAN_AND_MEAN)
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>                    /* For MapViewOfFile                */
+#else
+#include <fcntl.h>                      /* For open                         */
+#include <sys/mman.h>                   /* For mmap, madvise                */
+#include <sys/stat.h>                   /* For fstat                        */
+#include <unistd.h>                     /* For close, sysconf               */
+#if !defined(AIUTILS_NO_THREADS)
+#include <pthread.h>                    /* For aiu_parallel_lines           */
+#endif
+#endif
+
+/* One-byte case conversion used by every case function. By default it      */
+/* follows the locale's isupper()/tolower() rules; -DAIUTILS_ASCII_CASE     */
+/* forces pure ASCII, changing only A-Z / a-z and leaving other bytes.      */
+#if defined(AIUTILS_ASCII_CASE)
+#define AIU_TOLOWER(c) ((c) >= 'A' && (c) <= 'Z' ? (char)((c) | 0x20) : (c))
+#define AIU_TOUPPER(c) ((c) >= 'a' && (c) <= 'z' ? (char)((c) & ~0x20) : (c))
+#else
+#define AIU_TOLOWER(c) \
+    (isupper((unsigned char)(c)) ? (char)tolower((unsigned char)(c)) : (c))
+#define AIU_TOUPPER(c) \
+    (islower((unsigned char)(c)) ? (char)toupper((unsigned char)(c)) : (c))
+#endif
+
+/* Nonzero if byte "c" is in the aiu_delims bitmap "d" */
+#define AIU_DELIM_HAS(d, c) (((d)->bits[(c) >> 5] >> ((c) & 31)) & 1)
+
+/* Per-thread storage, where the compiler has it (else undefined) */
+#if defined(_MSC_VER) && !defined(__clang__)
+#define AIU_THREAD_LOCAL __declspec(thread)
+#elif defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L && !defined(__STDC_NO_THREADS__)
+#define AIU_THREAD_LOCAL _Thread_local
+#elif defined(__GNUC__) || defined(__clang__)
+#define AIU_THREAD_LOCAL __thread
+#endif
+
+/* Index of the lowest set bit of "x", which must be nonzero */
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+static unsigned aiu_ctz32(uint32_t x) {
+    unsigned long i;
+    _BitScanForward(&i, x);
+    return (unsigned)i;
+}
+static unsigned aiu_ctz64(uint64_t x) {
+    unsigned long i;
+    if ((uint32_t)x) { _BitScanForward(&i, (uint32_t)x); return (unsigned)i; }
+    _BitScanForward(&i, (uint32_t)(x >> 32));
+    return (unsigned)i + 32;
+}
+#elif defined(__GNUC__) || defined(__clang__)
+#define aiu_ctz32(x) ((unsigned)__builtin_ctz(x))
+#define aiu_ctz64(x) ((unsigned)__builtin_ctzll(x))
+#else
+static unsigned aiu_ctz64(uint64_t x) {
+    unsigned i = 0;
+    while (!(x & 1)) x >>= 1, i++;
+    return i;
+}
+#define aiu_ctz32(x) aiu_ctz64((uint64_t)(x))
+#endif
+
+/****************************************************************************/
+/* Block kernels (AIUTILS_SIMD)                                             */
+/*                                                                          */
+/* When built with -DAIUTILS_SIMD, the copy and case functions below find   */
+/* the null and convert case 16 or 32 bytes at a time instead of one byte   */
+/* per loop.                                                                */
+/* SSE2 is used on x86-64, AVX2 when the running CPU has it, NEON on ARM64, */
+/* and a portable word-at-a-time (SWAR) version everywhere else.            */
+/*                                                                          */
+/* NOTE: The null scan reads whole ALIGNED blocks, so it may look at a few  */
+/*       bytes past the terminator. An aligned block never crosses a page,  */
+/*       so this is safe (libc's own strlen does the same), but memory      */
+/*       checkers like Valgrind/ASan may report it.                         */
+/****************************************************************************/
+#if defined(AIUTILS_SIMD)
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define AIU_HAVE_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define AIU_HAVE_AVX2 1             /* built with a target attribute, and   */
+#include <immintrin.h>              /* picked only if the CPU supports it   */
+#endif
+
+#if defined(__aarch64__) || defined(_M_ARM64)   /* vmaxvq_u8 is A64-only  */
+#define AIU_HAVE_NEON 1
+#include <arm_neon.h>
+#if defined(__linux__)
+#include <sys/auxv.h>               /* For getauxval                        */
+#endif
+#endif
+
+#define AIU_ONES  UINT64_C(0x0101010101010101)
+#define AIU_HIGHS UINT64_C(0x8080808080808080)
+
+/* Nonzero if any byte of "v" is zero */
+#define AIU_HAS_ZERO(v) (((v) - AIU_ONES) & ~(v) & AIU_HIGHS)
+
+/* The null scans read whole aligned blocks, which can run past the null    */
+/* (and past the end of the allocation) but never into the next page.       */
+/* That is safe, but AddressSanitizer would report it, so those few         */
+/* functions are built without its checks.                                  */
+#if defined(__has_feature)
+#if __has_feature(address_sanitizer)
+#define AIU_ASAN 1
+#endif
+#endif
+#if defined(__SANITIZE_ADDRESS__) || defined(AIU_ASAN)
+#define AIU_NO_ASAN __attribute__((no_sanitize_address))
+#else
+#define AIU_NO_ASAN
+#endif
+
+#if !defined(AIU_HAVE_SSE2) && !defined(AIU_HAVE_NEON)
+/* Portable SWAR null scan: index of the first null in s[0..max), or max */
+AIU_NO_ASAN
+static size_t aiu_nul_scan_swar(const char *s, size_t max) {
+    const char *p = s;
+    const char *end = s + max;
+    uint64_t v;
+
+    /* Walk bytes until "p" is word aligned */
+    for (; p < end && ((uintptr_t)p & 7); p++) if (!*p) return (size_t)(p - s);
+
+    /* Then 8 bytes per step; narrow down to the byte once a word has a 0 */
+    for (; p < end; p += 8) {
+        memcpy(&v, p, 8);
+        if (AIU_HAS_ZERO(v)) break;
+    }
+    for (; p < end; p++) if (!*p) return (size_t)(p - s);
+    return max;
+}
+#endif
+
+#if defined(AIU_HAVE_SSE2)
+AIU_NO_ASAN
+static size_t aiu_nul_scan_sse2(const char *s, size_t max) {
+    const char *base = (const char *)((uintptr_t)s & ~(uintptr_t)15);
+    const __m128i zero = _mm_setzero_si128();
+    uint32_t mask;
+    size_t i;
+
+    /* First aligned block: drop the bytes that sit before "s" */
+    mask = (uint32_t)_mm_movemask_epi8(
+        _mm_cmpeq_epi8(_mm_load_si128((const __m128i *)base), zero));
+    mask >>= (unsigned)(s - base);
+    if (mask) {
+        i = aiu_ctz32(mask);
+        return i < max ? i : max;
+    }
+
+    for (base += 16; (size_t)(base - s) < max; base += 16) {
+        mask = (uint32_t)_mm_movemask_epi8(
+            _mm_cmpeq_epi8(_mm_load_si128((const __m128i *)base), zero));
+        if (mask) {
+            i = (size_t)(base - s) + aiu_ctz32(mask);
+            return i < max ? i : max;
+        }
+    }
+    return max;
+}
+#endif
+
+#if defined(AIU_HAVE_AVX2)
+__attribute__((target("avx2"))) AIU_NO_ASAN
+static size_t aiu_nul_scan_avx2(const char *s, size_t max) {
+    const char *base = (const char *)((uintptr_t)s & ~(uintptr_t)31);
+    const __m256i zero = _mm256_setzero_si256();
+    uint32_t mask;
+    size_t i;
+
+    mask = (uint32_t)_mm256_movemask_epi8(
+        _mm256_cmpeq_epi8(_mm256_load_si256((const __m256i *)base), zero));
+    mask >>= (unsigned)(s - base);
+    if (mask) {
+        i = aiu_ctz32(mask);
+        return i < max ? i : max;
+    }
+
+    for (base += 32; (size_t)(base - s) < max; base += 32) {
+        mask = (uint32_t)_mm256_movemask_epi8(
+            _mm256_cmpeq_epi8(_mm256_load_si256((const __m256i *)base), zero));
+        if (mask) {
+            i = (size_t)(base - s) + aiu_ctz32(mask);
+            return i < max ? i : max;
+        }
+    }
+    return max;
+}
+#endif
+
+#if defined(AIU_HAVE_NEON)
+/* NEON has no movemask: squeeze a compare result to 4 bits per byte */
+static uint64_t aiu_neon_mask(uint8x16_t eq) {
+    return vget_lane_u64(vreinterpret_u64_u8(
+        vshrn_n_u16(vreinterpretq_u16_u8(eq), 4)), 0);
+}
+
+/* 4 bits per byte: nonzero nibble where the byte was 0 */
+static uint64_t aiu_neon_zero_mask(uint8x16_t v) {
+    return aiu_neon_mask(vceqq_u8(v, vdupq_n_u8(0)));
+}
+
+AIU_NO_ASAN
+static size_t aiu_nul_scan_neon(const char *s, size_t max) {
+    const char *base = (const char *)((uintptr_t)s & ~(uintptr_t)15);
+    uint64_t mask;
+    size_t i;
+
+    mask = aiu_neon_zero_mask(vld1q_u8((const uint8_t *)base));
+    mask >>= 4 * (unsigned)(s - base);
+    if (mask) {
+        i = aiu_ctz64(mask) / 4;
+        return i < max ? i : max;
+    }
+
+    for (base += 16; (size_t)(base - s) < max; base += 16) {
+        mask = aiu_neon_zero_mask(vld1q_u8((const uint8_t *)base));
+        if (mask) {
+            i = (size_t)(base - s) + aiu_ctz64(mask) / 4;
+            return i < max ? i : max;
+        }
+    }
+    return max;
+}
+#endif
+
+/* Scalar null scan: one byte per step */
+static size_t aiu_nul_scan_bytes(const char *s, size_t max) {
+    size_t i;
+
+    for (i = 0; i < max && s[i]; i++);
+    return i;
+}
+
+/* Scalar case copy: AIU_TOUPPER()/AIU_TOLOWER() (the locale path) per byte */
+static void aiu_case_copy_bytes(char *d, const char *s, size_t n, int upper) {
+    size_t j;
+
+    if (upper) for (j = 0; j < n; j++) d[j] = AIU_TOUPPER(s[j]);
+    else       for (j = 0; j < n; j++) d[j] = AIU_TOLOWER(s[j]);
+}
+
+/* Copy "n" bytes from "s" to "d" ("d" may equal "s"), converting them to   */
+/* upper case if "upper" is set, else to lower case. Blocks that are pure   */
+/* ASCII take a range-compare path; from the first block holding a byte     */
+/* >= 0x80 on, AIU_TOUPPER()/AIU_TOLOWER() (the locale path) is used.       */
+static void aiu_case_copy_block(char *d, const char *s, size_t n, int upper) {
+    const char lo = upper ? 'a' : 'A';  /* range of letters that change    */
+    const char hi = upper ? 'z' : 'Z';
+    size_t i = 0;
+
+#if defined(AIU_HAVE_SSE2)
+    const __m128i below = _mm_set1_epi8((char)(lo - 1));
+    const __m128i above = _mm_set1_epi8((char)(hi + 1));
+    const __m128i bit5 = _mm_set1_epi8(0x20);
+
+    for (; i + 16 <= n; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(s + i));
+        if (_mm_movemask_epi8(v)) break;            /* non-ASCII byte       */
+        __m128i in = _mm_and_si128(_mm_cmpgt_epi8(v, below),
+                                   _mm_cmpgt_epi8(above, v));
+        _mm_storeu_si128((__m128i *)(d + i),
+                         _mm_xor_si128(v, _mm_and_si128(in, bit5)));
+    }
+#elif defined(AIU_HAVE_NEON)
+    for (; i + 16 <= n; i += 16) {
+        uint8x16_t v = vld1q_u8((const uint8_t *)(s + i));
+        if (vmaxvq_u8(v) >= 0x80) break;            /* non-ASCII byte       */
+        uint8x16_t in = vcleq_u8(vsubq_u8(v, vdupq_n_u8((uint8_t)lo)),
+                                 vdupq_n_u8((uint8_t)(hi - lo)));
+        vst1q_u8((uint8_t *)(d + i),
+                 veorq_u8(v, vandq_u8(in, vdupq_n_u8(0x20))));
+    }
+#else
+    for (; i + 8 <= n; i += 8) {
+        uint64_t v, a, z;
+        memcpy(&v, s + i, 8);
+        if (v & AIU_HIGHS) break;                   /* non-ASCII byte       */
+        a = v + AIU_ONES * (uint8_t)(0x80 - lo);     /* high bit: >= lo     */
+        z = v + AIU_ONES * (uint8_t)(0x80 - hi - 1); /* high bit: >  hi     */
+        v ^= ((a ^ z) & AIU_HIGHS) >> 2;             /* flip 0x20 in range  */
+        memcpy(d + i, &v, 8);
+    }
+#endif
+
+    /* Tail, or the rest after the first non-ASCII block: the locale path */
+    aiu_case_copy_bytes(d + i, s + i, n - i, upper);
+}
+
+/* One set of kernels per variant this build has, best last. The best       */
+/* set the CPU supports (or the one AIUTILS_CPU names) is bound once, and   */
+/* every later call goes through the "aiu_kern" pointer.                    */
+typedef struct aiu_kernels {
+    int         variant;                /* AIU_VARIANT_*                    */
+    const char *name;                   /* reported, and matched by env var */
+    unsigned    needs;                  /* AIU_CPU_* bits the CPU must have */
+    size_t    (*nul_scan)(const char *s, size_t max);
+    void      (*case_copy)(char *d, const char *s, size_t n, int upper);
+} aiu_kernels;
+
+static const aiu_kernels aiu_kernel_sets[] = {
+    { AIU_VARIANT_SCALAR, "scalar", 0, aiu_nul_scan_bytes, aiu_case_copy_bytes },
+#if defined(AIU_HAVE_SSE2)
+    { AIU_VARIANT_SSE2, "sse2", AIU_CPU_SSE2, aiu_nul_scan_sse2, aiu_case_copy_block },
+#elif defined(AIU_HAVE_NEON)
+    { AIU_VARIANT_NEON, "neon", AIU_CPU_NEON, aiu_nul_scan_neon, aiu_case_copy_block },
+#else
+    { AIU_VARIANT_SWAR, "swar", 0, aiu_nul_scan_swar, aiu_case_copy_block },
+#endif
+#if defined(AIU_HAVE_AVX2)
+    { AIU_VARIANT_AVX2, "avx2", AIU_CPU_AVX2, aiu_nul_scan_avx2, aiu_case_copy_block },
+#endif
+};
+#define AIU_KERNEL_SETS (sizeof(aiu_kernel_sets) / sizeof(aiu_kernel_sets[0]))
+
+/* Published once, read on every call: plain loads on x86 and ARM64 */
+#if defined(__GNUC__) || defined(__clang__)
+#define AIU_PUBLISH(p, v) __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+#define AIU_READ(p)       __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#else
+#define AIU_PUBLISH(p, v) (*(p) = (v))
+#define AIU_READ(p)       (*(p))
+#endif
+
+static const aiu_kernels *volatile aiu_kern;   /* NULL until set up        */
+static volatile unsigned aiu_cpu_found;        /* AIU_CPU_* bits detected  */
+
+/* AIU_CPU_* features of the running CPU that this build has kernels for */
+static unsigned aiu_cpu_probe(void) {
+    unsigned f = 0;
+
+#if defined(AIU_HAVE_SSE2)
+    f |= AIU_CPU_SSE2;                  /* part of the x86-64 baseline      */
+#endif
+#if defined(AIU_HAVE_AVX2)
+    __builtin_cpu_init();               /* cpuid, plus the OS's XSAVE state */
+    if (__builtin_cpu_supports("avx2")) f |= AIU_CPU_AVX2;
+    if (__builtin_cpu_supports("avx512bw")) f |= AIU_CPU_AVX512;
+#endif
+#if defined(AIU_HAVE_NEON)
+#if defined(__linux__) && defined(HWCAP_ASIMD)
+    if (getauxval(AT_HWCAP) & HWCAP_ASIMD) f |= AIU_CPU_NEON;
+#else
+    f |= AIU_CPU_NEON;                  /* mandatory on ARM64               */
+#endif
+#endif
+    return f;
+}
+
+/* Bind the kernels: the best set the CPU has, capped by AIUTILS_CPU.       */
+/* Racing first calls all compute and publish the same set.                 */
+static const aiu_kernels *aiu_cpu_setup(void) {
+    const unsigned found = aiu_cpu_probe();
+    size_t i, best = 0;
+#if defined(_MSC_VER)
+    char env[16];
+    size_t got = 0;
+
+    if (getenv_s(&got, env, sizeof(env), "AIUTILS_CPU") != 0 || got == 0) env[0] = '\0';
+#else
+    const char *env = getenv("AIUTILS_CPU");
+
+    if (env == NULL) env = "";
+#endif
+
+    for (i = 1; i < AIU_KERNEL_SETS; i++) {
+        if ((aiu_kernel_sets[i].needs & found) == aiu_kernel_sets[i].needs) best = i;
+    }
+    for (i = 0; i < best; i++) {        /* a lower variant may be forced    */
+        if (strcmpii(env, aiu_kernel_sets[i].name) == 0) best = i;
+    }
+
+    AIU_PUBLISH(&aiu_cpu_found, found);
+    AIU_PUBLISH(&aiu_kern, &aiu_kernel_sets[best]);
+    return &aiu_kernel_sets[best];
+}
+
+/* The bound kernel set, binding it on first use */
+static const aiu_kernels *aiu_kernels_get(void) {
+    const aiu_kernels *k = AIU_READ(&aiu_kern);
+
+    return k ? k : aiu_cpu_setup();
+}
+
+/* Nonzero if the bound kernels are vector ones (SSE2, AVX2 or NEON) */
+#define AIU_VECTOR_ON() (aiu_kernels_get()->variant >= AIU_VARIANT_SSE2)
+
+/* Index of the first null in s[0..max), or max if there is none */
+static size_t aiu_nul_scan(const char *s, size_t max) {
+    if (max < 16) return aiu_nul_scan_bytes(s, max);  /* too short to pay */
+    return aiu_kernels_get()->nul_scan(s, max);
+}
+
+/* Case copy through the bound kernel; see aiu_case_copy_block() */
+static void aiu_case_copy(char *d, const char *s, size_t n, int upper) {
+    aiu_kernels_get()->case_copy(d, s, n, upper);
+}
+
+#endif /* AIUTILS_SIMD */
+
+/****************************************************************************/
+/* Call counters (AIUTILS_STATS)                                            */
+/*                                                                          */
+/* When built with -DAIUTILS_STATS, the bounded copy functions count their  */
+/* calls, the chars they write and how often the result was cut short.      */
+/* Each thread adds to its own cache-line-padded slot with plain stores,    */
+/* so counting takes no lock and no two threads share a line. A thread      */
+/* hands its slot back when it exits (a pthread key or FLS destructor); the */
+/* counts stay in the slot and the next thread to take it adds to them, so  */
+/* the sums never drop. Only threads beyond AIU_STATS_SLOTS running at the  */
+/* same time share one extra slot through atomic adds. With                 */
+/* AIUTILS_NO_THREADS there is no exit hook and a slot is never handed      */
+/* back, so every thread started after the first AIU_STATS_SLOTS shares.    */
+/* aiu_stats_snapshot() sums the slots on demand.                           */
+/*                                                                          */
+/* Without AIUTILS_STATS, AIU_STAT() expands to nothing and its arguments   */
+/* are never evaluated.                                                     */
+/****************************************************************************/
+#if defined(AIUTILS_STATS)
+
+#define AIU_STATS_SLOTS 128             /* live threads with their own slot */
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#define AIU_ALIGN64 __declspec(align(64))
+#elif defined(__GNUC__) || defined(__clang__)
+#define AIU_ALIGN64 __attribute__((aligned(64)))
+#else
+#define AIU_ALIGN64
+#endif
+
+/* Relaxed is enough: every counter is independent, and only summed */
+#if defined(__GNUC__) || defined(__clang__)
+#define AIU_STAT_LOAD(p)         __atomic_load_n((p), __ATOMIC_RELAXED)
+#define AIU_STAT_STORE(p, v)     __atomic_store_n((p), (v), __ATOMIC_RELAXED)
+#define AIU_STAT_FETCH_ADD(p, v) __atomic_fetch_add((p), (v), __ATOMIC_RELAXED)
+#define AIU_STAT_TAKE(p)         (!__atomic_exchange_n((p), 1, __ATOMIC_ACQUIRE))
+#define AIU_STAT_GIVE(p)         __atomic_store_n((p), 0, __ATOMIC_RELEASE)
+#elif defined(_MSC_VER)
+#define AIU_STAT_LOAD(p)         (*(volatile uint64_t *)(p))
+#define AIU_STAT_STORE(p, v)     (*(volatile uint64_t *)(p) = (v))
+#define AIU_STAT_FETCH_ADD(p, v) \
+    ((uint64_t)InterlockedExchangeAdd64((volatile LONG64 *)(p), (LONG64)(v)))
+#define AIU_STAT_TAKE(p)         (!InterlockedExchange((volatile LONG *)(p), 1))
+#define AIU_STAT_GIVE(p)         ((void)InterlockedExchange((volatile LONG *)(p), 0))
+#else                                   /* no atomics: one thread only      */
+#define AIU_STAT_LOAD(p)         (*(p))
+#define AIU_STAT_STORE(p, v)     (*(p) = (v))
+#define AIU_STAT_FETCH_ADD(p, v) ((*(p) += (v)) - (v))
+#define AIU_STAT_TAKE(p)         (*(p) ? 0 : (*(p) = 1))
+#define AIU_STAT_GIVE(p)         ((void)(*(p) = 0))
+#endif
+
+/* One thread's counters, rounded up to whole cache lines */
+typedef union aiu_statslot {
+    aiu_stat fn[AIU_STAT_COUNT];
+    char     pad[(sizeof(aiu_stat) * AIU_STAT_COUNT + 63) / 64 * 64];
+} aiu_statslot;
+
+static AIU_ALIGN64 aiu_statslot aiu_statslots[AIU_STATS_SLOTS + 1];  /* +shared */
+static uint32_t aiu_statslot_taken[AIU_STATS_SLOTS];  /* 1 while a thread has it */
+
+#if defined(AIU_THREAD_LOCAL)
+static AIU_THREAD_LOCAL aiu_statslot *aiu_mystats;
+
+#if !defined(AIUTILS_NO_THREADS)
+/* Thread exit: hand the slot back; counts made after this go to "shared" */
+static void aiu_stat_give(void *slot) {
+    aiu_mystats = &aiu_statslots[AIU_STATS_SLOTS];
+    AIU_STAT_GIVE(&aiu_statslot_taken[(aiu_statslot *)slot - aiu_statslots]);
+}
+#endif
+
+#if defined(AIUTILS_NO_THREADS)
+static int aiu_stat_on_exit(aiu_statslot *slot) {
+    (void)slot;                         /* no exit hook: kept for good      */
+    return 1;
+}
+#elif defined(_WIN32) || defined(_MSC_VER)
+static DWORD aiu_stat_fls = FLS_OUT_OF_INDEXES;
+static INIT_ONCE aiu_stat_once = INIT_ONCE_STATIC_INIT;
+
+static VOID WINAPI aiu_stat_fls_done(PVOID slot) {
+    if (slot != NULL) aiu_stat_give(slot);
+}
+
+static BOOL CALLBACK aiu_stat_fls_init(PINIT_ONCE once, PVOID arg, PVOID *ctx) {
+    (void)once, (void)arg, (void)ctx;
+    aiu_stat_fls = FlsAlloc(aiu_stat_fls_done);
+    return TRUE;
+}
+
+/* Arrange for "slot" to be handed back when the thread exits */
+static int aiu_stat_on_exit(aiu_statslot *slot) {
+    InitOnceExecuteOnce(&aiu_stat_once, aiu_stat_fls_init, NULL, NULL);
+    return aiu_stat_fls != FLS_OUT_OF_INDEXES && FlsSetValue(aiu_stat_fls, slot);
+}
+#else
+static pthread_key_t aiu_stat_key;
+static int aiu_stat_key_ok;
+static pthread_once_t aiu_stat_once = PTHREAD_ONCE_INIT;
+
+static void aiu_stat_key_init(void) {
+    aiu_stat_key_ok = pthread_key_create(&aiu_stat_key, aiu_stat_give) == 0;
+}
+
+/* Arrange for "slot" to be handed back when the thread exits */
+static int aiu_stat_on_exit(aiu_statslot *slot) {
+    pthread_once(&aiu_stat_once, aiu_stat_key_init);
+    return aiu_stat_key_ok && pthread_setspecific(aiu_stat_key, slot) == 0;
+}
+#endif
+
+/* A free slot for the calling thread, or the shared one if none is free */
+static aiu_statslot *aiu_stat_take(void) {
+    size_t i;
+
+    for (i = 0; i < AIU_STATS_SLOTS; i++) {
+        if (AIU_STAT_TAKE(&aiu_statslot_taken[i])) {
+            if (aiu_stat_on_exit(&aiu_statslots[i])) return &aiu_statslots[i];
+            AIU_STAT_GIVE(&aiu_statslot_taken[i]);  /* could not be handed back */
+            break;
+        }
+    }
+    return &aiu_statslots[AIU_STATS_SLOTS];
+}
+#endif
+
+/* Count one call of "fn" that wrote "bytes" chars and was "cut" short */
+static void aiu_stat_add(int fn, size_t bytes, int cut) {
+    aiu_statslot *shared = &aiu_statslots[AIU_STATS_SLOTS];
+    aiu_stat *st;
+
+#if defined(AIU_THREAD_LOCAL)
+    if (aiu_mystats == NULL)            /* first counted call on the thread */
+        aiu_mystats = aiu_stat_take();
+    if (aiu_mystats != shared) {        /* ours alone: no locked adds       */
+        st = &aiu_mystats->fn[fn];
+        AIU_STAT_STORE(&st->calls, AIU_STAT_LOAD(&st->calls) + 1);
+        AIU_STAT_STORE(&st->bytes, AIU_STAT_LOAD(&st->bytes) + bytes);
+        if (cut) AIU_STAT_STORE(&st->truncations, AIU_STAT_LOAD(&st->truncations) + 1);
+        return;
+    }
+#endif
+    st = &shared->fn[fn];
+    AIU_STAT_FETCH_ADD(&st->calls, 1);
+    AIU_STAT_FETCH_ADD(&st->bytes, (uint64_t)bytes);
+    if (cut) AIU_STAT_FETCH_ADD(&st->truncations, 1);
+}
+
+#define AIU_STAT(fn, bytes, cut) aiu_stat_add((fn), (size_t)(bytes), (cut) != 0)
+#else
+#define AIU_STAT(fn, bytes, cut) ((void)0)
+#endif /* AIUTILS_STATS */
+
 /****************************************************************************/
 /* strzcpy() - protected string copy                                        */
 /*                                                                          */
@@ -13,8 +579,17 @@
 /****************************************************************************/
 void strzcpy(char *d, const char *s, size_t dsize) {
     if (dsize <= 0) return;             /* return if storage area is zero   */
-    while (*s && --dsize) *d++ = *s++;  /* copy at most dsize-1 characters  */
-    *d = 0;                             /* null-terminate target string     */
+#if defined(AIUTILS_SIMD)
+    size_t n = aiu_nul_scan(s, dsize - 1); /* find null in blocks, then     */
+    memcpy(d, s, n);                    /* copy at most dsize-1 characters  */
+    d[n] = 0;                           /* null-terminate target string     */
+    AIU_STAT(AIU_STAT_STRZCPY, n, s[n]);
+#else
+    char *p = d;
+    while (*s && --dsize) *p++ = *s++;  /* copy at most dsize-1 characters  */
+    *p = 0;                             /* null-terminate target string     */
+    AIU_STAT(AIU_STAT_STRZCPY, p - d, *s);
+#endif
 }
 
 /****************************************************************************/
@@ -27,9 +602,23 @@ void strzcpy(char *d, const char *s, size_t dsize) {
 /****************************************************************************/
 void strzcat(char *d, const char *s, size_t dsize) {
     if (dsize <= 1) return;             /* return if target area too small  */
+#if defined(AIUTILS_SIMD)
+    size_t dl = aiu_nul_scan(d, dsize); /* scan to end of target string     */
+    if (dl >= dsize - 1) {              /* target already full              */
+        AIU_STAT(AIU_STAT_STRZCAT, 0, *s);
+        return;
+    }
+    size_t n = aiu_nul_scan(s, dsize - dl - 1);
+    memcpy(d + dl, s, n);               /* concat at most dsize-1 chars     */
+    d[dl + n] = 0;                      /* null terminate target string     */
+    AIU_STAT(AIU_STAT_STRZCAT, n, s[n]);
+#else
     while (*d) dsize--, d++;            /* scan to end of target string     */
-    while (*s && --dsize) *d++ = *s++;  /* concat at most dsize-1 chars     */
-    *d = 0;                             /* null terminate target string     */
+    char *p = d;
+    while (*s && --dsize) *p++ = *s++;  /* concat at most dsize-1 chars     */
+    *p = 0;                             /* null terminate target string     */
+    AIU_STAT(AIU_STAT_STRZCAT, p - d, *s);
+#endif
 }
 
 /****************************************************************************/
@@ -50,6 +639,108 @@ int strcmpii(const char *s1, const char *s2) {
     return tolower(*s1) - tolower(*s2); /* comparison of 1st unmatched char */
 }
 
+/* Load 8 bytes so that p[0] lands in the most significant byte */
+static uint64_t aiu_load_be64(const unsigned char *p) {
+    return ((uint64_t)p[0] << 56) | ((uint64_t)p[1] << 48) |
+           ((uint64_t)p[2] << 40) | ((uint64_t)p[3] << 32) |
+           ((uint64_t)p[4] << 24) | ((uint64_t)p[5] << 16) |
+           ((uint64_t)p[6] << 8)  |  (uint64_t)p[7];
+}
+
+/* Load 8 bytes so that p[0] lands in the least significant byte */
+static uint64_t aiu_load_le64(const unsigned char *p) {
+    return ((uint64_t)p[7] << 56) | ((uint64_t)p[6] << 48) |
+           ((uint64_t)p[5] << 40) | ((uint64_t)p[4] << 32) |
+           ((uint64_t)p[3] << 24) | ((uint64_t)p[2] << 16) |
+           ((uint64_t)p[1] << 8)  |  (uint64_t)p[0];
+}
+
+/* Store "x" so that its least significant byte lands in p[0] */
+static void aiu_store_le64(unsigned char *p, uint64_t x) {
+    p[0] = (unsigned char)x;         p[1] = (unsigned char)(x >> 8);
+    p[2] = (unsigned char)(x >> 16); p[3] = (unsigned char)(x >> 24);
+    p[4] = (unsigned char)(x >> 32); p[5] = (unsigned char)(x >> 40);
+    p[6] = (unsigned char)(x >> 48); p[7] = (unsigned char)(x >> 56);
+}
+
+/* ASCII case fold: A-Z -> a-z, every other byte unchanged */
+static const unsigned char aiu_ascii_fold[256] = {
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f,
+    0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0x1a, 0x1b, 0x1c, 0x1d, 0x1e, 0x1f,
+    0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27, 0x28, 0x29, 0x2a, 0x2b, 0x2c, 0x2d, 0x2e, 0x2f,
+    0x30, 0x31, 0x32, 0x33, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x3b, 0x3c, 0x3d, 0x3e, 0x3f,
+    0x40, 0x61, 0x62, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69, 0x6a, 0x6b, 0x6c, 0x6d, 0x6e, 0x6f,
+    0x70, 0x71, 0x72, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7a, 0x5b, 0x5c, 0x5d, 0x5e, 0x5f,
+    0x60, 0x61, 0x62, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69, 0x6a, 0x6b, 0x6c, 0x6d, 0x6e, 0x6f,
+    0x70, 0x71, 0x72, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7a, 0x7b, 0x7c, 0x7d, 0x7e, 0x7f,
+    0x80, 0x81, 0x82, 0x83, 0x84, 0x85, 0x86, 0x87, 0x88, 0x89, 0x8a, 0x8b, 0x8c, 0x8d, 0x8e, 0x8f,
+    0x90, 0x91, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9a, 0x9b, 0x9c, 0x9d, 0x9e, 0x9f,
+    0xa0, 0xa1, 0xa2, 0xa3, 0xa4, 0xa5, 0xa6, 0xa7, 0xa8, 0xa9, 0xaa, 0xab, 0xac, 0xad, 0xae, 0xaf,
+    0xb0, 0xb1, 0xb2, 0xb3, 0xb4, 0xb5, 0xb6, 0xb7, 0xb8, 0xb9, 0xba, 0xbb, 0xbc, 0xbd, 0xbe, 0xbf,
+    0xc0, 0xc1, 0xc2, 0xc3, 0xc4, 0xc5, 0xc6, 0xc7, 0xc8, 0xc9, 0xca, 0xcb, 0xcc, 0xcd, 0xce, 0xcf,
+    0xd0, 0xd1, 0xd2, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8, 0xd9, 0xda, 0xdb, 0xdc, 0xdd, 0xde, 0xdf,
+    0xe0, 0xe1, 0xe2, 0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xeb, 0xec, 0xed, 0xee, 0xef,
+    0xf0, 0xf1, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8, 0xf9, 0xfa, 0xfb, 0xfc, 0xfd, 0xfe, 0xff,
+};
+
+/* aiu_ascii_fold[] on all 8 bytes of a word at once */
+static uint64_t aiu_fold8(uint64_t x) {
+    const uint64_t ones = UINT64_C(0x0101010101010101);
+    uint64_t low7 = x & UINT64_C(0x7f7f7f7f7f7f7f7f);
+    uint64_t ge_a = low7 + ones * (0x80 - 'A');         /* high bit: >= 'A' */
+    uint64_t gt_z = low7 + ones * (0x80 - 'Z' - 1);     /* high bit: >  'Z' */
+    uint64_t upper = (ge_a ^ gt_z) & ~x & UINT64_C(0x8080808080808080);
+
+    return x | (upper >> 2);            /* 0x80 >> 2 == 0x20                */
+}
+
+/****************************************************************************/
+/* strcmpii_n() - length-aware, table-driven strcmpii()                     */
+/*                                                                          */
+/* Compares "len1" chars of "s1" with "len2" chars of "s2" ignoring ASCII   */
+/* case, 8 chars per step (16 with -DAIUTILS_SIMD on SSE2) until the first  */
+/* block that differs. Neither needs a null, and a null is an ordinary      */
+/* char. Only A-Z / a-z fold (as with -DAIUTILS_ASCII_CASE), so for ASCII   */
+/* text the result equals strcmpii()'s.                                     */
+/*                                                                          */
+/* RETURNS: 0 if equal, else <0 or >0 like strcmpii() (a shorter string     */
+/*          compares as if it ended in a null).                             */
+/*                                                                          */
+/* EXAMPLE: if (strcmpii_n(tok.ptr, tok.len, "Content-Length", 14) == 0)    */
+/****************************************************************************/
+int strcmpii_n(const char *s1, size_t len1, const char *s2, size_t len2) {
+    const unsigned char *a = (const unsigned char *)s1;
+    const unsigned char *b = (const unsigned char *)s2;
+    size_t n = len1 < len2 ? len1 : len2;
+    size_t i = 0;
+    int c;
+
+#if defined(AIUTILS_SIMD) && defined(AIU_HAVE_SSE2)
+    if (n >= 16 && AIU_VECTOR_ON()) {
+        const __m128i at = _mm_set1_epi8('A' - 1), zt = _mm_set1_epi8('Z' + 1);
+        const __m128i bit = _mm_set1_epi8(0x20);
+
+        for (; i + 16 <= n; i += 16) {  /* bytes >= 0x80 are < 'A' signed  */
+            __m128i x = _mm_loadu_si128((const __m128i *)(a + i));
+            __m128i y = _mm_loadu_si128((const __m128i *)(b + i));
+            __m128i ux = _mm_and_si128(_mm_cmpgt_epi8(x, at), _mm_cmplt_epi8(x, zt));
+            __m128i uy = _mm_and_si128(_mm_cmpgt_epi8(y, at), _mm_cmplt_epi8(y, zt));
+            x = _mm_or_si128(x, _mm_and_si128(ux, bit));
+            y = _mm_or_si128(y, _mm_and_si128(uy, bit));
+            if (_mm_movemask_epi8(_mm_cmpeq_epi8(x, y)) != 0xFFFF) break;
+        }
+    }
+#endif
+    for (; i + 8 <= n; i += 8) {
+        uint64_t x = aiu_load_le64(a + i), y = aiu_load_le64(b + i);
+        if (x != y && aiu_fold8(x) != aiu_fold8(y)) break;
+    }
+    for (; i < n; i++) {
+        if ((c = aiu_ascii_fold[a[i]] - aiu_ascii_fold[b[i]]) != 0) return c;
+    }
+    return (i < len1 ? aiu_ascii_fold[a[i]] : 0) - (i < len2 ? aiu_ascii_fold[b[i]] : 0);
+}
+
 /****************************************************************************/
 /* strbgw() - check if string #1 (str) begins with string #2 (sub)          */
 /*                                                                          */
@@ -63,6 +754,57 @@ int strbgw(const char *str, const char *sub) {
     return 1;
 }
 
+/* "00".."99": two digits per table lookup when formatting integers */
+static const char aiu_digit_pairs[201] =
+    "0001020304050607080910111213141516171819"
+    "2021222324252627282930313233343536373839"
+    "4041424344454647484950515253545556575859"
+    "6061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+/* Number of decimal digits in "n" (1 for 0) */
+static size_t aiu_digits10(uint64_t n) {
+    size_t d = 1;
+
+    for (;;) {                          /* 4 digits per compare round       */
+        if (n < 10) return d;
+        if (n < 100) return d + 1;
+        if (n < 1000) return d + 2;
+        if (n < 10000) return d + 3;
+        n /= 10000;
+        d += 4;
+    }
+}
+
+/* Write the digits of "n" so that the last one lands just before "end" */
+static void aiu_put_digits(char *end, uint64_t n) {
+    while (n >= 100) {
+        const char *pair = aiu_digit_pairs + (n % 100) * 2;
+        n /= 100;
+        *--end = pair[1];
+        *--end = pair[0];
+    }
+    if (n >= 10) {
+        *--end = aiu_digit_pairs[n * 2 + 1];
+        *--end = aiu_digit_pairs[n * 2];
+    } else {
+        *--end = (char)('0' + n);
+    }
+}
+
+/* Right-justify "n" in "wid" chars at "s" (no null); 0 if it had to star   */
+static int aiu_fixed_field(uint64_t n, size_t wid, char *s) {
+    size_t len = aiu_digits10(n);
+
+    if (len > wid) {                    /* Number too big, fill with stars  */
+        memset(s, '*', wid);
+        return 0;
+    }
+    memset(s, ' ', wid - len);          /* Fill left portion with spaces    */
+    aiu_put_digits(s + wid, n);
+    return 1;
+}
+
 /****************************************************************************/
 /* fitoa() - right justified fixed width integer to ascii conversion        */
 /*                                                                          */
@@ -75,91 +817,532 @@ int strbgw(const char *str, const char *sub) {
 /* EXAMPLE: fitoa(123, 5, my_buffer); // my_buffer is now "  123"           */
 /****************************************************************************/
 void fitoa(uint32_t n, size_t wid, char *s) {
-    char *p;
-
-    p = s + wid;              /* Point to the last char in the data portion */
-    *p = '\0';        /* Null-terminate the string *after* the data portion */
-
-    do {
-        if (p <= s) {                    /* Number too big, fill with stars */
-            for (p = s + wid; p > s;) *--p = '*';
-            return;                                          /* We are done */
-        }
-        
-        *--p = (char)('0' + n % 10); /* Store 1 digit, working right to left*/
-        n /= 10;
-    } while (n); /* Repeat if number is non-zero */
-
-    while (p > s) *--p = ' ';    /* Fill remaining left portion with spaces */
+    aiu_fixed_field(n, wid, s);
+    s[wid] = '\0';    /* Null-terminate the string *after* the data portion */
 }
 
 /****************************************************************************/
-/* numzcat() - protected integer to string concatenation                    */
+/* fitoa64() - fitoa() for 64-bit unsigned integers                         */
 /*                                                                          */
-/* Convert an unsigned long to an ascii string, then do a protected         */
-/* concatenation.                                                           */
+/* NOTE: The buffer "s" MUST be at least "wid + 1" bytes long. A uint64_t   */
+/*       needs up to 20 chars.                                              */
 /*                                                                          */
-/* EXAMPLE: numzcat(my_buf, sizeof(my_buf), 123); // appends "123"          */
+/* EXAMPLE: fitoa64(bytes_total, 20, my_buffer);                            */
 /****************************************************************************/
-void numzcat(char *d, uint32_t n, size_t dsize) {
-    /* A 32-bit unsigned int (4294967295) is 10 digits max.
-     * We'll use a temporary width of 11 for fitoa to be safe.
-     * fitoa needs a buffer of width + 1, so b[12].
-     */
-    char b[12];
-    char *p;
-
-    /* 1. Convert the number, right-justified in an 11-char-wide field */
-    fitoa(n, 11, b);
-    
-    /* 2. Skip over the left-padding spaces to get the number itself */
-    for (p = b; *p == ' '; p++);
-    
-    /* 3. Safely concatenate the non-padded number string */
-    strzcat(d, p, dsize);
+void fitoa64(uint64_t n, size_t wid, char *s) {
+    aiu_fixed_field(n, wid, s);
+    s[wid] = '\0';
 }
 
 /****************************************************************************/
-/* decatoi() - convert ascii to integer (base 10)                           */
+/* fitoa_column() - format an array of numbers into fixed-width fields      */
 /*                                                                          */
-/* Convert string from decimal ascii to an integer value. String must       */
-/* contain only digits, and value must fit in a 64-bit integer.             */
+/* Writes "values[i]" right justified in "wid" chars at "s + i * stride",   */
+/* with the same space padding and '*' overflow fill as fitoa(). No nulls   */
+/* are written, so a column can be laid into a pre-built report row by      */
+/* passing the row length as "stride", or packed back to back with          */
+/* "stride" == "wid".                                                       */
 /*                                                                          */
-/* NOTE: Unlike atoi(), this function returns a 1/0 success code, and the   */
-/*       converted numeric value is returned via the "*value" argument.     */
+/* NOTE: "stride" must be >= "wid". The caller terminates the buffer.       */
 /*                                                                          */
-/* EXAMPLE: int RC = decatoi(strval, strlen(strval), &convertedVal);        */
+/* EXAMPLE: fitoa_column(counts, nrows, 8, report + col, line_len);         */
 /****************************************************************************/
-int decatoi(const char *string, size_t length, int64_t *value) {
-    char *eptr;
-    char str2conv[21];       /*LLONG_MIN is only 20 chars w/ minus sign */
-    int64_t result;
-    
-    /* FIX #1: Remove the 'length == 0' check to restore old behavior */
-    if (length > 20) return(0);
-    
-    /* FIX #2: Use strncpy, which was correct. 
-     * Cast 'length' to (int) to satisfy its old signature.
-     */
-    strncpy(str2conv, string, (int)length);
-    str2conv[length] = '\0';
-    
-    errno = 0;
-    result = strtoll(str2conv, &eptr, 10);
-    if (errno == EINVAL || errno == ERANGE) return(0);
-    if ((int)(eptr-str2conv) != (int)length) return(0); /* Cast length here, too */
-    if (*eptr != 0) return(0);
-    
-    *value = result;
-    return(1);
+void fitoa_column(const uint32_t *values, size_t count, size_t wid,
+                  char *s, size_t stride) {
+    size_t i;
+
+    for (i = 0; i < count; i++, s += stride) aiu_fixed_field(values[i], wid, s);
+}
+
+/* The 8 decimal digits of "n" < 100000000 as values 0..9, one per byte,    */
+/* most significant in the low byte. The halves, quarters and single        */
+/* digits are split off in parallel lanes by multiply-shift division, so    */
+/* no digit waits on the one before it                                      */
+static uint64_t aiu_digits8(uint32_t n) {
+    uint64_t x = (uint64_t)(n / 10000) | ((uint64_t)(n % 10000) << 32);
+    uint64_t q;
+
+    q = ((x * 10486) >> 20) & UINT64_C(0x0000007F0000007F);     /* / 100    */
+    x = q | ((x - q * 100) << 16);
+    q = ((x * 103) >> 10) & UINT64_C(0x000F000F000F000F);       /* / 10     */
+    return q | ((x - q * 10) << 8);
 }
 
 /****************************************************************************/
-/* hexatoi() - convert hexadecimal ascii to integer (base 16)               */
+/* fitoa_batch() - fitoa() over an array of values                          */
 /*                                                                          */
-/* Safely converts a string "string" of "length" to a 64-bit integer.       */
+/* Writes "values[i]" as a null terminated, right justified string of       */
+/* "wid" chars at "s + i * (wid + 1)", exactly as fitoa() would. If "rcs"   */
+/* is not NULL, "rcs[i]" is set to 1 if the value fit, or 0 if its field    */
+/* was filled with '*'.                                                     */
 /*                                                                          */
-/* NOTE: Unlike atoi(), this function returns a 1/0 success code, and the   */
+/* The digits of each value are produced 8 at a time by word arithmetic     */
+/* instead of a division per digit pair.                                    */
+/*                                                                          */
+/* NOTE: "s" MUST hold "count * (wid + 1)" bytes.                           */
+/*                                                                          */
+/* RETURNS: The number of values that fit in "wid" chars.                   */
+/*                                                                          */
+/* EXAMPLE: fitoa_batch(totals, n, 10, cells, NULL); // cell i at i * 11    */
+/****************************************************************************/
+size_t fitoa_batch(const uint32_t *values, size_t count, size_t wid,
+                   char *s, int *rcs) {
+    size_t i, ok = 0;
+
+    for (i = 0; i < count; i++, s += wid + 1) {
+        uint32_t n = values[i], top = n / 100000000;
+        uint64_t d = aiu_digits8(n % 100000000), pad = 0;
+        unsigned char field[10];        /* n in 10 chars, right justified   */
+        size_t len;
+
+        /* Digit count: from the top two digits, else from the first     */
+        /* nonzero byte of the low eight                                 */
+        if (top) len = top >= 10 ? 10 : 9;
+        else len = d ? 8 - aiu_ctz64(d) / 8 : 1;
+
+        if (len > wid) {
+            memset(s, '*', wid);
+            s[wid] = '\0';
+            if (rcs) rcs[i] = 0;
+            continue;
+        }
+
+        /* '0' + digit, except that leading zeros become ' ' ('0' - 0x10)  */
+        if (len < 8) {
+            pad = (UINT64_C(1) << (8 * (8 - len))) - 1;
+            pad &= UINT64_C(0x1010101010101010);
+        }
+        d += UINT64_C(0x3030303030303030) - pad;
+        field[0] = (unsigned char)(len == 10 ? aiu_digit_pairs[top * 2] : ' ');
+        field[1] = (unsigned char)(len >= 9 ? aiu_digit_pairs[top * 2 + 1] : ' ');
+
+        if (wid >= 10) {                /* the usual case: fixed stores     */
+            unsigned char *f = (unsigned char *)s + wid - 10;
+
+            if (wid > 10) memset(s, ' ', wid - 10);
+            f[0] = field[0];
+            f[1] = field[1];
+            aiu_store_le64(f + 2, d);
+        } else {
+            aiu_store_le64(field + 2, d);
+            memcpy(s, field + 10 - wid, wid);
+        }
+        s[wid] = '\0';
+        if (rcs) rcs[i] = 1;
+        ok++;
+    }
+    return ok;
+}
+
+/****************************************************************************/
+/* numzcat() - protected integer to string concatenation                    */
+/*                                                                          */
+/* Convert an unsigned long to an ascii string, then do a protected         */
+/* concatenation.                                                           */
+/*                                                                          */
+/* EXAMPLE: numzcat(my_buf, sizeof(my_buf), 123); // appends "123"          */
+/****************************************************************************/
+void numzcat(char *d, uint32_t n, size_t dsize) {
+    /* A 32-bit unsigned int (4294967295) is 10 digits max, plus a null */
+    char b[11];
+    size_t len = aiu_digits10(n);
+
+    b[len] = '\0';
+    aiu_put_digits(b + len, n);
+    strzcat(d, b, dsize);
+}
+
+/* strzcpy_n() itself, uncounted, for the functions built on it */
+static size_t aiu_copy_n(char *d, const char *s, size_t dsize, int *truncated) {
+    char *p = d;
+
+    if (dsize == 0) {                   /* no storage, nothing is written   */
+        if (truncated) *truncated = (*s != '\0');
+        return 0;
+    }
+#if defined(AIUTILS_SIMD)
+    size_t n = aiu_nul_scan(s, dsize - 1);
+    memcpy(p, s, n);
+    p += n, s += n;
+#else
+    while (*s && --dsize) *p++ = *s++;  /* copy at most dsize-1 characters  */
+#endif
+    *p = 0;                             /* null-terminate target string     */
+
+    if (truncated) *truncated = (*s != '\0');
+    return (size_t)(p - d);
+}
+
+/****************************************************************************/
+/* strzcpy_n() - protected string copy that reports what it did             */
+/*                                                                          */
+/* Same copy as strzcpy(), but returns the number of chars written to "d"   */
+/* (not counting the null) and sets "*truncated" to 1 if "s" did not fit,   */
+/* or 0 if it was copied whole. "truncated" may be NULL.                    */
+/*                                                                          */
+/* EXAMPLE: len = strzcpy_n(dest, src, sizeof(dest), &cut);                 */
+/****************************************************************************/
+size_t strzcpy_n(char *d, const char *s, size_t dsize, int *truncated) {
+#if defined(AIUTILS_STATS)
+    int cut;
+    size_t n = aiu_copy_n(d, s, dsize, &cut);
+
+    AIU_STAT(AIU_STAT_STRZCPY_N, n, cut);
+    if (truncated) *truncated = cut;
+    return n;
+#else
+    return aiu_copy_n(d, s, dsize, truncated);
+#endif
+}
+
+/****************************************************************************/
+/* strzcat_at() - protected concatenation at a known end offset             */
+/*                                                                          */
+/* Like strzcat(), but the caller passes the current length of "d" in       */
+/* "dlen" instead of having it rescanned, so a chain of appends costs       */
+/* O(total length) instead of O(n^2). Returns the new length of "d".        */
+/* "*truncated" is set as in strzcpy_n(); "truncated" may be NULL.          */
+/*                                                                          */
+/* EXAMPLE: len = strzcpy_n(line, name, sizeof(line), NULL);                */
+/*          len = strzcat_at(line, len, ",", sizeof(line), NULL);           */
+/****************************************************************************/
+size_t strzcat_at(char *d, size_t dlen, const char *s, size_t dsize,
+                  int *truncated) {
+    int cut;
+    size_t n;
+
+    if (dsize <= 1 || dlen >= dsize - 1) {  /* no room for even one char    */
+        AIU_STAT(AIU_STAT_STRZCAT_AT, 0, *s);
+        if (truncated) *truncated = (*s != '\0');
+        return dlen;
+    }
+    n = aiu_copy_n(d + dlen, s, dsize - dlen, &cut);
+    AIU_STAT(AIU_STAT_STRZCAT_AT, n, cut);
+    if (truncated) *truncated = cut;
+    return dlen + n;
+}
+
+/****************************************************************************/
+/* numzcat_at() - protected integer concatenation at a known end offset     */
+/*                                                                          */
+/* The strzcat_at() counterpart of numzcat(). Returns the new length.       */
+/*                                                                          */
+/* EXAMPLE: len = numzcat_at(line, len, 123, sizeof(line), NULL);           */
+/****************************************************************************/
+size_t numzcat_at(char *d, size_t dlen, uint32_t n, size_t dsize,
+                  int *truncated) {
+    char b[11];                         /* 10 digits max, plus a null       */
+    size_t len = aiu_digits10(n);
+
+    b[len] = '\0';
+    aiu_put_digits(b + len, n);
+    return strzcat_at(d, dlen, b, dsize, truncated);
+}
+
+/****************************************************************************/
+/* aiu_cursor_init() - start an append chain on a caller-supplied buffer    */
+/*                                                                          */
+/* The cursor remembers where the string ends, so every aiu_cursor_cat()    */
+/* and aiu_cursor_num() appends without rescanning. "buf" is emptied.       */
+/* "c->truncated" stays set once any append did not fit.                    */
+/*                                                                          */
+/* EXAMPLE: aiu_cursor cur;                                                 */
+/*          aiu_cursor_init(&cur, line, sizeof(line));                      */
+/*          aiu_cursor_cat(&cur, "id=");                                    */
+/*          aiu_cursor_num(&cur, id);                                       */
+/*          if (cur.truncated) { ... }                                      */
+/****************************************************************************/
+void aiu_cursor_init(aiu_cursor *c, char *buf, size_t size) {
+    c->buf = buf;
+    c->size = size;
+    c->len = 0;
+    c->truncated = 0;
+    if (size > 0) buf[0] = '\0';
+}
+
+/****************************************************************************/
+/* aiu_cursor_cat() - append a string at the cursor                         */
+/*                                                                          */
+/* RETURNS: The number of chars appended.                                   */
+/****************************************************************************/
+size_t aiu_cursor_cat(aiu_cursor *c, const char *s) {
+    int cut;
+    size_t old_len = c->len;
+
+    c->len = strzcat_at(c->buf, c->len, s, c->size, &cut);
+    c->truncated |= cut;
+    return c->len - old_len;
+}
+
+/****************************************************************************/
+/* aiu_cursor_num() - append an unsigned integer at the cursor              */
+/*                                                                          */
+/* RETURNS: The number of chars appended.                                   */
+/****************************************************************************/
+size_t aiu_cursor_num(aiu_cursor *c, uint32_t n) {
+    int cut;
+    size_t old_len = c->len;
+
+    c->len = numzcat_at(c->buf, c->len, n, c->size, &cut);
+    c->truncated |= cut;
+    return c->len - old_len;
+}
+
+/* Nonzero if all 8 bytes of "x" (from aiu_load_le64) are '0'..'9' */
+#define AIU_ALL_DEC8(x) \
+    (((x) & UINT64_C(0xF0F0F0F0F0F0F0F0)) == UINT64_C(0x3030303030303030) && \
+     (((x) + UINT64_C(0x0606060606060606)) & UINT64_C(0xF0F0F0F0F0F0F0F0)) \
+     == UINT64_C(0x3030303030303030))
+
+/* Value of 8 decimal digits (from aiu_load_le64), combined in 3 multiplies */
+static uint32_t aiu_dec8(uint64_t x) {
+    x = ((x & UINT64_C(0x0F0F0F0F0F0F0F0F)) * 2561) >> 8;
+    x = ((x & UINT64_C(0x00FF00FF00FF00FF)) * 6553601) >> 16;
+    x = ((x & UINT64_C(0x0000FFFF0000FFFF)) * UINT64_C(42949672960001)) >> 32;
+    return (uint32_t)x;
+}
+
+/****************************************************************************/
+/* decatoi() - convert ascii to integer (base 10)                           */
+/*                                                                          */
+/* Convert string from decimal ascii to an integer value. String must       */
+/* contain only digits, and value must fit in a 64-bit integer.             */
+/* Leading white space and one sign are accepted, exactly as strtoll()      */
+/* accepts them in the "C" locale, but no copy or libc call is made: the    */
+/* digits are parsed in place, 8 at a time where possible, and errno is     */
+/* left alone.                                                              */
+/*                                                                          */
+/* NOTE: Unlike atoi(), this function returns a 1/0 success code, and the   */
+/*       converted numeric value is returned via the "*value" argument.     */
+/*                                                                          */
+/* EXAMPLE: int RC = decatoi(strval, strlen(strval), &convertedVal);        */
+/****************************************************************************/
+int decatoi(const char *string, size_t length, int64_t *value) {
+    const unsigned char *p = (const unsigned char *)string;
+    const unsigned char *end = p + length;
+    uint64_t limit = INT64_MAX;     /* largest magnitude the sign allows    */
+    uint64_t mag = 0;
+    int neg = 0;
+
+    if (length > 20) return(0);     /* LLONG_MIN is only 20 chars w/ minus  */
+    if (length == 0) {              /* strtoll("") consumed all 0 chars     */
+        *value = 0;
+        return(1);
+    }
+
+    /* Same prefix strtoll() accepts: white space, then one optional sign */
+    while (p < end && (*p == ' ' || (*p >= '\t' && *p <= '\r'))) p++;
+    if (p < end && (*p == '+' || *p == '-')) {
+        neg = (*p == '-');
+        if (neg) limit = (uint64_t)INT64_MAX + 1;
+        p++;
+    }
+    if (p == end) return(0);        /* no digits at all                     */
+
+    /* 8 digits per step while they last; 16 of them can never overflow    */
+    while (end - p >= 8) {
+        uint64_t x = aiu_load_le64(p);
+        uint32_t chunk;
+
+        if (!AIU_ALL_DEC8(x)) break;
+        chunk = aiu_dec8(x);
+        if (mag > (limit - chunk) / 100000000) return(0);   /* overflow     */
+        mag = mag * 100000000 + chunk;
+        p += 8;
+    }
+
+    for (; p < end; p++) {
+        unsigned d = (unsigned)(*p - '0');
+
+        if (d > 9) return(0);       /* not a digit, or an embedded null     */
+        if (mag > (limit - d) / 10) return(0);              /* overflow     */
+        mag = mag * 10 + d;
+    }
+
+    *value = neg ? (int64_t)(0 - mag) : (int64_t)mag;
+    return(1);
+}
+
+/* A field of 1..16 chars as two little-endian words "hi" and "lo", right   */
+/* aligned and padded on the left with '0', so it decodes as 16 digits.     */
+/* From 8 chars up both words come from unaligned loads inside the field.   */
+static void aiu_field16(const unsigned char *p, size_t len, uint64_t *hi,
+                        uint64_t *lo) {
+    const uint64_t zeros = UINT64_C(0x3030303030303030);
+
+    if (len >= 8) {
+        *lo = aiu_load_le64(p + len - 8);
+        if (len == 8) *hi = zeros;
+        else *hi = (aiu_load_le64(p) << (8 * (16 - len)))
+                 | (len < 16 ? zeros >> (8 * (len - 8)) : 0);
+    } else {
+        unsigned char b[8];
+
+        memset(b, '0', 8);
+        memcpy(b + 8 - len, p, len);
+        *lo = aiu_load_le64(b);
+        *hi = zeros;
+    }
+}
+
+/****************************************************************************/
+/* decatoi_batch() - run decatoi() over an array of (ptr,len) fields        */
+/*                                                                          */
+/* Parses "count" fields into "values[]". If "rcs" is not NULL, the 1/0     */
+/* return code of each field is stored in "rcs[]". As with decatoi(), the   */
+/* value of a field that fails to parse is left untouched.                  */
+/*                                                                          */
+/* Fields of 1..16 plain digits (the common case in exported columns) are   */
+/* decoded as two 8-digit words with no per-digit branches; any other       */
+/* field goes through decatoi() itself, so the results are identical.       */
+/*                                                                          */
+/* RETURNS: The number of fields that parsed successfully.                  */
+/*                                                                          */
+/* EXAMPLE: ok = decatoi_batch(fields, nfields, vals, NULL);                */
+/****************************************************************************/
+size_t decatoi_batch(const aiu_str *fields, size_t count, int64_t *values,
+                     int *rcs) {
+    size_t i, ok = 0;
+
+    for (i = 0; i < count; i++) {
+        size_t len = fields[i].len;
+        int rc;
+
+        if (len - 1 < 16) {             /* 1..16 chars: try the word path   */
+            uint64_t hi, lo;
+
+            aiu_field16((const unsigned char *)fields[i].ptr, len, &hi, &lo);
+            if (AIU_ALL_DEC8(hi) && AIU_ALL_DEC8(lo)) {
+                values[i] = (int64_t)aiu_dec8(hi) * 100000000 + aiu_dec8(lo);
+                if (rcs) rcs[i] = 1;
+                ok++;
+                continue;
+            }
+        }
+        rc = decatoi(fields[i].ptr, len, &values[i]);
+        if (rcs) rcs[i] = rc;
+        ok += (size_t)rc;
+    }
+    return ok;
+}
+
+/****************************************************************************/
+/* octatoi() - convert octal ascii to integer (base 8)                      */
+/*                                                                          */
+/* Convert string from octal ascii to an integer value. Same rules as       */
+/* decatoi(): optional leading white space and one sign, then only the      */
+/* digits 0-7, and the value must fit in a 64-bit integer. A zero-length    */
+/* string parses as 0. Long inputs are decoded 8 digits per step.           */
+/*                                                                          */
+/* NOTE: Unlike atoi(), this function returns a 1/0 success code, and the   */
+/*       converted numeric value is returned via the "*value" argument.     */
+/*                                                                          */
+/* EXAMPLE: int RC = octatoi(strval, strlen(strval), &convertedVal);        */
+/****************************************************************************/
+int octatoi(const char *string, size_t length, int64_t *value) {
+    const unsigned char *p = (const unsigned char *)string;
+    const unsigned char *end = p + length;
+    uint64_t limit = INT64_MAX;     /* largest magnitude the sign allows    */
+    uint64_t mag = 0;
+    int neg = 0;
+
+    if (length > 23) return(0);     /* LLONG_MIN is only 23 chars w/ minus  */
+    if (length == 0) {
+        *value = 0;
+        return(1);
+    }
+
+    while (p < end && (*p == ' ' || (*p >= '\t' && *p <= '\r'))) p++;
+    if (p < end && (*p == '+' || *p == '-')) {
+        neg = (*p == '-');
+        if (neg) limit = (uint64_t)INT64_MAX + 1;
+        p++;
+    }
+    if (p == end) return(0);        /* no digits at all                     */
+
+    /* 8 digits (24 bits) per step while they last */
+    while (end - p >= 8) {
+        uint64_t x = aiu_load_be64(p);
+
+        if ((x & UINT64_C(0xF8F8F8F8F8F8F8F8)) != UINT64_C(0x3030303030303030))
+            break;                  /* not all '0'..'7', finish bytewise    */
+        x &= UINT64_C(0x0707070707070707);
+        x = (x | (x >> 5))  & UINT64_C(0x003F003F003F003F);
+        x = (x | (x >> 10)) & UINT64_C(0x00000FFF00000FFF);
+        x = (x | (x >> 20)) & UINT64_C(0x0000000000FFFFFF);
+
+        if (mag > (limit - x) >> 24) return(0);             /* overflow     */
+        mag = (mag << 24) | x;
+        p += 8;
+    }
+
+    for (; p < end; p++) {
+        unsigned d = (unsigned)(*p - '0');
+
+        if (d > 7) return(0);       /* not an octal digit                   */
+        if (mag > (limit - d) >> 3) return(0);              /* overflow     */
+        mag = (mag << 3) | d;
+    }
+
+    *value = neg ? (int64_t)(0 - mag) : (int64_t)mag;
+    return(1);
+}
+
+/* hexatoi() character classes: 0..15 is the digit value, the rest mark     */
+/* the chars the legacy parser also accepts, and everything else fails.     */
+#define AIU_HX_SP 0x10                  /* ' '                              */
+#define AIU_HX_MI 0x11                  /* '-'                              */
+#define AIU_HX_PL 0x12                  /* '+'                              */
+#define AIU_HX_XX 0x80                  /* anything else: failure           */
+
+#define SP AIU_HX_SP
+#define MI AIU_HX_MI
+#define PL AIU_HX_PL
+#define XX AIU_HX_XX
+static const unsigned char aiu_hex_class[256] = {
+    XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX,
+    XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX,
+    SP, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, PL, XX, MI, XX, XX,
+     0,  1,  2,  3,  4,  5,  6,  7,  8,  9, XX, XX, XX, XX, XX, XX,
+    XX, 10, 11, 12, 13, 14, 15, XX, XX, XX, XX, XX, XX, XX, XX, XX,
+    XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX,
+    XX, 10, 11, 12, 13, 14, 15, XX, XX, XX, XX, XX, XX, XX, XX, XX,
+    XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX,
+    XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX,
+    XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX,
+    XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX,
+    XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX,
+    XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX,
+    XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX,
+    XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX,
+    XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX,
+};
+#undef SP
+#undef MI
+#undef PL
+#undef XX
+
+/* Decode 8 chars already known to be hex digits into a 32-bit value */
+static uint64_t aiu_hex8(const unsigned char *p) {
+    uint64_t x = aiu_load_be64(p);
+
+    /* '0'-'9' keep their low nibble; 'A'-'F'/'a'-'f' have bit 6 set, +9 */
+    x = (x & UINT64_C(0x0F0F0F0F0F0F0F0F))
+      + ((x >> 6) & UINT64_C(0x0101010101010101)) * 9;
+
+    /* Squeeze the 8 nibbles together: pairs, then quads, then all 8 */
+    x = (x | (x >> 4))  & UINT64_C(0x00FF00FF00FF00FF);
+    x = (x | (x >> 8))  & UINT64_C(0x0000FFFF0000FFFF);
+    x = (x | (x >> 16)) & UINT64_C(0x00000000FFFFFFFF);
+    return x;
+}
+
+/****************************************************************************/
+/* hexatoi() - convert hexadecimal ascii to integer (base 16)               */
+/*                                                                          */
+/* Safely converts a string "string" of "length" to a 64-bit integer.       */
+/*                                                                          */
+/* NOTE: Unlike atoi(), this function returns a 1/0 success code, and the   */
 /*       converted numeric value is returned via the "*value" argument.     */
 /*                                                                          */
 /* EXAMPLE: if (hexatoi(str, strlen(str), &val)) { // use val }             */
@@ -177,430 +1360,2889 @@ int decatoi(const char *string, size_t length, int64_t *value) {
  * - Allows signs ('+', '-') and spaces to appear ANYWHERE in the
  * string, not just at the start.
  * - Fails if a non-hex, non-sign, non-space char is found (e.g., 'x').
+ *
+ * Each char is classified with one table lookup instead of a switch,
+ * and runs of 8 plain hex digits are decoded in a single step.
  */
 int hexatoi(const char *string, size_t length, int64_t *value) {
+    const unsigned char *p = (const unsigned char *)string;
+    uint64_t acc = 0;        /* unsigned, so shifting out high bits is safe */
     int retcode = 0;
     int sign = 0;
-    size_t i;
+    size_t i = 0;
 
     /* Initialize output value, per original logic */
     *value = 0;
 
-    /* Replicate the original 'while (length--)' loop */
-    for (i = 0; i < length; i++)
-    {
-        /* Replicate the original switch logic exactly */
-        switch (string[i])
-        {
-        case '0':
-        case '1':
-        case '2':
-        case '3':
-        case '4':
-        case '5':
-        case '6':
-        case '7':
-        case '8':
-        case '9':
-            *value = (*value << 4) | (string[i] - '0');
-            break;
-        case 'A':
-        case 'B':
-        case 'C':
-        case 'D':
-        case 'E':
-        case 'F':
-            *value = (*value << 4) | (string[i] + 10 - 'A');
-            break;
-        case 'a':
-        case 'b':
-        case 'c':
-        case 'd':
-        case 'e':
-        case 'f':
-            *value = (*value << 4) | (string[i] + 10 - 'a');
-            break;
-        case ' ':
+    /* Fast path: 8 plain hex digits (no sign, no space) per step */
+    while (length - i >= 8) {
+        unsigned char cls = aiu_hex_class[p[i]]     | aiu_hex_class[p[i + 1]]
+                          | aiu_hex_class[p[i + 2]] | aiu_hex_class[p[i + 3]]
+                          | aiu_hex_class[p[i + 4]] | aiu_hex_class[p[i + 5]]
+                          | aiu_hex_class[p[i + 6]] | aiu_hex_class[p[i + 7]];
+        if (cls > 15) break;            /* not all digits, finish bytewise  */
+        acc = (acc << 32) | aiu_hex8(p + i);
+        i += 8;
+    }
+
+    /* Replicate the original 'while (length--)' loop, one char at a time */
+    for (; i < length; i++) {
+        unsigned char cls = aiu_hex_class[p[i]];
+
+        if (cls < 16) {
+            acc = (acc << 4) | cls;
+            continue;
+        }
+        switch (cls) {
+        case AIU_HX_SP:
             retcode |= 4;
             break;
-        case '-':
+        case AIU_HX_MI:
             sign = -1;
             retcode |= 4;
             break;
-        case '+':
+        case AIU_HX_PL:
             sign = 1;
             retcode |= 4;
             break;
         default:
-            /* This is the FAILURE code, matching the original */
+            /* This is the FAILURE code, matching the original, which had  */
+            /* already stored the digits parsed so far into "*value"       */
+            *value = (int64_t)acc;
             return 1;
         }
     }
 
-    /* Apply the sign *after* parsing, matching the original */
-    if (sign == -1) {
-        *value = -(*value);
-    }
+    /* Apply the sign *after* parsing, matching the original */
+    if (sign == -1) acc = 0 - acc;
+    *value = (int64_t)acc;
+
+    /* This is the SUCCESS code, matching the original */
+    return retcode;
+}
+
+/* Nonzero if all 8 bytes of "x" are '0'-'9', 'A'-'F' or 'a'-'f'. Each      */
+/* range test adds a bias that carries into bit 7 of every byte at or past  */
+/* its bound; with bit 7 clear on input, no carry crosses into a neighbour. */
+static int aiu_all_hex8(uint64_t x) {
+    const uint64_t h = UINT64_C(0x8080808080808080);
+    const uint64_t k = UINT64_C(0x0101010101010101);
+    uint64_t lc = x | (k * 0x20);               /* fold A-F onto a-f        */
+    uint64_t digit = (x + k * 0x50) & ~(x + k * 0x46);      /* '0'..'9'     */
+    uint64_t alpha = (lc + k * 0x1F) & ~(lc + k * 0x19);    /* 'a'..'f'     */
+
+    return (x & h) == 0 && ((digit | alpha) & h) == h;
+}
+
+/* aiu_hex8() for a word from aiu_load_le64(), so p[0] is the low byte */
+static uint64_t aiu_hex8_le(uint64_t x) {
+    x = (x & UINT64_C(0x0F0F0F0F0F0F0F0F))
+      + ((x >> 6) & UINT64_C(0x0101010101010101)) * 9;
+
+    /* Pair up the nibbles, the earlier char of each pair on top */
+    x = ((x << 4) | (x >> 8))   & UINT64_C(0x00FF00FF00FF00FF);
+    x = ((x << 8) | (x >> 16))  & UINT64_C(0x0000FFFF0000FFFF);
+    x = ((x << 16) | (x >> 32)) & UINT64_C(0x00000000FFFFFFFF);
+    return x;
+}
+
+/****************************************************************************/
+/* hexatoi_batch() - run hexatoi() over an array of (ptr,len) fields        */
+/*                                                                          */
+/* Parses "count" fields into "values[]". If "rcs" is not NULL, the         */
+/* hexatoi() return code of each field (0 or 4 on success, 1 on failure)    */
+/* is stored in "rcs[]". Every "values[i]" is written, as hexatoi() does.   */
+/*                                                                          */
+/* Fields of 1..16 plain hex digits (IDs, hashes) are classified and        */
+/* decoded as two 8-char words with no per-char branches; any other field   */
+/* goes through hexatoi() itself, so the results are identical.             */
+/*                                                                          */
+/* RETURNS: The number of fields that parsed successfully.                  */
+/*                                                                          */
+/* EXAMPLE: ok = hexatoi_batch(ids, nids, vals, rcs);                       */
+/****************************************************************************/
+size_t hexatoi_batch(const aiu_str *fields, size_t count, int64_t *values,
+                     int *rcs) {
+    size_t i, ok = 0;
+
+    for (i = 0; i < count; i++) {
+        size_t len = fields[i].len;
+        int rc;
+
+        if (len - 1 < 16) {             /* 1..16 chars: try the word path   */
+            uint64_t hi, lo;
+
+            aiu_field16((const unsigned char *)fields[i].ptr, len, &hi, &lo);
+            if (aiu_all_hex8(hi) && aiu_all_hex8(lo)) {
+                values[i] = (int64_t)((aiu_hex8_le(hi) << 32) | aiu_hex8_le(lo));
+                if (rcs) rcs[i] = 0;
+                ok++;
+                continue;
+            }
+        }
+        rc = hexatoi(fields[i].ptr, len, &values[i]);
+        if (rcs) rcs[i] = rc;
+        ok += (size_t)(rc != 1);
+    }
+    return ok;
+}
+
+/* isspace() by table: 1 = C-locale white space, 2 = ask the locale (only   */
+/* bytes >= 0x80 can be locale white space beyond the C set), 0 = not       */
+#define S1 1
+#define LC 2
+static const unsigned char aiu_space_class[256] = {
+     0,  0,  0,  0,  0,  0,  0,  0,  0, S1, S1, S1, S1, S1,  0,  0,
+     0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+    S1,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+     0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+     0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+     0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+     0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+     0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+    LC, LC, LC, LC, LC, LC, LC, LC, LC, LC, LC, LC, LC, LC, LC, LC,
+    LC, LC, LC, LC, LC, LC, LC, LC, LC, LC, LC, LC, LC, LC, LC, LC,
+    LC, LC, LC, LC, LC, LC, LC, LC, LC, LC, LC, LC, LC, LC, LC, LC,
+    LC, LC, LC, LC, LC, LC, LC, LC, LC, LC, LC, LC, LC, LC, LC, LC,
+    LC, LC, LC, LC, LC, LC, LC, LC, LC, LC, LC, LC, LC, LC, LC, LC,
+    LC, LC, LC, LC, LC, LC, LC, LC, LC, LC, LC, LC, LC, LC, LC, LC,
+    LC, LC, LC, LC, LC, LC, LC, LC, LC, LC, LC, LC, LC, LC, LC, LC,
+    LC, LC, LC, LC, LC, LC, LC, LC, LC, LC, LC, LC, LC, LC, LC, LC,
+};
+#undef S1
+#undef LC
+
+#define AIU_ISSPACE(c) (aiu_space_class[(unsigned char)(c)] == 1 || \
+                        (aiu_space_class[(unsigned char)(c)] == 2 && \
+                         isspace((unsigned char)(c))))
+#define AIU_SPACES8 0x2020202020202020ULL   /* 8 blanks, as a word          */
+
+/****************************************************************************/
+/* trim_span() - trimmed view of a (ptr,len) span, without writing anything */
+/*                                                                          */
+/* mode is one of 'l', 'r', or 'b', as for trim_inplace(). White space is   */
+/* what isspace() accepts; runs of blanks (fixed-width padding) are skipped */
+/* a word at a time.                                                        */
+/*                                                                          */
+/* RETURNS: The trimmed sub-span of "s" (ptr may be "s" + n, len may be 0). */
+/*                                                                          */
+/* EXAMPLE: aiu_str name = trim_span(rec + 10, 20, 'b');                    */
+/****************************************************************************/
+aiu_str trim_span(const char *s, size_t len, char mode) {
+    aiu_str r;
+
+    r.ptr = s;
+    r.len = (s == NULL) ? 0 : len;
+
+    if (mode == 'l' || mode == 'b') {
+        while (r.len >= 8 && aiu_load_le64((const unsigned char *)r.ptr) == AIU_SPACES8) {
+            r.ptr += 8;
+            r.len -= 8;
+        }
+        while (r.len > 0 && AIU_ISSPACE(*r.ptr)) {
+            r.ptr++;
+            r.len--;
+        }
+    }
+    if (mode == 'r' || mode == 'b') {
+        while (r.len >= 8 && aiu_load_le64((const unsigned char *)r.ptr + r.len - 8) == AIU_SPACES8)
+            r.len -= 8;
+        while (r.len > 0 && AIU_ISSPACE(r.ptr[r.len - 1])) r.len--;
+    }
+    return r;
+}
+
+/****************************************************************************/
+/* trim_inplace() - in-place trim - leading, trailing, or both              */
+/* "s" must be modifiable, i.e., not a read-only string literal.            */
+/* mode is one of 'l', 'r', or 'b'                                          */
+/*                                                                          */
+/* EXAMPLE: trim_inplace(ctpr, 'r');                                        */
+/****************************************************************************/
+void trim_inplace(char *s, char mode) {
+    if (s == NULL) return;
+
+    s[trim_inplace_n(s, strlen(s), mode)] = '\0';
+}
+
+/****************************************************************************/
+/* trim_inplace_n() - trim_inplace() on the first "len" chars of "s"        */
+/*                                                                          */
+/* NOTE: "s" need not be null terminated, and nothing is written past the   */
+/*       returned length: add the null yourself if you need one.            */
+/*                                                                          */
+/* RETURNS: The trimmed length.                                             */
+/*                                                                          */
+/* EXAMPLE: len = trim_inplace_n(buf, len, 'b');                            */
+/****************************************************************************/
+size_t trim_inplace_n(char *s, size_t len, char mode) {
+    if (s == NULL) return 0;
+
+    /* Find the trimmed region first, so only what survives is moved */
+    aiu_str t = trim_span(s, len, mode);
+    if (t.ptr > s) memmove(s, t.ptr, t.len);
+    return t.len;
+}
+
+/****************************************************************************/
+/* trim_safe_copy() - Creates a trimmed copy of a string                    */
+/* mode: 'l' (left), 'r' (right), 'b' (both)                                */
+/*                                                                          */
+/* NOTE: This function writes to a buffer provided by the caller. This is an*/
+/*       intentional design choice to keep memory management (malloc/free)  */
+/*       at the caller's level to prevent memory leaks from a hidden malloc.*/
+/*                                                                          */
+/* EXAMPLE: trim_safe_copy(dest, src, sizeof(dest), 'b');                   */
+/****************************************************************************/
+void trim_safe_copy(char *dest, const char *src, 
+                    size_t dest_size, char mode) {
+    if (src == NULL || dest == NULL || dest_size == 0) {
+        if (dest != NULL && dest_size > 0) dest[0] = '\0';
+        return;
+    }
+
+    // 1. Find the trimmed region of the source, without touching it
+    aiu_str t = trim_span(src, strlen(src), mode);
+
+    // 2. Copy only that region, truncated to fit. A cut can expose white
+    //    space at the new end, so right-trim the copy once more
+    size_t n = t.len < dest_size - 1 ? t.len : dest_size - 1;
+    if (n < t.len && (mode == 'r' || mode == 'b')) {
+        while (n > 0 && AIU_ISSPACE(t.ptr[n - 1])) n--;
+    }
+    memcpy(dest, t.ptr, n);
+    dest[n] = '\0';
+    AIU_STAT(AIU_STAT_TRIM_COPY, n, n < t.len);
+}
+
+/****************************************************************************/
+/* remove_char_inplace() - remove a specified character from a string       */
+/*                                                                          */
+/* NOTE: "str" must be a modifiable string (e.g., an array or malloc'd).    */
+/*       Do NOT pass a string literal.                                      */
+/*                                                                          */
+/* EXAMPLE: remove_char_inplace(my_buffer, ' ');                            */
+/****************************************************************************/
+void remove_char_inplace(char *str, char char_to_remove) {
+    if (str == NULL) return;
+
+    // Null-terminate the modified string
+    str[remove_char_inplace_n(str, strlen(str), char_to_remove)] = '\0';
+}
+
+/****************************************************************************/
+/* remove_char_inplace_n() - remove_char_inplace() on "len" chars of "str"  */
+/*                                                                          */
+/* NOTE: Nothing is written past the returned length.                       */
+/*                                                                          */
+/* RETURNS: The new length.                                                 */
+/*                                                                          */
+/* EXAMPLE: len = remove_char_inplace_n(buf, len, ' ');                     */
+/****************************************************************************/
+size_t remove_char_inplace_n(char *str, size_t len, char char_to_remove) {
+    if (str == NULL) return 0;
+
+    /* Nothing moves until the first match, so find that with memchr */
+    char *hit = (char *)memchr(str, (unsigned char)char_to_remove, len);
+    if (hit == NULL) return len;
+
+    size_t i, j = (size_t)(hit - str);
+    for (i = j + 1; i < len; i++) {
+        if (str[i] != char_to_remove) str[j++] = str[i];
+    }
+    return j;
+}
+
+/****************************************************************************/
+/* replace_char_inplace() - replace all instances of a char in-place        */
+/*                                                                          */
+/* NOTE: "str" must be a modifiable string (e.g., an array or malloc'd).    */
+/*                                                                          */
+/* EXAMPLE: replace_char_inplace(my_buffer, ' ', '_', 0);                   */
+/****************************************************************************/
+void replace_char_inplace(char *str, char ch, char newch, int skipends) {
+    if (str == NULL) return;
+
+    /* No need to re-terminate; length doesn't change */
+    replace_char_inplace_n(str, strlen(str), ch, newch, skipends);
+}
+
+/****************************************************************************/
+/* replace_char_inplace_n() - replace_char_inplace() on "len" chars         */
+/*                                                                          */
+/* EXAMPLE: replace_char_inplace_n(field.ptr, field.len, ' ', '_', 0);      */
+/****************************************************************************/
+void replace_char_inplace_n(char *str, size_t len, char ch, char newch, int skipends) {
+    if (str == NULL || len == 0) return;
+
+    size_t i;
+    size_t last_index = len - 1;
+
+    for(i = 0; i < len; i++) {
+       if(str[i] == ch && !(skipends && (i == 0 || i == last_index))) 
+         str[i] = newch;
+    }
+}
+
+/****************************************************************************/
+/* replace_char_safe_copy() - safely copy a string, replacing a char        */
+/*                                                                          */
+/* Safely copies 'src' to 'dest', replacing 'ch' with 'newch'.              */
+/*                                                                          */
+/* EXAMPLE: replace_char_safe_copy(dest, src, sizeof(dest), ' ', '_', 0);   */
+/****************************************************************************/
+void replace_char_safe_copy(char *dest, const char *src, size_t dest_size, 
+                            char ch, char newch, int skipends) {
+    if (dest == NULL || src == NULL || dest_size == 0) {
+        if (dest_size > 0) dest[0] = '\0';
+        return;
+    }
+
+    // 1. Safely copy the string using our standard utility
+    int cut;
+    size_t n = aiu_copy_n(dest, src, dest_size, &cut);
+
+    // 2. Perform the replacement on the new, safe copy
+    replace_char_inplace_n(dest, n, ch, newch, skipends);
+    AIU_STAT(AIU_STAT_REPLACE_COPY, n, cut);
+}
+
+/****************************************************************************/
+/* replace_char_safe_copy_n() - replace_char_safe_copy() from a span        */
+/*                                                                          */
+/* Copies at most "src_len" chars of "src" (truncated to fit) and always    */
+/* null terminates "dest". "skipends" refers to the ends of the copy.       */
+/*                                                                          */
+/* RETURNS: The length of "dest".                                           */
+/*                                                                          */
+/* EXAMPLE: replace_char_safe_copy_n(dest, tok.ptr, tok.len, sizeof(dest),  */
+/*                                   ' ', '_', 0);                          */
+/****************************************************************************/
+size_t replace_char_safe_copy_n(char *dest, const char *src, size_t src_len,
+                                size_t dest_size, char ch, char newch, int skipends) {
+    if (dest == NULL || src == NULL || dest_size == 0) {
+        if (dest != NULL && dest_size > 0) dest[0] = '\0';
+        return 0;
+    }
+
+    size_t n = src_len < dest_size - 1 ? src_len : dest_size - 1;
+    memcpy(dest, src, n);
+    dest[n] = '\0';
+    replace_char_inplace_n(dest, n, ch, newch, skipends);
+    AIU_STAT(AIU_STAT_REPLACE_COPY, n, n < src_len);
+    return n;
+}
+
+/* Nonzero if byte "c" is deleted by "cm" */
+#define AIU_CHARMAP_DEL(cm, c) (((cm)->del[(c) >> 5] >> ((c) & 31)) & 1)
+
+/****************************************************************************/
+/* aiu_charmap_compile() - build a one-pass replace/delete table            */
+/*                                                                          */
+/* Every char of "from" is replaced by the char at the same index of "to"   */
+/* (later pairs win), and every char of "del" is removed (deletion wins     */
+/* over replacement). Either may be NULL. Compile once, then apply it to    */
+/* any number of buffers with aiu_translate_inplace()/aiu_translate_copy(). */
+/*                                                                          */
+/* RETURNS: 1 on success, 0 if "from" and "to" differ in length.            */
+/*                                                                          */
+/* EXAMPLE: aiu_charmap cm;                                                 */
+/*          aiu_charmap_compile(&cm, "\t,", "  ", "\r\"");                  */
+/*          len = aiu_translate_inplace(&cm, field, len, 0);                */
+/****************************************************************************/
+int aiu_charmap_compile(aiu_charmap *cm, const char *from, const char *to,
+                        const char *del) {
+    size_t i, n;
+    int c;
+
+    if (cm == NULL) return 0;
+    if ((from ? strlen(from) : 0) != (to ? strlen(to) : 0)) return 0;
+
+    for (c = 0; c < 256; c++) cm->map[c] = (unsigned char)c;
+    memset(cm->del, 0, sizeof(cm->del));
+    for (i = 0, n = from ? strlen(from) : 0; i < n; i++)
+        cm->map[(unsigned char)from[i]] = (unsigned char)to[i];
+    for (; del && *del; del++) {
+        c = (unsigned char)*del;
+        cm->del[c >> 5] |= (uint32_t)1 << (c & 31);
+    }
+
+    /* The bytes that change at all, for the block path */
+    cm->count = 0;
+    cm->deletes = 0;
+    for (c = 0; c < 256; c++) {
+        int gone = AIU_CHARMAP_DEL(cm, c);
+        if (!gone && cm->map[c] == c) continue;
+        if (cm->count < 8) cm->list[cm->count] = (unsigned char)c;
+        cm->count++;
+        cm->deletes |= gone;
+    }
+    return 1;
+}
+
+/* Translate s[0..n) into d[0..cap); d may be s (it never gets ahead of     */
+/* the reads). Returns chars written; "*used" gets the chars consumed.      */
+static size_t aiu_translate_run(const aiu_charmap *cm, char *d, size_t cap,
+                                const char *s, size_t n, size_t *used) {
+    const unsigned char *src = (const unsigned char *)s;
+    unsigned char *dst = (unsigned char *)d;
+    size_t i = 0, j = 0;
+
+#if defined(AIUTILS_SIMD) && (defined(AIU_HAVE_SSE2) || defined(AIU_HAVE_NEON))
+    /* Up to 8 changed bytes: compare and blend 16 bytes per step. Blocks  */
+    /* with a deletion in them drop to the byte loop.                      */
+    if (cm->count > 0 && cm->count <= 8 && n >= 16 && AIU_VECTOR_ON()) {
+        int k, nl = cm->count;
+#if defined(AIU_HAVE_SSE2)
+        __m128i from[8], to[8];
+
+        for (k = 0; k < nl; k++) {
+            from[k] = _mm_set1_epi8((char)cm->list[k]);
+            to[k] = _mm_set1_epi8((char)cm->map[cm->list[k]]);
+        }
+        while (i + 16 <= n && j + 16 <= cap) {
+            __m128i v = _mm_loadu_si128((const __m128i *)(src + i));
+            __m128i out = v, hit = _mm_setzero_si128();
+
+            for (k = 0; k < nl; k++) {
+                __m128i eq = _mm_cmpeq_epi8(v, from[k]);
+                hit = _mm_or_si128(hit, eq);
+                out = _mm_or_si128(_mm_andnot_si128(eq, out), _mm_and_si128(eq, to[k]));
+            }
+            if (_mm_movemask_epi8(hit) == 0 || !cm->deletes) {
+                if (dst + j != src + i || _mm_movemask_epi8(hit))
+                    _mm_storeu_si128((__m128i *)(dst + j), out);
+                i += 16;
+                j += 16;
+                continue;
+            }
+#else
+        uint8x16_t from[8], to[8];
+
+        for (k = 0; k < nl; k++) {
+            from[k] = vdupq_n_u8(cm->list[k]);
+            to[k] = vdupq_n_u8(cm->map[cm->list[k]]);
+        }
+        while (i + 16 <= n && j + 16 <= cap) {
+            uint8x16_t v = vld1q_u8(src + i);
+            uint8x16_t out = v, hit = vdupq_n_u8(0);
+
+            for (k = 0; k < nl; k++) {
+                uint8x16_t eq = vceqq_u8(v, from[k]);
+                hit = vorrq_u8(hit, eq);
+                out = vbslq_u8(eq, to[k], out);
+            }
+            if (aiu_neon_mask(hit) == 0 || !cm->deletes) {
+                if (dst + j != src + i || aiu_neon_mask(hit)) vst1q_u8(dst + j, out);
+                i += 16;
+                j += 16;
+                continue;
+            }
+#endif
+            for (k = 0; k < 16; k++, i++) {
+                unsigned char c = src[i];
+                if (!AIU_CHARMAP_DEL(cm, c)) dst[j++] = cm->map[c];
+            }
+        }
+    }
+#endif
+
+    if (!cm->deletes) {                 /* pure replacement: 1 in, 1 out   */
+        size_t m = (n - i < cap - j) ? n - i : cap - j;
+        for (; m; m--) dst[j++] = cm->map[src[i++]];
+    }
+    for (; i < n && j < cap; i++) {
+        unsigned char c = src[i];
+        if (!AIU_CHARMAP_DEL(cm, c)) dst[j++] = cm->map[c];
+    }
+    *used = i;
+    return j;
+}
+
+/****************************************************************************/
+/* aiu_translate_inplace() - apply an aiu_charmap to "len" chars, in place  */
+/*                                                                          */
+/* One pass replaces and deletes every char in the map. With "skipends"     */
+/* set, the first and last chars are left alone, as in                      */
+/* replace_char_inplace().                                                  */
+/*                                                                          */
+/* NOTE: "s" need not be null terminated, and nothing is written past the   */
+/*       returned length.                                                   */
+/*                                                                          */
+/* RETURNS: The new length.                                                 */
+/*                                                                          */
+/* EXAMPLE: len = aiu_translate_inplace(&cm, buf, len, 0);                  */
+/****************************************************************************/
+size_t aiu_translate_inplace(const aiu_charmap *cm, char *s, size_t len,
+                             int skipends) {
+    size_t used, j = 0, first = 0, last = len;
+
+    if (cm == NULL || s == NULL || len == 0) return (s == NULL) ? 0 : len;
+
+    if (skipends) {                     /* s[0] and s[len-1] stay as is     */
+        j = first = 1;
+        if (len > 1) last = len - 1;
+    }
+    if (first < last) j += aiu_translate_run(cm, s + j, last - first, s + first,
+                                             last - first, &used);
+    if (last < len) s[j++] = s[last];
+    return j;
+}
+
+/****************************************************************************/
+/* aiu_translate_copy() - apply an aiu_charmap while copying a span         */
+/*                                                                          */
+/* Copies "src_len" chars of "src" through the map into "dest", truncated   */
+/* to fit. "dest" is always null terminated. With "skipends" set, the first */
+/* and last chars of "src" are copied unchanged.                            */
+/*                                                                          */
+/* RETURNS: The length of "dest".                                           */
+/*                                                                          */
+/* EXAMPLE: aiu_translate_copy(&cm, dest, tok.ptr, tok.len,                 */
+/*                             sizeof(dest), 0);                            */
+/****************************************************************************/
+size_t aiu_translate_copy(const aiu_charmap *cm, char *dest, const char *src,
+                          size_t src_len, size_t dest_size, int skipends) {
+    size_t used = 0, j = 0, cap, first = 0, last = src_len;
+
+    if (dest == NULL || dest_size == 0) return 0;
+    if (cm == NULL || src == NULL) {
+        dest[0] = '\0';
+        return 0;
+    }
+
+    cap = dest_size - 1;
+    if (skipends && src_len > 0) {
+        if (cap > 0) dest[j++] = src[0];
+        first = 1;
+        if (src_len > 1) last = src_len - 1;
+    }
+    if (first < last && j < cap)
+        j += aiu_translate_run(cm, dest + j, cap - j, src + first, last - first, &used);
+    if (last < src_len && first + used == last && j < cap) dest[j++] = src[last];
+    dest[j] = '\0';
+    return j;
+}
+
+/****************************************************************************/
+/* substring_safe_copy() - Safely copies a substring from "src" into "dest" */
+/*                                                                          */
+/* NOTE: This function writes to a buffer provided by the caller, just like */
+/*       just like strzcpy() and trim_safe_copy().                          */
+/*                                                                          */
+/* EXAMPLE: substring_safe_copy(dest, src, sizeof(dest), 5, 10);            */
+/****************************************************************************/
+void substring_safe_copy(char *dest, const char *src, size_t dest_size,
+                         size_t position, size_t length) {
+    /* --- 1. Handle Nulls and Empty Buffer --- */
+    if (dest == NULL || src == NULL || dest_size == 0) {
+        if (dest != NULL && dest_size > 0) dest[0] = '\0';
+        return;
+    }
+
+    /* Nothing past position + min(length, dest_size - 1) can be copied,  */
+    /* so look for the terminator only that far instead of strlen()'ing   */
+    /* the whole (possibly huge) source                                    */
+    size_t want = (length < dest_size - 1) ? length : dest_size - 1;
+    size_t bound = (position > SIZE_MAX - want) ? SIZE_MAX : position + want;
+    const char *nul = (const char *)memchr(src, '\0', bound);
+    size_t src_len = nul ? (size_t)(nul - src) : bound;
+
+    /* --- 2. Check if start position is out-of-bounds --- */
+    if (position >= src_len) {
+        dest[0] = '\0'; /* Start is past the end, just return empty */
+        return;
+    }
+
+    /* --- 3. Calculate a 100% safe copy length --- */
+    /* a) How many chars are available from the start position? */
+    size_t chars_available = src_len - position;
+
+    /* b) We can only copy the *smaller* of the requested length
+          and the available chars. */
+    size_t copy_len = (length < chars_available) ? length : chars_available;
+
+    /* c) We can only copy the *smaller* of *that* length
+          and the destination buffer size (minus 1 for null). */
+    size_t max_dest_copy = dest_size - 1;
+    if (copy_len > max_dest_copy) copy_len = max_dest_copy;
+
+    /* --- 4. Perform the copy --- */
+    /* This is the *other* correct and safe use of strncpy:
+       copying a specific-length slice from a buffer. */
+    strncpy(dest, src + position, copy_len);
+    dest[copy_len] = '\0';
+    AIU_STAT(AIU_STAT_SUBSTRING, copy_len, copy_len < length && src[position + copy_len]);
+}
+
+/****************************************************************************/
+/* substring_safe_copy_n() - substring_safe_copy() from a span              */
+/*                                                                          */
+/* "src" holds "src_len" chars and need not be null terminated. "dest" is   */
+/* always null terminated.                                                  */
+/*                                                                          */
+/* RETURNS: The number of chars copied (the length of "dest").              */
+/*                                                                          */
+/* EXAMPLE: substring_safe_copy_n(dest, line.ptr, line.len, sizeof(dest),   */
+/*                                5, 10);                                   */
+/****************************************************************************/
+size_t substring_safe_copy_n(char *dest, const char *src, size_t src_len,
+                             size_t dest_size, size_t position, size_t length) {
+    if (dest == NULL || src == NULL || dest_size == 0) {
+        if (dest != NULL && dest_size > 0) dest[0] = '\0';
+        return 0;
+    }
+    if (position >= src_len) {
+        dest[0] = '\0';
+        return 0;
+    }
+
+    size_t copy_len = src_len - position;
+    if (copy_len > length) copy_len = length;
+    if (copy_len > dest_size - 1) copy_len = dest_size - 1;
+
+    memcpy(dest, src + position, copy_len);
+    dest[copy_len] = '\0';
+    AIU_STAT(AIU_STAT_SUBSTRING, copy_len, copy_len < length && copy_len < src_len - position);
+    return copy_len;
+}
+
+/****************************************************************************/
+/* aiu_slice_copy() - copy many (position,length) slices of one record      */
+/*                                                                          */
+/* Copies "slices[i]" of the "src_len" chars at "src" into its "dest", in   */
+/* one pass over the table, with the clamping rules of                      */
+/* substring_safe_copy_n(): a slice that starts past the end is empty, it   */
+/* stops at the end of the record, and it is cut to "dest_size - 1". Every  */
+/* "dest" with room is null terminated; a slice with a NULL "dest" or a     */
+/* zero "dest_size" is skipped. The length of the record is given once, so  */
+/* nothing is scanned, and the table can be reused for every record.        */
+/*                                                                          */
+/* If "lens" is not NULL, "lens[i]" gets the number of chars copied.        */
+/*                                                                          */
+/* RETURNS: The number of slices cut short by "dest_size" (0 if all fit).   */
+/*                                                                          */
+/* EXAMPLE: aiu_slice f[] = { { 0, 8, acct, sizeof(acct) },                 */
+/*                            { 8, 30, name, sizeof(name) } };              */
+/*          for (rec = buf; rec + 80 <= end; rec += 80)                     */
+/*              aiu_slice_copy(rec, 80, f, 2, NULL);                        */
+/****************************************************************************/
+size_t aiu_slice_copy(const char *src, size_t src_len, const aiu_slice *slices,
+                      size_t count, size_t *lens) {
+    size_t i, cut = 0;
+
+    for (i = 0; i < count; i++) {
+        const aiu_slice *sl = &slices[i];
+        size_t avail = sl->position < src_len ? src_len - sl->position : 0;
+        size_t n = avail < sl->length ? avail : sl->length;
+
+        if (sl->dest == NULL || sl->dest_size == 0) {
+            if (lens) lens[i] = 0;
+            continue;
+        }
+        if (n > sl->dest_size - 1) {
+            n = sl->dest_size - 1;
+            cut++;
+        }
+        if (n) memcpy(sl->dest, src + sl->position, n);
+        sl->dest[n] = '\0';
+        if (lens) lens[i] = n;
+        AIU_STAT(AIU_STAT_SUBSTRING, n, n < avail && n < sl->length);
+    }
+    return cut;
+}
+
+/****************************************************************************/
+/* aiu_slice_spans() - aiu_slice_copy() without the copy                    */
+/*                                                                          */
+/* Stores each slice of the record as a span into "src" in "spans[i]",      */
+/* clamped to the record as aiu_slice_copy() does (an empty span points at  */
+/* the end of the record). "dest" and "dest_size" are ignored.              */
+/*                                                                          */
+/* RETURNS: The number of non-empty spans.                                  */
+/*                                                                          */
+/* EXAMPLE: aiu_slice_spans(rec, 80, f, 2, cols);                           */
+/****************************************************************************/
+size_t aiu_slice_spans(const char *src, size_t src_len, const aiu_slice *slices,
+                       size_t count, aiu_str *spans) {
+    size_t i, nonempty = 0;
+
+    for (i = 0; i < count; i++) {
+        size_t pos = slices[i].position < src_len ? slices[i].position : src_len;
+        size_t n = src_len - pos;
+
+        if (n > slices[i].length) n = slices[i].length;
+        spans[i].ptr = src + pos;
+        spans[i].len = n;
+        nonempty += (n != 0);
+    }
+    return nonempty;
+}
+
+/****************************************************************************/
+/* strcasestr() - case-insensitive string search (replaces strstr)          */
+/*                                                                          */
+/* Finds the first occurrence of "needle" in "haystack", ignoring case.     */
+/* Built on aiu_casesearch_compile()/aiu_casesearch_find() below, which     */
+/* are available on every platform.                                         */
+/*                                                                          */
+/* EXAMPLE: const char *p = strcasestr("Hello World", "world"); // p points to "World" */
+/****************************************************************************/
+#if defined(_WIN32) || defined(_MSC_VER)
+const char *strcasestr(const char *haystack, const char *needle) {
+    aiu_casesearch cs;
+
+    if (!aiu_casesearch_compile(&cs, needle) || haystack == NULL) return NULL;
+    return aiu_casesearch_find(&cs, haystack, strlen(haystack));
+}
+#endif
+
+/****************************************************************************/
+/* aiu_casesearch_compile() - prepare a needle for repeated searches        */
+/*                                                                          */
+/* Builds a case-folded Horspool skip table for "needle" once, so that      */
+/* aiu_casesearch_find() can run it against many haystacks. Case folding    */
+/* follows toupper(), like strcasestr(), in the locale current at compile.  */
+/*                                                                          */
+/* NOTE: The object keeps a pointer to "needle", it does not copy it; the   */
+/*       needle must stay valid for as long as the object is used.          */
+/*                                                                          */
+/* RETURNS: 1 on success, 0 if "cs" or "needle" is NULL.                    */
+/*                                                                          */
+/* EXAMPLE: aiu_casesearch cs;                                              */
+/*          aiu_casesearch_compile(&cs, "content-length");                  */
+/*          p = aiu_casesearch_find(&cs, line, line_len);                   */
+/****************************************************************************/
+int aiu_casesearch_compile(aiu_casesearch *cs, const char *needle) {
+    size_t i, m;
+
+    if (cs == NULL || needle == NULL) return 0;
+
+    m = strlen(needle);
+    cs->needle = needle;
+    cs->len = m;
+
+    for (i = 0; i < 256; i++) {
+        cs->fold[i] = (unsigned char)AIU_TOUPPER((char)i);
+        cs->skip[i] = m;
+    }
+    for (i = 0; i + 1 < m; i++)         /* last char keeps the full shift   */
+        cs->skip[cs->fold[(unsigned char)needle[i]]] = m - 1 - i;
+
+    /* The block filter needs every byte that folds to the needle's first  */
+    /* and last char; it is only used when there are at most 2 of each.    */
+    cs->filter = 0;
+    if (m > 0) {
+        unsigned char f = cs->fold[(unsigned char)needle[0]];
+        unsigned char l = cs->fold[(unsigned char)needle[m - 1]];
+        int nf = 0, nl = 0;
+
+        for (i = 0; i < 256; i++) {
+            if (cs->fold[i] == f && nf++ < 2) cs->first[nf - 1] = (unsigned char)i;
+            if (cs->fold[i] == l && nl++ < 2) cs->last[nl - 1] = (unsigned char)i;
+        }
+        if (nf == 1) cs->first[1] = cs->first[0];
+        if (nl == 1) cs->last[1] = cs->last[0];
+        cs->filter = (nf <= 2 && nl <= 2);
+    }
+    return 1;
+}
+
+/* Nonzero if the "m" chars at "h" case-fold to the compiled needle */
+static int aiu_casesearch_match(const aiu_casesearch *cs,
+                                const unsigned char *h, size_t m) {
+    const unsigned char *n = (const unsigned char *)cs->needle;
+
+    while (m--) if (cs->fold[h[m]] != cs->fold[n[m]]) return 0;
+    return 1;
+}
+
+/****************************************************************************/
+/* aiu_casesearch_find() - find a compiled needle in "len" chars of "hay"   */
+/*                                                                          */
+/* "hay" need not be null terminated. With AIUTILS_SIMD (SSE2 or NEON), 16  */
+/* positions at a time are checked against the needle's first and last      */
+/* char before any full compare; otherwise (and for the tail) Horspool      */
+/* skipping is used.                                                        */
+/*                                                                          */
+/* RETURNS: A pointer to the first match in "hay", or NULL if none.         */
+/*          An empty needle matches at "hay".                               */
+/****************************************************************************/
+const char *aiu_casesearch_find(const aiu_casesearch *cs, const char *hay,
+                                size_t len) {
+    const unsigned char *h = (const unsigned char *)hay;
+    size_t m, pos = 0;
+
+    if (cs == NULL || hay == NULL) return NULL;
+    m = cs->len;
+    if (m == 0) return hay;
+    if (m > len) return NULL;
+
+#if defined(AIUTILS_SIMD) && defined(AIU_HAVE_SSE2)
+    if (cs->filter && len >= m + 15 && AIU_VECTOR_ON()) {
+        const __m128i f0 = _mm_set1_epi8((char)cs->first[0]);
+        const __m128i f1 = _mm_set1_epi8((char)cs->first[1]);
+        const __m128i l0 = _mm_set1_epi8((char)cs->last[0]);
+        const __m128i l1 = _mm_set1_epi8((char)cs->last[1]);
+
+        for (; pos + m + 15 <= len; pos += 16) {
+            __m128i a = _mm_loadu_si128((const __m128i *)(h + pos));
+            __m128i b = _mm_loadu_si128((const __m128i *)(h + pos + m - 1));
+            __m128i hit = _mm_and_si128(
+                _mm_or_si128(_mm_cmpeq_epi8(a, f0), _mm_cmpeq_epi8(a, f1)),
+                _mm_or_si128(_mm_cmpeq_epi8(b, l0), _mm_cmpeq_epi8(b, l1)));
+            uint32_t mask = (uint32_t)_mm_movemask_epi8(hit);
+
+            while (mask) {
+                size_t at = pos + aiu_ctz32(mask);
+                if (aiu_casesearch_match(cs, h + at, m)) return hay + at;
+                mask &= mask - 1;
+            }
+        }
+    }
+#elif defined(AIUTILS_SIMD) && defined(AIU_HAVE_NEON)
+    if (cs->filter) {
+        const uint8x16_t f0 = vdupq_n_u8(cs->first[0]);
+        const uint8x16_t f1 = vdupq_n_u8(cs->first[1]);
+        const uint8x16_t l0 = vdupq_n_u8(cs->last[0]);
+        const uint8x16_t l1 = vdupq_n_u8(cs->last[1]);
+
+        for (; pos + m + 15 <= len; pos += 16) {
+            uint8x16_t a = vld1q_u8(h + pos);
+            uint8x16_t b = vld1q_u8(h + pos + m - 1);
+            uint8x16_t hit = vandq_u8(vorrq_u8(vceqq_u8(a, f0), vceqq_u8(a, f1)),
+                                      vorrq_u8(vceqq_u8(b, l0), vceqq_u8(b, l1)));
+            uint64_t mask = aiu_neon_mask(hit);     /* 4 bits per position  */
+
+            while (mask) {
+                size_t at = pos + aiu_ctz64(mask) / 4;
+                if (aiu_casesearch_match(cs, h + at, m)) return hay + at;
+                mask &= ~(UINT64_C(0xF) << (aiu_ctz64(mask) & ~3u));
+            }
+        }
+    }
+#endif
+
+    /* Horspool: shift by the skip of the folded char under the window end */
+    while (pos + m <= len) {
+        if (aiu_casesearch_match(cs, h + pos, m)) return hay + pos;
+        pos += cs->skip[cs->fold[h[pos + m - 1]]];
+    }
+    return NULL;
+}
+
+/****************************************************************************/
+/* safe_gets() - safe line reader that strips the newline (replaces fgets)  */
+/*                                                                          */
+/* RETURNS: The "buf" pointer on success, or NULL on EOF or error.          */
+/*                                                                          */
+/* EXAMPLE: char line[100];                                                 */
+/*          if (safe_gets(line, sizeof(line), stdin) != NULL) { ... }       */
+/****************************************************************************/
+char *safe_gets(char *buf, size_t buf_size, FILE *stream) {
+    if (buf == NULL || buf_size == 0 || stream == NULL) return NULL;
+
+    /* 1. Read the line using fgets */
+    if (fgets(buf, (int)buf_size,stream) == NULL) return NULL; /* Error/EOF */
+
+    /* 2. Find and remove the newline character
+     * strcspn() finds the index of the first '\n' or '\r'.
+     * This is a safe way to find the end of the line.
+     */
+    size_t len = strcspn(buf, "\r\n");
+    AIU_STAT(AIU_STAT_SAFE_GETS, len, len == buf_size - 1 && buf[len] == '\0');
+    buf[len] = '\0';
+
+    /* 3. Handle a potential buffer-fill edge case
+     * If len == buf_size - 1 AND the last char isn't '\0' (from
+     * our strip), it means fgets() stopped *because the buffer
+     * was full* and the newline is still in the input stream.
+     * We must clear it to prevent it from being read by the
+     * *next* call to safe_gets().
+     */
+    if (len == buf_size - 1 && buf[len] != '\0') {
+        int ch;
+        while ((ch = fgetc(stream)) != '\n' && ch != EOF);
+    }
+
+    return buf;
+}
+
+/****************************************************************************/
+/* aiu_linereader_init() - start a buffered, block-at-a-time line reader    */
+/*                                                                          */
+/* A faster safe_gets() for big files: "stream" is read in blocks of        */
+/* "buf_size" bytes (64 KB - 1 MB works well) into the caller's "buf", and  */
+/* aiu_linereader_next() hands out each line as a (ptr,len) span inside     */
+/* that buffer, with no per-line fgets() call or copy.                      */
+/*                                                                          */
+/* NOTE: Like the rest of this library, no memory is allocated; "buf" is    */
+/*       owned by the caller and must outlive the reader.                   */
+/*                                                                          */
+/* RETURNS: 1 on success, 0 if an argument is NULL or "buf_size" is 0.      */
+/*                                                                          */
+/* EXAMPLE: static char block[1 << 20];                                     */
+/*          aiu_linereader lr;                                              */
+/*          aiu_str line;                                                   */
+/*          aiu_linereader_init(&lr, fp, block, sizeof(block));             */
+/*          while (aiu_linereader_next(&lr, &line)) { ... }                 */
+/****************************************************************************/
+int aiu_linereader_init(aiu_linereader *lr, FILE *stream, char *buf,
+                        size_t buf_size) {
+    if (lr == NULL || stream == NULL || buf == NULL || buf_size == 0) return 0;
+
+    lr->stream = stream;
+    lr->buf = buf;
+    lr->size = buf_size;
+    lr->pos = 0;
+    lr->len = 0;
+    lr->eof = 0;
+    lr->skipping = 0;
+    lr->truncated = 0;
+    return 1;
+}
+
+/* Strip the line at its first '\r', as safe_gets() does, and return it */
+static int aiu_linereader_emit(const char *p, size_t n, aiu_str *line) {
+    const char *cr = (const char *)memchr(p, '\r', n);
+
+    line->ptr = p;
+    line->len = cr ? (size_t)(cr - p) : n;
+    return 1;
+}
+
+/****************************************************************************/
+/* aiu_linereader_next() - get the next line as a (ptr,len) span            */
+/*                                                                          */
+/* The newline is not part of the span, and the line ends at its first      */
+/* '\r' or '\n', exactly as safe_gets() strips it. A line longer than the   */
+/* buffer is returned cut to "buf_size" chars with "lr->truncated" set,     */
+/* and the rest of it is skipped. Unlike safe_gets(), an embedded null does */
+/* not end the line.                                                        */
+/*                                                                          */
+/* NOTE: The span points into the reader's buffer and is only valid until   */
+/*       the next call. On glibc and Windows the stream is read with the    */
+/*       unlocked stdio calls, so it must not be shared with another        */
+/*       thread while the reader uses it.                                   */
+/*                                                                          */
+/* RETURNS: 1 and the line in "*line", or 0 on EOF or read error.           */
+/****************************************************************************/
+int aiu_linereader_next(aiu_linereader *lr, aiu_str *line) {
+    for (;;) {
+        char *p = lr->buf + lr->pos;
+        size_t avail = lr->len - lr->pos;
+        char *nl = (char *)memchr(p, '\n', avail);
+        size_t got;
+
+        if (nl) {
+            lr->pos += (size_t)(nl - p) + 1;
+            if (lr->skipping) {         /* end of an overlong line's rest   */
+                lr->skipping = 0;
+                continue;
+            }
+            lr->truncated = 0;
+            return aiu_linereader_emit(p, (size_t)(nl - p), line);
+        }
+
+        if (lr->skipping) lr->pos = lr->len = avail = 0;  /* drop it all   */
+
+        if (lr->eof) {                  /* last line had no newline         */
+            if (avail == 0) return 0;
+            lr->pos = lr->len;
+            lr->truncated = 0;
+            return aiu_linereader_emit(p, avail, line);
+        }
+
+        /* Slide the partial line to the front and fill in behind it */
+        if (lr->pos > 0) {
+            memmove(lr->buf, p, avail);
+            lr->pos = 0;
+            lr->len = avail;
+        }
+        if (lr->len == lr->size) {      /* line fills the whole buffer      */
+            int ch = getc(lr->stream);  /* one peek: did it just fit?       */
+
+            lr->pos = lr->len = 0;
+            if (ch == EOF) lr->eof = 1;
+            lr->truncated = (ch != '\n' && ch != EOF);
+            lr->skipping = lr->truncated;
+            return aiu_linereader_emit(lr->buf, lr->size, line);
+        }
+
+#if defined(__GLIBC__) && defined(_GNU_SOURCE)
+        got = fread_unlocked(lr->buf + lr->len, 1, lr->size - lr->len, lr->stream);
+#elif defined(_MSC_VER)
+        got = _fread_nolock(lr->buf + lr->len, 1, lr->size - lr->len, lr->stream);
+#else
+        got = fread(lr->buf + lr->len, 1, lr->size - lr->len, lr->stream);
+#endif
+        if (got == 0) lr->eof = 1;      /* EOF or error: see ferror()       */
+        lr->len += got;
+    }
+}
+
+/****************************************************************************/
+/* aiu_linereader_init_mem() - iterate the lines of a buffer in memory      */
+/*                                                                          */
+/* Same line rules as aiu_linereader_next() on a stream, but the lines are  */
+/* spans straight into "data" (e.g. an aiu_mapfile), so nothing is copied   */
+/* and no line is ever truncated. "data" is never written.                  */
+/*                                                                          */
+/* EXAMPLE: aiu_linereader_init_mem(&lr, mf.data, mf.len);                  */
+/****************************************************************************/
+int aiu_linereader_init_mem(aiu_linereader *lr, const char *data, size_t len) {
+    if (lr == NULL || (data == NULL && len > 0)) return 0;
+
+    lr->stream = NULL;
+    lr->buf = (char *)(data ? data : "");  /* read-only: eof is set, so */
+    lr->size = len;                     /* it is never compacted or filled  */
+    lr->pos = 0;
+    lr->len = len;
+    lr->eof = 1;
+    lr->skipping = 0;
+    lr->truncated = 0;
+    return 1;
+}
+
+/****************************************************************************/
+/* aiu_mapfile_open() - map a whole file read-only into memory              */
+/*                                                                          */
+/* Uses mmap() with madvise(MADV_SEQUENTIAL) on POSIX and MapViewOfFile()   */
+/* on Windows, so read-only scans of very large files work straight from    */
+/* the page cache: hexatoi(), decatoi(), the span tokenizer and the line    */
+/* reader can all take (ptr,len) spans inside "mf->data".                   */
+/*                                                                          */
+/* NOTE: "mf->data" is not null terminated. An empty file maps to a valid   */
+/*       pointer with "mf->len" == 0. Call aiu_mapfile_close() when done.   */
+/*                                                                          */
+/* RETURNS: 1 on success, 0 on failure (the file could not be opened,       */
+/*          mapped, or does not fit in the address space).                  */
+/*                                                                          */
+/* EXAMPLE: aiu_mapfile mf;                                                 */
+/*          if (aiu_mapfile_open(&mf, "big.log")) {                         */
+/*            aiu_linereader_init_mem(&lr, mf.data, mf.len);                */
+/*            while (aiu_linereader_next(&lr, &line)) { ... }               */
+/*            aiu_mapfile_close(&mf);                                       */
+/*          }                                                               */
+/****************************************************************************/
+int aiu_mapfile_open(aiu_mapfile *mf, const char *path) {
+    if (mf == NULL || path == NULL) return 0;
+
+    mf->data = "";
+    mf->len = 0;
+    mf->mapped = 0;
+
+#if defined(_WIN32) || defined(_MSC_VER)
+    LARGE_INTEGER size;
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL,
+                              OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (file == INVALID_HANDLE_VALUE) return 0;
+
+    if (!GetFileSizeEx(file, &size) || (uint64_t)size.QuadPart > SIZE_MAX) {
+        CloseHandle(file);
+        return 0;
+    }
+    if (size.QuadPart > 0) {
+        HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+        void *view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : NULL;
+
+        if (mapping) CloseHandle(mapping);  /* the view keeps it alive     */
+        if (view == NULL) {
+            CloseHandle(file);
+            return 0;
+        }
+        mf->data = (const char *)view;
+        mf->len = (size_t)size.QuadPart;
+        mf->mapped = 1;
+    }
+    CloseHandle(file);
+#else
+    struct stat st;
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return 0;
+
+    if (fstat(fd, &st) != 0 || st.st_size < 0 ||
+        (uint64_t)st.st_size > SIZE_MAX) {
+        close(fd);
+        return 0;
+    }
+    if (st.st_size > 0) {
+        void *p = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+        if (p == MAP_FAILED) {
+            close(fd);
+            return 0;
+        }
+#if defined(MADV_SEQUENTIAL)
+        madvise(p, (size_t)st.st_size, MADV_SEQUENTIAL);
+#endif
+        mf->data = (const char *)p;
+        mf->len = (size_t)st.st_size;
+        mf->mapped = 1;
+    }
+    close(fd);                          /* the mapping stays valid          */
+#endif
+    return 1;
+}
+
+/****************************************************************************/
+/* aiu_mapfile_close() - unmap a file mapped by aiu_mapfile_open()          */
+/****************************************************************************/
+void aiu_mapfile_close(aiu_mapfile *mf) {
+    if (mf == NULL) return;
+
+    if (mf->mapped) {
+#if defined(_WIN32) || defined(_MSC_VER)
+        UnmapViewOfFile((LPCVOID)mf->data);
+#else
+        munmap((void *)mf->data, mf->len);
+#endif
+    }
+    mf->data = "";
+    mf->len = 0;
+    mf->mapped = 0;
+}
+
+/* One chunk of aiu_parallel_lines(): a newline-aligned slice of the input  */
+typedef struct aiu_chunk {
+    const char  *data;
+    size_t       len;
+    aiu_line_fn  fn;
+    void        *state;
+    size_t       lines;                 /* lines handed to "fn"             */
+} aiu_chunk;
+
+static void aiu_chunk_run(aiu_chunk *c) {
+    aiu_linereader lr;
+    aiu_str line;
+
+    aiu_linereader_init_mem(&lr, c->data, c->len);
+    while (aiu_linereader_next(&lr, &line)) {
+        c->fn(c->state, &line);
+        c->lines++;
+    }
+}
+
+#if !defined(AIUTILS_NO_THREADS)
+#if defined(_WIN32) || defined(_MSC_VER)
+static DWORD WINAPI aiu_chunk_thread(LPVOID arg) {
+    aiu_chunk_run((aiu_chunk *)arg);
+    return 0;
+}
+#else
+static void *aiu_chunk_thread(void *arg) {
+    aiu_chunk_run((aiu_chunk *)arg);
+    return NULL;
+}
+#endif
+#endif
+
+/* Online CPU count, 1 if unknown or built without threads */
+static int aiu_cpu_count(void) {
+#if defined(AIUTILS_NO_THREADS)
+    return 1;
+#elif defined(_WIN32) || defined(_MSC_VER)
+    SYSTEM_INFO si;
+    GetSystemInfo(&si);
+    return si.dwNumberOfProcessors > 0 ? (int)si.dwNumberOfProcessors : 1;
+#elif defined(_SC_NPROCESSORS_ONLN)
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 && n < 65536 ? (int)n : 1;
+#else
+    return 1;
+#endif
+}
+
+/****************************************************************************/
+/* aiu_parallel_lines() - run a callback for every line, across threads     */
+/*                                                                          */
+/* Splits "data" into up to "nthreads" chunks that start right after a      */
+/* newline, and runs "fn(state, &line)" for each line of chunk k on its own */
+/* thread with "state" = (char *)states + k * state_size. A callback only   */
+/* ever sees its own state, so it needs no locks; merge the states after    */
+/* the call returns. Lines follow the aiu_linereader_next() rules (newline  */
+/* and CR stripped) and are spans into "data", which is never written.      */
+/*                                                                          */
+/* "nthreads" <= 0 uses one thread per online CPU; it is capped at          */
+/* AIU_MAX_THREADS, and small inputs (under 64 KB per chunk) use fewer      */
+/* chunks, so initialize all "nthreads" states. Chunk 0 runs on the calling */
+/* thread, as does any chunk whose thread could not be started. With        */
+/* AIUTILS_NO_THREADS defined, every chunk runs on the calling thread.      */
+/*                                                                          */
+/* NOTE: The threads are started and joined on every call; there is no      */
+/*       pool. That costs tens of microseconds per thread, so pass large    */
+/*       buffers, not one small record at a time.                           */
+/*                                                                          */
+/* RETURNS: The total number of lines processed.                            */
+/*                                                                          */
+/* EXAMPLE: typedef struct { int64_t sum; } acc;                            */
+/*          static void add(void *st, const aiu_str *line) {                */
+/*            int64_t v;                                                    */
+/*            if (decatoi(line->ptr, line->len, &v)) ((acc *)st)->sum += v; */
+/*          }                                                               */
+/*          acc accs[8] = {0};                                              */
+/*          aiu_parallel_lines(mf.data, mf.len, 8, add, accs, sizeof(acc)); */
+/****************************************************************************/
+#define AIU_MIN_CHUNK 65536
+
+size_t aiu_parallel_lines(const char *data, size_t len, int nthreads,
+                          aiu_line_fn fn, void *states, size_t state_size) {
+    aiu_chunk chunks[AIU_MAX_THREADS];
+#if !defined(AIUTILS_NO_THREADS)
+#if defined(_WIN32) || defined(_MSC_VER)
+    HANDLE tids[AIU_MAX_THREADS];
+#else
+    pthread_t tids[AIU_MAX_THREADS];
+#endif
+    int started[AIU_MAX_THREADS];
+#endif
+    size_t n, k, start = 0, lines = 0;
+
+    if (fn == NULL || (data == NULL && len > 0)) return 0;
+
+    if (nthreads <= 0) nthreads = aiu_cpu_count();
+    if (nthreads > AIU_MAX_THREADS) nthreads = AIU_MAX_THREADS;
+    n = (size_t)nthreads;
+    if (n > len / AIU_MIN_CHUNK) n = len / AIU_MIN_CHUNK;
+    if (n == 0) n = 1;
+
+    /* Cut at len*k/n, then move each cut forward past the next newline */
+    for (k = 0; k < n; k++) {
+        size_t end = len;
+
+        if (k + 1 < n) {
+            end = (size_t)((uint64_t)len * (k + 1) / n);
+            if (end < start) end = start;
+            if (end < len) {
+                const char *nl = (const char *)memchr(data + end, '\n', len - end);
+                end = nl ? (size_t)(nl - data) + 1 : len;
+            }
+        }
+        chunks[k].data = data + start;
+        chunks[k].len = end - start;
+        chunks[k].fn = fn;
+        chunks[k].state = (char *)states + k * state_size;
+        chunks[k].lines = 0;
+        start = end;
+    }
+
+#if defined(AIUTILS_NO_THREADS)
+    for (k = 0; k < n; k++) aiu_chunk_run(&chunks[k]);
+#else
+    for (k = 1; k < n; k++) {
+        if (chunks[k].len == 0) {
+            started[k] = 0;
+            continue;
+        }
+#if defined(_WIN32) || defined(_MSC_VER)
+        tids[k] = CreateThread(NULL, 0, aiu_chunk_thread, &chunks[k], 0, NULL);
+        started[k] = tids[k] != NULL;
+#else
+        started[k] = pthread_create(&tids[k], NULL, aiu_chunk_thread, &chunks[k]) == 0;
+#endif
+    }
+    aiu_chunk_run(&chunks[0]);
+    for (k = 1; k < n; k++) {
+        if (!started[k]) {
+            aiu_chunk_run(&chunks[k]);  /* empty, or no thread available   */
+            continue;
+        }
+#if defined(_WIN32) || defined(_MSC_VER)
+        WaitForSingleObject(tids[k], INFINITE);
+        CloseHandle(tids[k]);
+#else
+        pthread_join(tids[k], NULL);
+#endif
+    }
+#endif
+
+    for (k = 0; k < n; k++) lines += chunks[k].lines;
+    return lines;
+}
+
+/****************************************************************************/
+/* aiu_parallel_file() - aiu_parallel_lines() over a memory-mapped file     */
+/*                                                                          */
+/* RETURNS: 1 on success with the line count in "*lines" (may be NULL),     */
+/*          0 if the file could not be mapped.                              */
+/*                                                                          */
+/* EXAMPLE: aiu_parallel_file("big.csv", 0, add, accs, sizeof(acc), &n);    */
+/****************************************************************************/
+int aiu_parallel_file(const char *path, int nthreads, aiu_line_fn fn,
+                      void *states, size_t state_size, size_t *lines) {
+    aiu_mapfile mf;
+    size_t count;
+
+    if (!aiu_mapfile_open(&mf, path)) return 0;
+    count = aiu_parallel_lines(mf.data, mf.len, nthreads, fn, states, state_size);
+    aiu_mapfile_close(&mf);
+    if (lines) *lines = count;
+    return 1;
+}
+
+/****************************************************************************/
+/* safe_strtok() - safe, re-entrant string tokenizer (replaces strtok)      */
+/*                                                                          */
+/* A safe, re-entrant wrapper for the platform-specific tokenizer           */
+/* (strtok_r / strtok_s) that replaces the standard, unsafe strtok().       */
+/*                                                                          */
+/* WHY IT'S NEEDED: The standard strtok() is *not re-entrant*. It uses a    */
+/* hidden internal static pointer to maintain state. Thus, dangerous for:   */
+/* 1. Nested loops (an inner strtok() call will break an outer one).        */
+/* 2. Multi-threaded applications.                                          */
+/*                                                                          */
+/* This function fixes the problem by forcing the caller to provide a       */
+/* state pointer ("save_ptr"), which is the correct, safe pattern.          */
+/*                                                                          */
+/* NOTE: This function *modifies* the "str" buffer in-place by writing      */
+/* null terminators. "str" must be modifiable.                              */
+/*                                                                          */
+/* EXAMPLE:                                                                 */
+/* char my_str[] = "a,b,c";                                                 */
+/* char *save_ptr;                                                          */
+/* char *token = safe_strtok(my_str, ",", &save_ptr);                       */
+/* while (token != NULL) {                                                  */
+/*   // use token                                                           */
+/*   token = safe_strtok(NULL, ",", &save_ptr);                             */
+/* }                                                                        */
+/****************************************************************************/
+char *safe_strtok(char *str, const char *delim, char **save_ptr)
+{
+/* Use the correct, safe function based on the operating system */
+#if defined(_WIN32) || defined(_MSC_VER)
+    return strtok_s(str, delim, save_ptr);
+#else
+    return strtok_r(str, delim, save_ptr);
+#endif
+}
+
+/****************************************************************************/
+/* safe_gmtime() - safe, re-entrant UTC conversion (replaces gmtime)        */
+/*                                                                          */
+/* A thread-safe wrapper for the platform-specific converter (gmtime_r /    */
+/* gmtime_s). Like strtok(), the standard gmtime() returns a pointer to a   */
+/* hidden static struct, which the next call (in any thread) overwrites.    */
+/* Here the caller provides the struct.                                     */
+/*                                                                          */
+/* RETURNS: "result" on success, or NULL on failure.                        */
+/*                                                                          */
+/* EXAMPLE: time_t now = time(NULL);                                        */
+/*          struct tm tm;                                                   */
+/*          if (safe_gmtime(&now, &tm)) ...                                 */
+/****************************************************************************/
+struct tm *safe_gmtime(const time_t *timer, struct tm *result)
+{
+    if (timer == NULL || result == NULL) return NULL;
+
+/* Use the correct, safe function based on the operating system */
+#if defined(_WIN32) || defined(_MSC_VER)
+    return gmtime_s(result, timer) == 0 ? result : NULL;
+#else
+    return gmtime_r(timer, result);
+#endif
+}
+
+/* The last day and second converted by this thread */
+typedef struct aiu_timecache {
+    int64_t day;                        /* days since 1970-01-01            */
+    int     year, mon, mday, wday, yday;    /* struct tm conventions    */
+    int     have_day;
+    int64_t sec;                        /* the second "iso" holds           */
+    int     have_sec;
+    char    iso[AIU_ISO8601_LEN + 1];
+} aiu_timecache;
+
+#if defined(AIU_THREAD_LOCAL)
+static AIU_THREAD_LOCAL aiu_timecache aiu_tc;
+#endif
+
+/* Civil date of "day" (days since 1970-01-01) in "tc", by arithmetic only  */
+/* (H. Hinnant's days-to-civil): no tz database, no lock                    */
+static int aiu_civil_from_days(int64_t day, aiu_timecache *tc) {
+    int64_t z, era, doe, yoe, doy, mp, y;
+    int leap;
+
+    if (day > INT64_C(784000000000) || day < -INT64_C(784000000000)) return 0;
+
+    z = day + 719468;                   /* days since 0000-03-01            */
+    era = (z >= 0 ? z : z - 146096) / 146097;
+    doe = z - era * 146097;                                /* [0, 146096]   */
+    yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365; /* [0, 399] */
+    doy = doe - (365 * yoe + yoe / 4 - yoe / 100);         /* [0, 365]      */
+    mp = (5 * doy + 2) / 153;                              /* [0, 11], Mar  */
+    y = yoe + era * 400 + (mp >= 10);
+    if (y - 1900 > INT32_MAX || y - 1900 < INT32_MIN) return 0;
+
+    leap = (y % 4 == 0) && (y % 100 != 0 || y % 400 == 0);
+    tc->day = day;
+    tc->year = (int)(y - 1900);
+    tc->mon = (int)(mp < 10 ? mp + 2 : mp - 10);
+    tc->mday = (int)(doy - (153 * mp + 2) / 5 + 1);
+    tc->yday = (int)(mp < 10 ? doy + 59 + leap : doy - 306);
+    tc->wday = (int)(((day % 7) + 11) % 7);    /* 1970-01-01 was a Thursday */
+    tc->have_day = 1;
+    return 1;
+}
+
+/* Day of "secs" in this thread's cache (or in "local"), computed at most   */
+/* once per day per thread                                                  */
+static const aiu_timecache *aiu_day_of(int64_t secs, aiu_timecache *local) {
+    int64_t day = secs / 86400 - (secs % 86400 < 0);
+    aiu_timecache *tc = local;
+
+#if defined(AIU_THREAD_LOCAL)
+    tc = &aiu_tc;
+#endif
+    if (tc->have_day && tc->day == day) return tc;
+    if (!aiu_civil_from_days(day, tc)) return NULL;
+    tc->have_sec = 0;
+    return tc;
+}
+
+/****************************************************************************/
+/* aiu_gmtime() - epoch seconds to broken-down UTC, without gmtime()        */
+/*                                                                          */
+/* Pure arithmetic (no tz lock, no syscalls), and the date part is cached   */
+/* per thread, so a logger converting the current time on every line does   */
+/* the calendar math once a day. Fills the same fields as gmtime_r(), with  */
+/* tm_isdst = 0. Other (platform-specific) fields are zeroed.               */
+/*                                                                          */
+/* RETURNS: 1 on success, 0 if "secs" is beyond what struct tm can hold.    */
+/*                                                                          */
+/* EXAMPLE: struct tm tm;                                                   */
+/*          aiu_gmtime((int64_t)time(NULL), &tm);                           */
+/****************************************************************************/
+int aiu_gmtime(int64_t secs, struct tm *out) {
+    aiu_timecache local;
+    const aiu_timecache *tc;
+    int64_t tod;
+
+    if (out == NULL) return 0;
+    local.have_day = 0;
+    if ((tc = aiu_day_of(secs, &local)) == NULL) return 0;
+
+    tod = secs - tc->day * 86400;       /* [0, 86399]                       */
+    memset(out, 0, sizeof(*out));
+    out->tm_sec = (int)(tod % 60);
+    out->tm_min = (int)(tod / 60 % 60);
+    out->tm_hour = (int)(tod / 3600);
+    out->tm_mday = tc->mday;
+    out->tm_mon = tc->mon;
+    out->tm_year = tc->year;
+    out->tm_wday = tc->wday;
+    out->tm_yday = tc->yday;
+    out->tm_isdst = 0;
+    return 1;
+}
+
+/* Write "v" (0..99) as two digits */
+#define AIU_PUT2(p, v) (memcpy((p), aiu_digit_pairs + (v) * 2, 2))
+
+/****************************************************************************/
+/* aiu_format_iso8601() - write epoch seconds as "YYYY-MM-DDTHH:MM:SSZ"     */
+/*                                                                          */
+/* Uses the fitoa() digit-pair table and aiu_gmtime()'s per-thread day      */
+/* cache; a repeat of the same second (the common case in a logger) is a    */
+/* single 20-byte copy.                                                     */
+/*                                                                          */
+/* NOTE: "buf" needs AIU_ISO8601_LEN + 1 (21) bytes and is null terminated. */
+/*                                                                          */
+/* RETURNS: AIU_ISO8601_LEN, or 0 (with "buf" set to "" if it has room) if  */
+/*          "buf" is too small or the year is outside 0000..9999.           */
+/*                                                                          */
+/* EXAMPLE: char ts[AIU_ISO8601_LEN + 1];                                   */
+/*          aiu_format_iso8601((int64_t)time(NULL), ts, sizeof(ts));        */
+/****************************************************************************/
+size_t aiu_format_iso8601(int64_t secs, char *buf, size_t size) {
+    aiu_timecache local;
+    aiu_timecache *tc;
+    int64_t tod;
+    int year;
+    char *p;
+
+    if (buf == NULL || size == 0) return 0;
+    buf[0] = '\0';
+    if (size < AIU_ISO8601_LEN + 1) return 0;
+
+    local.have_day = 0;
+    if ((tc = (aiu_timecache *)aiu_day_of(secs, &local)) == NULL) return 0;
+    year = tc->year + 1900;
+    if (year < 0 || year > 9999) return 0;
+
+    if (!tc->have_sec || tc->sec != secs) {
+        tod = secs - tc->day * 86400;
+        p = tc->iso;
+        AIU_PUT2(p, year / 100);
+        AIU_PUT2(p + 2, year % 100);
+        p[4] = '-';
+        AIU_PUT2(p + 5, tc->mon + 1);
+        p[7] = '-';
+        AIU_PUT2(p + 8, tc->mday);
+        p[10] = 'T';
+        AIU_PUT2(p + 11, (int)(tod / 3600));
+        p[13] = ':';
+        AIU_PUT2(p + 14, (int)(tod / 60 % 60));
+        p[16] = ':';
+        AIU_PUT2(p + 17, (int)(tod % 60));
+        p[19] = 'Z';
+        p[20] = '\0';
+        tc->sec = secs;
+        tc->have_sec = 1;
+    }
+    memcpy(buf, tc->iso, AIU_ISO8601_LEN + 1);
+    return AIU_ISO8601_LEN;
+}
+
+/****************************************************************************/
+/* aiu_delims_init() - build a delimiter set for the span tokenizer         */
+/*                                                                          */
+/* Turns the null terminated "delim" list into a 256-bit bitmap once, so    */
+/* tokenizing never rescans the list the way strtok_r() does on every call. */
+/*                                                                          */
+/* EXAMPLE: aiu_delims d;                                                   */
+/*          aiu_delims_init(&d, " ,;");                                     */
+/****************************************************************************/
+void aiu_delims_init(aiu_delims *d, const char *delim) {
+    memset(d, 0, sizeof(*d));
+    if (delim == NULL) return;
+
+    for (; *delim; delim++) {
+        unsigned char c = (unsigned char)*delim;
+
+        if (AIU_DELIM_HAS(d, c)) continue;          /* ignore repeats       */
+        d->bits[c >> 5] |= (uint32_t)1 << (c & 31);
+        if (d->count < 4) d->list[d->count] = c;    /* block scan list      */
+        d->count++;
+    }
+}
+
+/* First delimiter in [p, end), or "end" if there is none */
+static const char *aiu_delim_scan(const char *p, const char *end,
+                                  const aiu_delims *d) {
+    if (d->count == 0) return end;
+    if (d->count == 1) {
+        const char *hit = (const char *)memchr(p, d->list[0], (size_t)(end - p));
+        return hit ? hit : end;
+    }
+
+#if defined(AIUTILS_SIMD) && defined(AIU_HAVE_SSE2)
+    if (d->count <= 4 && end - p >= 16 && AIU_VECTOR_ON()) {
+        /* Unused slots repeat list[0] */
+        const __m128i d0 = _mm_set1_epi8((char)d->list[0]);
+        const __m128i d1 = _mm_set1_epi8((char)d->list[1]);
+        const __m128i d2 = _mm_set1_epi8((char)d->list[d->count > 2 ? 2 : 0]);
+        const __m128i d3 = _mm_set1_epi8((char)d->list[d->count > 3 ? 3 : 0]);
+
+        for (; end - p >= 16; p += 16) {
+            __m128i v = _mm_loadu_si128((const __m128i *)p);
+            __m128i hit = _mm_or_si128(
+                _mm_or_si128(_mm_cmpeq_epi8(v, d0), _mm_cmpeq_epi8(v, d1)),
+                _mm_or_si128(_mm_cmpeq_epi8(v, d2), _mm_cmpeq_epi8(v, d3)));
+            uint32_t mask = (uint32_t)_mm_movemask_epi8(hit);
+            if (mask) return p + aiu_ctz32(mask);
+        }
+    }
+#elif defined(AIUTILS_SIMD) && defined(AIU_HAVE_NEON)
+    if (d->count <= 4 && end - p >= 16 && AIU_VECTOR_ON()) {
+        const uint8x16_t d0 = vdupq_n_u8(d->list[0]);
+        const uint8x16_t d1 = vdupq_n_u8(d->list[1]);
+        const uint8x16_t d2 = vdupq_n_u8(d->list[d->count > 2 ? 2 : 0]);
+        const uint8x16_t d3 = vdupq_n_u8(d->list[d->count > 3 ? 3 : 0]);
+
+        for (; end - p >= 16; p += 16) {
+            uint8x16_t v = vld1q_u8((const uint8_t *)p);
+            uint8x16_t hit = vorrq_u8(vorrq_u8(vceqq_u8(v, d0), vceqq_u8(v, d1)),
+                                      vorrq_u8(vceqq_u8(v, d2), vceqq_u8(v, d3)));
+            uint64_t mask = aiu_neon_mask(hit);
+            if (mask) return p + aiu_ctz64(mask) / 4;
+        }
+    }
+#endif
+
+    for (; p < end; p++) if (AIU_DELIM_HAS(d, (unsigned char)*p)) break;
+    return p;
+}
+
+/****************************************************************************/
+/* aiu_tok_init() - start tokenizing "len" chars of "s"                     */
+/*                                                                          */
+/* The span tokenizer never writes to "s", so it works on read-only and     */
+/* memory-mapped buffers. "s" need not be null terminated; a null is an     */
+/* ordinary char unless it is in the delimiter set.                         */
+/*                                                                          */
+/* NOTE: "t" keeps pointers to "s" and "d"; both must outlive it.           */
+/*                                                                          */
+/* EXAMPLE: aiu_tokenizer t;                                                */
+/*          aiu_str tok;                                                    */
+/*          aiu_tok_init(&t, line, line_len, &d);                           */
+/*          while (aiu_tok_next(&t, &tok)) {                                */
+/*            // use tok.ptr, tok.len                                       */
+/*          }                                                               */
+/****************************************************************************/
+void aiu_tok_init(aiu_tokenizer *t, const char *s, size_t len,
+                  const aiu_delims *d) {
+    t->p = s;
+    t->end = s + len;
+    t->delims = d;
+}
+
+/****************************************************************************/
+/* aiu_tok_next() - get the next token as a (ptr,len) span                  */
+/*                                                                          */
+/* Same splitting as safe_strtok(): runs of delimiters are skipped, so no   */
+/* empty tokens are returned.                                               */
+/*                                                                          */
+/* RETURNS: 1 and the token in "*tok", or 0 when there are no more tokens.  */
+/****************************************************************************/
+int aiu_tok_next(aiu_tokenizer *t, aiu_str *tok) {
+    const char *p = t->p;
+
+    while (p < t->end && AIU_DELIM_HAS(t->delims, (unsigned char)*p)) p++;
+    if (p == t->end) {
+        t->p = p;
+        return 0;
+    }
+
+    tok->ptr = p;
+    p = aiu_delim_scan(p, t->end, t->delims);
+    tok->len = (size_t)(p - tok->ptr);
+    t->p = (p < t->end) ? p + 1 : p;    /* step over the delimiter          */
+    return 1;
+}
+
+/****************************************************************************/
+/* aiu_split() - split a whole line into spans in one pass                  */
+/*                                                                          */
+/* Stores at most "max_fields" fields of "s" in "fields[]". If "keep_empty" */
+/* is 0, runs of delimiters are skipped as in safe_strtok(); otherwise      */
+/* every delimiter ends a field, so "a,,b" gives "a", "", "b" and an empty  */
+/* line gives one empty field (CSV-style).                                  */
+/*                                                                          */
+/* RETURNS: The number of fields in the line. If that is more than          */
+/*          "max_fields", only the first "max_fields" were stored.          */
+/*                                                                          */
+/* EXAMPLE: aiu_str f[32];                                                  */
+/*          n = aiu_split(line, len, &d, f, 32, 1);                         */
+/****************************************************************************/
+size_t aiu_split(const char *s, size_t len, const aiu_delims *d,
+                 aiu_str *fields, size_t max_fields, int keep_empty) {
+    const char *p = s, *end = s + len;
+    size_t n = 0;
+
+    if (!keep_empty) {
+        aiu_tokenizer t;
+        aiu_str tok;
+
+        aiu_tok_init(&t, s, len, d);
+        while (aiu_tok_next(&t, &tok)) {
+            if (n < max_fields) fields[n] = tok;
+            n++;
+        }
+        return n;
+    }
+
+    for (;;) {
+        const char *q = aiu_delim_scan(p, end, d);
+
+        if (n < max_fields) {
+            fields[n].ptr = p;
+            fields[n].len = (size_t)(q - p);
+        }
+        n++;
+        if (q == end) return n;
+        p = q + 1;
+    }
+}
+
+/****************************************************************************/
+/* laststrstr() - Find the last occurrence of "needle" in "haystack"        */
+/*                                                                          */
+/* EXAMPLE: const char *p = laststrstr("a-b-c", "-"); // p points to "-c"   */
+/****************************************************************************/
+const char *laststrstr(const char *haystack, const char *needle) {
+    if (haystack == NULL || needle == NULL) return NULL;
+
+    /* Empty needle always matches the end of the string (see below) */
+    return laststrstr_n(haystack, strlen(haystack), needle, strlen(needle));
+}
+
+/****************************************************************************/
+/* laststrstr_n() - laststrstr() for (ptr,len) haystacks and needles        */
+/*                                                                          */
+/* Searches backwards from the end, so it stops at the first hit from the   */
+/* right instead of scanning the whole string. Longer needles use a reverse */
+/* Horspool skip table; a 1-char needle is a memrchr().                     */
+/*                                                                          */
+/* RETURNS: The last match in "haystack", or NULL if there is none. An      */
+/*          empty needle matches at "haystack + hay_len".                   */
+/*                                                                          */
+/* EXAMPLE: const char *dot = laststrstr_n(url, url_len, ".", 1);           */
+/****************************************************************************/
+const char *laststrstr_n(const char *haystack, size_t hay_len,
+                         const char *needle, size_t needle_len) {
+    const unsigned char *h = (const unsigned char *)haystack;
+    const unsigned char *n = (const unsigned char *)needle;
+    size_t shift[256];
+    size_t i, pos;
+
+    if (haystack == NULL || needle == NULL) return NULL;
+    if (needle_len == 0) return haystack + hay_len;
+    if (needle_len > hay_len) return NULL;
+
+    if (needle_len == 1) {
+#if defined(__GLIBC__) && defined(_GNU_SOURCE)
+        return (const char *)memrchr(haystack, n[0], hay_len);
+#else
+        for (pos = hay_len; pos-- > 0;) if (h[pos] == n[0]) return haystack + pos;
+        return NULL;
+#endif
+    }
+
+    /* Shift a window starting at "pos" left until the char now under its  */
+    /* start lines up with the nearest matching needle char after n[0].    */
+    for (i = 0; i < 256; i++) shift[i] = needle_len;
+    for (i = needle_len - 1; i >= 1; i--) shift[n[i]] = i;
+
+    pos = hay_len - needle_len;
+    for (;;) {
+        if (h[pos] == n[0] && !memcmp(h + pos + 1, n + 1, needle_len - 1))
+            return haystack + pos;
+        if (pos < shift[h[pos]]) return NULL;
+        pos -= shift[h[pos]];
+    }
+}
+
+/****************************************************************************/
+/* lastN() - get the last n characters of a string                          */
+/*                                                                          */
+/* Returns a pointer to the last 'n' characters of 's'.                     */
+/* If 'n' > strlen(s), returns 's'.                                         */
+/*                                                                          */
+/* EXAMPLE: const char *p = lastN("hello", 3); // p points to "llo"         */
+/****************************************************************************/
+const char *lastN(const char *s, size_t n) {
+   return lastN_n(s, strlen(s), n);
+} 
+
+/****************************************************************************/
+/* lastN_n() - get the last n characters of a "len"-char span               */
+/*                                                                          */
+/* EXAMPLE: const char *ext = lastN_n(name.ptr, name.len, 4);               */
+/****************************************************************************/
+const char *lastN_n(const char *s, size_t len, size_t n) {
+   return (len < n ? s : s + len - n);
+}
+
+/****************************************************************************/
+/* uppercase_inplace() - convert line to uppercase, in-place                */
+/*                                                                          */
+/* NOTE: "line" must be a modifiable string (e.g., an array or malloc'd).   */
+/*                                                                          */
+/* EXAMPLE: uppercase_inplace(my_buffer);                                   */
+/****************************************************************************/
+void uppercase_inplace(char *line) {
+    if (line == NULL) return;
+
+#if defined(AIUTILS_SIMD)
+    aiu_case_copy(line, line, strlen(line), 1);
+#else
+    for (; *line; line++) *line = AIU_TOUPPER(*line);
+#endif
+}
+
+/****************************************************************************/
+/* uppercase_inplace_n() - convert "len" chars to uppercase, in-place       */
+/*                                                                          */
+/* Length-aware uppercase_inplace(): converts exactly "len" chars and does  */
+/* not stop at (or need) a null.                                            */
+/*                                                                          */
+/* EXAMPLE: uppercase_inplace_n(key.ptr, key.len);                          */
+/****************************************************************************/
+void uppercase_inplace_n(char *s, size_t len) {
+    if (s == NULL) return;
+
+#if defined(AIUTILS_SIMD)
+    aiu_case_copy(s, s, len, 1);
+#else
+    for (; len; len--, s++) *s = AIU_TOUPPER(*s);
+#endif
+}
+
+/****************************************************************************/
+/* lowercase_inplace() - convert line to lowercase, in-place                */
+/*                                                                          */
+/* NOTE: "line" must be a modifiable string (e.g., an array or malloc'd).   */
+/*                                                                          */
+/* EXAMPLE: lowercase_inplace(my_buffer);                                   */
+/****************************************************************************/
+void lowercase_inplace(char *line) {
+    if (line == NULL) return;
+
+#if defined(AIUTILS_SIMD)
+    aiu_case_copy(line, line, strlen(line), 0);
+#else
+    for (; *line; line++) *line = AIU_TOLOWER(*line);
+#endif
+}
+
+/****************************************************************************/
+/* lowercase_inplace_n() - convert "len" chars to lowercase, in-place       */
+/*                                                                          */
+/* EXAMPLE: lowercase_inplace_n(key.ptr, key.len);                          */
+/****************************************************************************/
+void lowercase_inplace_n(char *s, size_t len) {
+    if (s == NULL) return;
+
+#if defined(AIUTILS_SIMD)
+    aiu_case_copy(s, s, len, 0);
+#else
+    for (; len; len--, s++) *s = AIU_TOLOWER(*s);
+#endif
+}
+
+/****************************************************************************/
+/* makelower_safe_copy() - safely copy a string, making it lowercase        */
+/*                                                                          */
+/* EXAMPLE: makelower_safe_copy(dest, src, sizeof(dest));                   */
+/****************************************************************************/
+void makelower_safe_copy(char *dest, const char *src, size_t dest_size) {
+    if (dest == NULL || src == NULL || dest_size == 0) {
+        if (dest != NULL && dest_size > 0) dest[0] = '\0';
+        return;
+    }
+    
+#if defined(AIUTILS_SIMD)
+    size_t n = aiu_nul_scan(src, dest_size - 1);
+    aiu_case_copy(dest, src, n, 0);
+    dest[n] = '\0';
+    AIU_STAT(AIU_STAT_MAKELOWER, n, src[n]);
+#else
+    char *p = dest;
+
+    /* Loop as long as there is source and we have room in dest */
+    while (*src && --dest_size > 0) {
+        *p++ = AIU_TOLOWER(*src);
+        src++;
+    }
+    
+    /* Always null-terminate */
+    *p = '\0';
+    AIU_STAT(AIU_STAT_MAKELOWER, p - dest, *src);
+#endif
+}
+
+/****************************************************************************/
+/* aiu_arena_init() - start a bump arena over caller-owned memory           */
+/*                                                                          */
+/* The arena never calls malloc(): it hands out pieces of "mem" until it    */
+/* runs out, and aiu_arena_reset() frees them all at once (e.g. once per    */
+/* request). Once any allocation has failed, "a->full" stays set until the  */
+/* next reset, so a run of calls can be checked once at the end.            */
+/*                                                                          */
+/* EXAMPLE: char mem[4096];                                                 */
+/*          aiu_arena a;                                                    */
+/*          aiu_arena_init(&a, mem, sizeof(mem));                           */
+/****************************************************************************/
+void aiu_arena_init(aiu_arena *a, void *mem, size_t size) {
+    if (a == NULL) return;
+
+    a->base = (char *)mem;
+    a->size = mem ? size : 0;
+    a->used = 0;
+    a->last = 0;
+    a->full = 0;
+}
+
+/****************************************************************************/
+/* aiu_arena_reset() - release every allocation of the arena at once        */
+/****************************************************************************/
+void aiu_arena_reset(aiu_arena *a) {
+    if (a == NULL) return;
+
+    a->used = 0;
+    a->last = 0;
+    a->full = 0;
+}
+
+/****************************************************************************/
+/* aiu_arena_alloc() - allocate "n" bytes aligned to "align" from an arena  */
+/*                                                                          */
+/* "align" must be a power of two (0 or 1 for unaligned chars).             */
+/*                                                                          */
+/* RETURNS: The memory, or NULL (and "a->full" set) if it does not fit.     */
+/*                                                                          */
+/* EXAMPLE: aiu_str *f = aiu_arena_alloc(&a, 16 * sizeof(aiu_str),          */
+/*                                       sizeof(void *));                   */
+/****************************************************************************/
+void *aiu_arena_alloc(aiu_arena *a, size_t n, size_t align) {
+    size_t at;
+
+    if (a == NULL) return NULL;
+    if (align < 1) align = 1;
+
+    /* Round the address (not the offset) up, since "base" may be unaligned */
+    at = a->used + ((align - ((uintptr_t)(a->base + a->used) & (align - 1))) & (align - 1));
+    if (at < a->used || at > a->size || n > a->size - at) {
+        a->full = 1;
+        return NULL;
+    }
+    a->last = at;
+    a->used = at + n;
+    return a->base + at;
+}
+
+/****************************************************************************/
+/* aiu_arena_strzcpy_n() - copy "len" chars into an exact-size arena string */
+/*                                                                          */
+/* RETURNS: The null-terminated copy, or NULL if the arena is full.         */
+/*                                                                          */
+/* EXAMPLE: char *name = aiu_arena_strzcpy_n(&a, tok.ptr, tok.len);         */
+/****************************************************************************/
+char *aiu_arena_strzcpy_n(aiu_arena *a, const char *s, size_t len) {
+    char *d;
+
+    if (s == NULL && len > 0) return NULL;
+    if (len == SIZE_MAX || (d = (char *)aiu_arena_alloc(a, len + 1, 1)) == NULL)
+        return NULL;
+    if (len > 0) memcpy(d, s, len);
+    d[len] = '\0';
+    return d;
+}
+
+/****************************************************************************/
+/* aiu_arena_strzcpy() - strzcpy() into an arena string of exactly the size */
+/*                       needed, so nothing is ever truncated               */
+/*                                                                          */
+/* RETURNS: The copy, or NULL if "s" is NULL or the arena is full.          */
+/*                                                                          */
+/* EXAMPLE: char *host = aiu_arena_strzcpy(&a, getenv("HOST"));             */
+/****************************************************************************/
+char *aiu_arena_strzcpy(aiu_arena *a, const char *s) {
+    if (s == NULL) return NULL;
+    return aiu_arena_strzcpy_n(a, s, strlen(s));
+}
+
+/****************************************************************************/
+/* aiu_arena_strzcat() - strzcat() for arena strings                        */
+/*                                                                          */
+/* When "d" is the arena's most recent allocation (the usual case in an     */
+/* append chain), it grows in place and its length is known without a       */
+/* strlen(). Otherwise "d" + "s" is copied into a new arena string. "d"     */
+/* may be NULL, which makes this aiu_arena_strzcpy().                       */
+/*                                                                          */
+/* NOTE: Growing in place relies on "d" filling its allocation, as strings  */
+/*       from the aiu_arena_str*() functions do; shorten one and pass it    */
+/*       back here only after aiu_arena_strzcpy()'ing it.                   */
+/*       "d" is left intact when the arena is full.                         */
+/*                                                                          */
+/* RETURNS: The joined string (which may differ from "d"), or NULL if the   */
+/*          arena is full.                                                  */
+/*                                                                          */
+/* EXAMPLE: s = aiu_arena_strzcpy(&a, "GET ");                              */
+/*          s = aiu_arena_strzcat(&a, s, path);                             */
+/****************************************************************************/
+char *aiu_arena_strzcat(aiu_arena *a, char *d, const char *s) {
+    size_t dlen, slen;
+    char *r;
+
+    if (a == NULL || s == NULL) return NULL;
+    if (d == NULL) return aiu_arena_strzcpy(a, s);
+
+    slen = strlen(s);
+    if (a->used > a->last && d == a->base + a->last && a->base[a->used - 1] == '\0') {
+        /* Last allocation: it ends at "used", null included */
+        dlen = a->used - a->last - 1;
+        if (slen > a->size - a->used) {
+            a->full = 1;
+            return NULL;
+        }
+        memmove(d + dlen, s, slen);     /* "s" may be "d" itself            */
+        d[dlen + slen] = '\0';
+        a->used += slen;
+        return d;
+    }
+
+    dlen = strlen(d);
+    if (slen > SIZE_MAX - 1 - dlen ||
+        (r = (char *)aiu_arena_alloc(a, dlen + slen + 1, 1)) == NULL) {
+        a->full = 1;
+        return NULL;
+    }
+    memcpy(r, d, dlen);
+    memcpy(r + dlen, s, slen);
+    r[dlen + slen] = '\0';
+    return r;
+}
+
+/****************************************************************************/
+/* aiu_arena_substring() - substring_safe_copy_n() into an exact-size arena */
+/*                         string                                           */
+/*                                                                          */
+/* RETURNS: The slice (empty if "position" is past the end), or NULL if the */
+/*          arena is full.                                                  */
+/*                                                                          */
+/* EXAMPLE: char *year = aiu_arena_substring(&a, date, 10, 0, 4);           */
+/****************************************************************************/
+char *aiu_arena_substring(aiu_arena *a, const char *src, size_t src_len,
+                          size_t position, size_t length) {
+    size_t n = 0;
+
+    if (src == NULL) src_len = 0;
+    if (position < src_len) {
+        n = src_len - position;
+        if (n > length) n = length;
+    }
+    return aiu_arena_strzcpy_n(a, n ? src + position : "", n);
+}
+
+/****************************************************************************/
+/* aiu_arena_tok_next() - next aiu_tokenizer token, as an arena string      */
+/*                                                                          */
+/* Like aiu_tok_next(), but the token comes back null terminated in its own */
+/* exact-size arena string, so the input is still never written.            */
+/*                                                                          */
+/* RETURNS: The token, or NULL when there are no more tokens or the arena   */
+/*          is full (check "a->full" to tell them apart).                   */
+/*                                                                          */
+/* EXAMPLE: while ((tok = aiu_arena_tok_next(&a, &t)) != NULL) { ... }      */
+/****************************************************************************/
+char *aiu_arena_tok_next(aiu_arena *a, aiu_tokenizer *t) {
+    aiu_str tok;
+
+    if (!aiu_tok_next(t, &tok)) return NULL;
+    return aiu_arena_strzcpy_n(a, tok.ptr, tok.len);
+}
+
+/****************************************************************************/
+/* aiu_sb_init() - start an empty string builder                            */
+/*                                                                          */
+/* With an arena, the builder grows inside it (in place while it is the     */
+/* arena's newest allocation) and aiu_sb_free() has nothing to do. With     */
+/* "arena" NULL it grows on the heap, doubling each time, and the caller    */
+/* must aiu_sb_free() it. If any append fails for lack of memory,           */
+/* "sb->failed" stays set and the text so far is kept.                      */
+/*                                                                          */
+/* EXAMPLE: aiu_sb sb;                                                      */
+/*          aiu_sb_init(&sb, &arena);                                       */
+/*          aiu_sb_append_str(&sb, "user=");                                */
+/*          aiu_sb_append_u32(&sb, uid);                                    */
+/*          log_line(aiu_sb_cstr(&sb));                                     */
+/****************************************************************************/
+void aiu_sb_init(aiu_sb *sb, aiu_arena *arena) {
+    if (sb == NULL) return;
+
+    sb->buf = NULL;
+    sb->len = 0;
+    sb->cap = 0;
+    sb->arena = arena;
+    sb->failed = 0;
+}
+
+/****************************************************************************/
+/* aiu_sb_reserve() - make room for "extra" more chars (plus the null)      */
+/*                                                                          */
+/* RETURNS: 1 if the room is there, 0 (and "sb->failed" set) if not.        */
+/****************************************************************************/
+int aiu_sb_reserve(aiu_sb *sb, size_t extra) {
+    size_t need, cap;
+    char *p;
+
+    if (sb == NULL) return 0;
+    if (extra <= sb->cap - sb->len) return 1;
+    if (extra > SIZE_MAX - 1 - sb->len) goto fail;
+
+    need = sb->len + extra;
+    cap = sb->cap < 32 ? 32 : sb->cap;
+    while (cap < need) cap = (cap > SIZE_MAX / 2) ? need : cap * 2;
+    if (cap == SIZE_MAX) cap--;         /* room for the null                */
+
+    if (sb->arena) {
+        aiu_arena *a = sb->arena;
+        size_t room;
+
+        /* Still the arena's newest allocation: just move its end */
+        if (sb->buf && sb->buf == a->base + a->last && a->used == a->last + sb->cap + 1) {
+            room = a->size - a->last - 1;
+            if (need > room) {
+                a->full = 1;
+                goto fail;
+            }
+            sb->cap = cap < room ? cap : room;
+            a->used = a->last + sb->cap + 1;
+            return 1;
+        }
+
+        /* Otherwise move to a new block: doubled if it fits, else just enough */
+        room = a->size - a->used;
+        if (room == 0 || need > room - 1) {
+            a->full = 1;
+            goto fail;
+        }
+        if (cap > room - 1) cap = room - 1;
+        if ((p = (char *)aiu_arena_alloc(a, cap + 1, 1)) == NULL) goto fail;
+        if (sb->len > 0) memcpy(p, sb->buf, sb->len);
+    } else {
+        if ((p = (char *)realloc(sb->buf, cap + 1)) == NULL) goto fail;
+    }
+    sb->buf = p;
+    sb->cap = cap;
+    return 1;
+
+fail:
+    sb->failed = 1;
+    return 0;
+}
+
+/****************************************************************************/
+/* aiu_sb_append() - append "len" chars of "s"                              */
+/*                                                                          */
+/* RETURNS: 1 on success, 0 (nothing appended) if memory ran out.           */
+/*                                                                          */
+/* EXAMPLE: aiu_sb_append(&sb, tok.ptr, tok.len);                           */
+/****************************************************************************/
+int aiu_sb_append(aiu_sb *sb, const char *s, size_t len) {
+    if (s == NULL && len > 0) return 0;
+    if (!aiu_sb_reserve(sb, len)) return 0;
+    if (len > 0) memcpy(sb->buf + sb->len, s, len);
+    sb->len += len;
+    return 1;
+}
+
+/****************************************************************************/
+/* aiu_sb_append_str() - append a null-terminated string                    */
+/****************************************************************************/
+int aiu_sb_append_str(aiu_sb *sb, const char *s) {
+    if (s == NULL) return 0;
+    return aiu_sb_append(sb, s, strlen(s));
+}
+
+/****************************************************************************/
+/* aiu_sb_append_char() - append one char                                   */
+/****************************************************************************/
+int aiu_sb_append_char(aiu_sb *sb, char c) {
+    if (!aiu_sb_reserve(sb, 1)) return 0;
+    sb->buf[sb->len++] = c;
+    return 1;
+}
+
+/****************************************************************************/
+/* aiu_sb_append_u32() - append "n" in decimal (the fitoa() digit kernel)   */
+/*                                                                          */
+/* EXAMPLE: aiu_sb_append_u32(&sb, status);                                 */
+/****************************************************************************/
+int aiu_sb_append_u32(aiu_sb *sb, uint32_t n) {
+    size_t len = aiu_digits10(n);
+
+    if (!aiu_sb_reserve(sb, len)) return 0;
+    aiu_put_digits(sb->buf + sb->len + len, n);
+    sb->len += len;
+    return 1;
+}
+
+/****************************************************************************/
+/* aiu_sb_append_i64() - append "n" in decimal, with a '-' if negative      */
+/*                                                                          */
+/* EXAMPLE: aiu_sb_append_i64(&sb, delta);                                  */
+/****************************************************************************/
+int aiu_sb_append_i64(aiu_sb *sb, int64_t n) {
+    uint64_t u = n < 0 ? 0 - (uint64_t)n : (uint64_t)n;
+    size_t len = aiu_digits10(u) + (n < 0);
+
+    if (!aiu_sb_reserve(sb, len)) return 0;
+    if (n < 0) sb->buf[sb->len] = '-';
+    aiu_put_digits(sb->buf + sb->len + len, u);
+    sb->len += len;
+    return 1;
+}
+
+/****************************************************************************/
+/* aiu_sb_append_hex() - append "n" in lowercase hex, zero padded to at     */
+/*                       least "min_digits" digits (at most 16)             */
+/*                                                                          */
+/* EXAMPLE: aiu_sb_append_hex(&sb, crc, 8);          // "0000beef"          */
+/****************************************************************************/
+int aiu_sb_append_hex(aiu_sb *sb, uint64_t n, size_t min_digits) {
+    static const char xdigits[] = "0123456789abcdef";
+    size_t len = 1;
+    char *end;
+
+    while (len < 16 && (n >> (len * 4))) len++;
+    if (min_digits > 16) min_digits = 16;
+    if (len < min_digits) len = min_digits;
+
+    if (!aiu_sb_reserve(sb, len)) return 0;
+    end = sb->buf + sb->len + len;
+    for (; end > sb->buf + sb->len; n >>= 4) *--end = xdigits[n & 15];
+    sb->len += len;
+    return 1;
+}
+
+/****************************************************************************/
+/* aiu_sb_append_padded() - append "len" chars of "s" padded with "pad" to  */
+/*                          "width" chars                                   */
+/*                                                                          */
+/* mode 'r' right-justifies (pads on the left, like fitoa()), anything else */
+/* left-justifies. Text longer than "width" is appended whole.              */
+/*                                                                          */
+/* EXAMPLE: aiu_sb_append_padded(&sb, name, strlen(name), 12, ' ', 'l');    */
+/****************************************************************************/
+int aiu_sb_append_padded(aiu_sb *sb, const char *s, size_t len, size_t width,
+                         char pad, char mode) {
+    size_t fill = width > len ? width - len : 0;
+
+    if (s == NULL && len > 0) return 0;
+    if (len > SIZE_MAX - fill || !aiu_sb_reserve(sb, len + fill)) return 0;
+    if (len + fill == 0) return 1;      /* "sb->buf" may still be NULL      */
+    if (mode == 'r') memset(sb->buf + sb->len, pad, fill);
+    if (len > 0) memcpy(sb->buf + sb->len + (mode == 'r' ? fill : 0), s, len);
+    if (mode != 'r') memset(sb->buf + sb->len + len, pad, fill);
+    sb->len += len + fill;
+    return 1;
+}
+
+/****************************************************************************/
+/* aiu_sb_cstr() - the built text, null terminated                          */
+/*                                                                          */
+/* RETURNS: The builder's buffer ("" if nothing was ever appended). It is   */
+/*          valid until the next append, aiu_sb_free() or arena reset.      */
+/****************************************************************************/
+const char *aiu_sb_cstr(aiu_sb *sb) {
+    if (sb == NULL || sb->buf == NULL) return "";
+    sb->buf[sb->len] = '\0';            /* reserve() always keeps the room  */
+    return sb->buf;
+}
+
+/****************************************************************************/
+/* aiu_sb_view() - the built text as a (ptr,len) span, e.g. for writev()    */
+/****************************************************************************/
+aiu_str aiu_sb_view(const aiu_sb *sb) {
+    aiu_str v;
+
+    v.ptr = (sb && sb->buf) ? sb->buf : "";
+    v.len = sb ? sb->len : 0;
+    return v;
+}
+
+/****************************************************************************/
+/* aiu_sb_reset() - empty the builder but keep its buffer for reuse         */
+/****************************************************************************/
+void aiu_sb_reset(aiu_sb *sb) {
+    if (sb == NULL) return;
+
+    sb->len = 0;
+    sb->failed = 0;
+}
+
+/****************************************************************************/
+/* aiu_sb_free() - release a heap-grown builder (a no-op with an arena)     */
+/****************************************************************************/
+void aiu_sb_free(aiu_sb *sb) {
+    if (sb == NULL) return;
+
+    if (sb->arena == NULL) free(sb->buf);
+    aiu_sb_init(sb, sb->arena);
+}
+
+/* Sort order of a compiled prefix set: by key bytes, then shorter first,   */
+/* then by id, so equal keys keep the caller's order                        */
+static int aiu_prefix_cmp(const void *pa, const void *pb) {
+    const aiu_prefixent *a = (const aiu_prefixent *)pa;
+    const aiu_prefixent *b = (const aiu_prefixent *)pb;
+    size_t n = a->len < b->len ? a->len : b->len;
+    int c = memcmp(a->key, b->key, n);
 
-    /* This is the SUCCESS code, matching the original */
-    return retcode;
+    if (c) return c;
+    if (a->len != b->len) return a->len < b->len ? -1 : 1;
+    return (a->id > b->id) - (a->id < b->id);
 }
 
 /****************************************************************************/
-/* trim_inplace() - in-place trim - leading, trailing, or both              */
-/* "s" must be modifiable, i.e., not a read-only string literal.            */
-/* mode is one of 'l', 'r', or 'b'                                          */
+/* aiu_prefixset_compile() - compile many prefixes for one-pass matching    */
 /*                                                                          */
-/* EXAMPLE: trim_inplace(ctpr, 'r');                                        */
+/* Copies the "count" prefixes into "arena" (compile once, match many       */
+/* times), sorted, with a first-byte index over them. A prefix's ID is its  */
+/* index in "prefixes". "flags" may combine:                                */
+/*   AIU_PREFIX_NOCASE  compare with the strcmpii() folding (tolower())     */
+/*   AIU_PREFIX_FIRST   report the lowest matching ID, like a loop of       */
+/*                      strbgw() calls that stops at the first hit          */
+/* Without AIU_PREFIX_FIRST the longest match wins (lowest ID on a tie).    */
+/*                                                                          */
+/* RETURNS: 1 on success, 0 if an argument is bad or the arena is full.     */
+/*                                                                          */
+/* EXAMPLE: static const char *routes[] = { "/api/", "/api/v2/", "/" };     */
+/*          aiu_prefixset ps;                                               */
+/*          aiu_prefixset_compile(&ps, routes, 3, 0, &arena);               */
 /****************************************************************************/
-void trim_inplace(char *s, char mode) {
-    if (s == NULL) return;
+int aiu_prefixset_compile(aiu_prefixset *ps, const char *const *prefixes,
+                          size_t count, int flags, aiu_arena *arena) {
+    size_t i, n = 0;
+    int c;
 
-    size_t len = strlen(s);
-    if (len == 0) return;
+    if (ps == NULL || arena == NULL || (prefixes == NULL && count > 0)) return 0;
+    if (count > (size_t)INT32_MAX) return 0;
 
-    // --- Left Trim Logic (RUN FIRST) ---
-    if (mode == 'l' || mode == 'b') {
-        char *start = s;
-        while (*start != '\0' && isspace((unsigned char)*start)) start++;
+    for (c = 0; c < 256; c++)
+        ps->fold[c] = (flags & AIU_PREFIX_NOCASE) ? (unsigned char)AIU_TOLOWER((char)c)
+                                                  : (unsigned char)c;
+    ps->flags = flags;
+    ps->empty_id = -1;
+    ps->count = 0;
+    ps->ents = (aiu_prefixent *)aiu_arena_alloc(arena, count * sizeof(aiu_prefixent),
+                                                sizeof(void *));
+    if (ps->ents == NULL) return 0;
 
-        
-        if (start > s) {  // If had leading spaces, shift the remaining string
-            memmove(s, start, len - (start - s) + 1); 
-            len = strlen(s);     // Recalculate length for the right-trim pass
+    for (i = 0; i < count; i++) {
+        const char *p = prefixes[i];
+        size_t len = p ? strlen(p) : 0;
+        unsigned char *key;
+        size_t k;
+
+        if (p == NULL) continue;
+        if (len == 0) {                 /* "" matches everything            */
+            if (ps->empty_id < 0) ps->empty_id = (int)i;
+            continue;
         }
+        if ((key = (unsigned char *)aiu_arena_alloc(arena, len, 1)) == NULL) return 0;
+        for (k = 0; k < len; k++) key[k] = ps->fold[(unsigned char)p[k]];
+        ps->ents[n].key = key;
+        ps->ents[n].len = len;
+        ps->ents[n].id = (int)i;
+        n++;
     }
+    qsort(ps->ents, n, sizeof(aiu_prefixent), aiu_prefix_cmp);
+    ps->count = n;
 
-    // --- Right Trim Logic (RUN SECOND) ---
-    if (mode == 'r' || mode == 'b') {
-        if (len == 0) return;                    // String might be all spaces
-
-        char *end = s + len - 1;
-        while (end >= s && isspace((unsigned char)*end)) end--;
-        *(end + 1) = '\0';
+    /* ents[first[b] .. first[b+1]) are the keys starting with byte b */
+    for (c = 0, i = 0; c < 256; c++) {
+        ps->first[c] = (uint32_t)i;
+        while (i < n && ps->ents[i].key[0] == c) i++;
     }
+    ps->first[256] = (uint32_t)n;
+    return 1;
 }
 
 /****************************************************************************/
-/* trim_safe_copy() - Creates a trimmed copy of a string                    */
-/* mode: 'l' (left), 'r' (right), 'b' (both)                                */
+/* aiu_prefixset_match() - which compiled prefix does "s" start with?       */
 /*                                                                          */
-/* NOTE: This function writes to a buffer provided by the caller. This is an*/
-/*       intentional design choice to keep memory management (malloc/free)  */
-/*       at the caller's level to prevent memory leaks from a hidden malloc.*/
+/* One pass over "s": each char narrows the range of sorted keys that       */
+/* still agree with it (by binary search), and every key that ends on the   */
+/* way is a match. Cost is O(match length * log count), however many        */
+/* prefixes there are.                                                      */
 /*                                                                          */
-/* EXAMPLE: trim_safe_copy(dest, src, sizeof(dest), 'b');                   */
+/* RETURNS: The ID of the best matching prefix (see                         */
+/*          aiu_prefixset_compile()), or -1 if none matches. "*match_len"   */
+/*          (may be NULL) gets its length.                                  */
+/*                                                                          */
+/* EXAMPLE: int route = aiu_prefixset_match(&ps, path, path_len, NULL);     */
 /****************************************************************************/
-void trim_safe_copy(char *dest, const char *src, 
-                    size_t dest_size, char mode) {
-    if (src == NULL || dest == NULL || dest_size == 0) {
-        if (dest != NULL && dest_size > 0) dest[0] = '\0';
-        return;
+int aiu_prefixset_match(const aiu_prefixset *ps, const char *s, size_t len,
+                        size_t *match_len) {
+    const unsigned char *u = (const unsigned char *)s;
+    const aiu_prefixent *e;
+    size_t lo, hi, d;
+    size_t best_len = 0;
+    int best;
+
+    if (ps == NULL || (s == NULL && len > 0)) return -1;
+    best = ps->empty_id;
+    e = ps->ents;
+
+    if (len > 0 && ps->count > 0) {
+        unsigned char c = ps->fold[u[0]];
+
+        lo = ps->first[c];
+        hi = ps->first[c + 1];
+        for (d = 1; lo < hi; d++) {
+            /* Every key in [lo, hi) equals the first "d" folded chars of s */
+            if (e[lo].len == d) {       /* shortest first, lowest ID first  */
+                if (!(ps->flags & AIU_PREFIX_FIRST) || best < 0 || e[lo].id < best) {
+                    best = e[lo].id;
+                    best_len = d;
+                }
+                while (lo < hi && e[lo].len == d) lo++;
+            }
+            if (d == len || lo == hi) break;
+
+            /* Narrow to the keys whose next byte is s[d] */
+            c = ps->fold[u[d]];
+            {
+                size_t a = lo, b = hi;
+                while (a < b) {         /* first key with key[d] >= c       */
+                    size_t m = a + (b - a) / 2;
+                    if (e[m].key[d] < c) a = m + 1; else b = m;
+                }
+                lo = a;
+                b = hi;
+                while (a < b) {         /* first key with key[d] > c        */
+                    size_t m = a + (b - a) / 2;
+                    if (e[m].key[d] <= c) a = m + 1; else b = m;
+                }
+                hi = a;
+            }
+        }
     }
 
-    // 1. Copy the original string using our safe, standard function
-    strzcpy(dest, src, dest_size);
+    if (match_len) *match_len = best_len;
+    return best;
+}
+
+/* FNV-1a over ASCII-folded chars, so "Host" and "HOST" hash the same */
+static uint32_t aiu_kw_hash(const unsigned char *s, size_t len) {
+    uint32_t h = 2166136261u;
 
-    // 2. Call the in-place trim function on the copy
-    trim_inplace(dest, mode);
+    while (len--) h = (h ^ aiu_ascii_fold[*s++]) * 16777619u;
+    return h;
 }
 
 /****************************************************************************/
-/* remove_char_inplace() - remove a specified character from a string       */
+/* aiu_kwtable_build() - build a case-insensitive keyword -> ID table       */
 /*                                                                          */
-/* NOTE: "str" must be a modifiable string (e.g., an array or malloc'd).    */
-/*       Do NOT pass a string literal.                                      */
+/* Copies the "count" keywords into "arena" and indexes them in an open-    */
+/* addressed hash (at most half full) with an ASCII case-fold hash, so a    */
+/* lookup is one hash and, on average, about one strcmpii_n() however many  */
+/* keywords there are. A keyword's ID is its index in "words"; for a        */
+/* repeated keyword the first one's ID is kept.                             */
 /*                                                                          */
-/* EXAMPLE: remove_char_inplace(my_buffer, ' ');                            */
+/* RETURNS: 1 on success, 0 if an argument is bad or the arena is full.     */
+/*                                                                          */
+/* EXAMPLE: static const char *hdrs[] = { "Host", "Content-Length", ... };  */
+/*          aiu_kwtable kw;                                                 */
+/*          aiu_kwtable_build(&kw, hdrs, sizeof(hdrs) / sizeof(hdrs[0]),    */
+/*                            &arena);                                      */
 /****************************************************************************/
-void remove_char_inplace(char *str, char char_to_remove) {
-    if (str == NULL) return;
+int aiu_kwtable_build(aiu_kwtable *kw, const char *const *words, size_t count,
+                      aiu_arena *arena) {
+    size_t i, nslots = 8;
 
-    size_t i, j;
-    size_t len = strlen(str);
+    if (kw == NULL || arena == NULL || (words == NULL && count > 0)) return 0;
+    if (count > (size_t)INT32_MAX / 2) return 0;
 
-    for (i = 0, j = 0; i < len; i++) {
-        if (str[i] != char_to_remove) str[j++] = str[i];
+    while (nslots < count * 2) nslots *= 2;
+    kw->mask = nslots - 1;
+    kw->count = count;
+    kw->slots = (aiu_kwslot *)aiu_arena_alloc(arena, nslots * sizeof(aiu_kwslot),
+                                              sizeof(void *));
+    kw->words = (aiu_str *)aiu_arena_alloc(arena, (count ? count : 1) * sizeof(aiu_str),
+                                           sizeof(void *));
+    if (kw->slots == NULL || kw->words == NULL) return 0;
+    for (i = 0; i < nslots; i++) kw->slots[i].id = -1;
+
+    for (i = 0; i < count; i++) {
+        size_t len = words[i] ? strlen(words[i]) : 0;
+        char *copy = aiu_arena_strzcpy_n(arena, words[i] ? words[i] : "", len);
+        uint32_t h;
+        size_t at;
+
+        if (copy == NULL) return 0;
+        kw->words[i].ptr = copy;
+        kw->words[i].len = len;
+        if (words[i] == NULL) continue;
+
+        h = aiu_kw_hash((const unsigned char *)copy, len);
+        for (at = h & kw->mask; kw->slots[at].id >= 0; at = (at + 1) & kw->mask) {
+            const aiu_str *w = &kw->words[kw->slots[at].id];
+            if (kw->slots[at].hash == h && strcmpii_n(w->ptr, w->len, copy, len) == 0)
+                break;                  /* repeat: keep the first ID        */
+        }
+        if (kw->slots[at].id < 0) {
+            kw->slots[at].hash = h;
+            kw->slots[at].id = (int)i;
+        }
     }
-    str[j] = '\0';                       // Null-terminate the modified string
+    return 1;
 }
 
 /****************************************************************************/
-/* replace_char_inplace() - replace all instances of a char in-place        */
+/* aiu_kwtable_find() - ID of the keyword equal to "s" ignoring ASCII case  */
 /*                                                                          */
-/* NOTE: "str" must be a modifiable string (e.g., an array or malloc'd).    */
+/* RETURNS: The keyword's ID, or -1 if "s" is not a keyword.                */
 /*                                                                          */
-/* EXAMPLE: replace_char_inplace(my_buffer, ' ', '_', 0);                   */
+/* EXAMPLE: switch (aiu_kwtable_find(&kw, name.ptr, name.len)) { ... }      */
 /****************************************************************************/
-void replace_char_inplace(char *str, char ch, char newch, int skipends) {
-    if (str == NULL) return;
+int aiu_kwtable_find(const aiu_kwtable *kw, const char *s, size_t len) {
+    uint32_t h;
+    size_t at;
 
-    size_t i;
-    size_t len = strlen(str);
-    
-    if (len == 0) return;
-    
-    size_t last_index = len - 1;
+    if (kw == NULL || kw->slots == NULL || (s == NULL && len > 0)) return -1;
 
-    for(i = 0; i < len; i++) {
-       if(str[i] == ch && !(skipends && (i == 0 || i == last_index))) 
-         str[i] = newch;
+    h = aiu_kw_hash((const unsigned char *)s, len);
+    for (at = h & kw->mask; kw->slots[at].id >= 0; at = (at + 1) & kw->mask) {
+        const aiu_str *w = &kw->words[kw->slots[at].id];
+        if (kw->slots[at].hash == h && w->len == len &&
+            strcmpii_n(w->ptr, w->len, s, len) == 0)
+            return kw->slots[at].id;
     }
-    /* No need to re-terminate; length doesn't change */
+    return -1;
 }
 
 /****************************************************************************/
-/* replace_char_safe_copy() - safely copy a string, replacing a char        */
+/* Delimited records                                                        */
 /*                                                                          */
-/* Safely copies 'src' to 'dest', replacing 'ch' with 'newch'.              */
+/* aiu_csv_parse() splits CSV-style text into records and fields and runs   */
+/* each field straight through the parser its column asks for, storing the  */
+/* results in the caller's column arrays (one array per column, indexed by  */
+/* row). Fields are (ptr,len) spans into the input: nothing is copied or    */
+/* null terminated on the way to decatoi()/hexatoi()/octatoi().             */
 /*                                                                          */
-/* EXAMPLE: replace_char_safe_copy(dest, src, sizeof(dest), ' ', '_', 0);   */
+/* Each 64-byte block of a record is reduced to one bitmask of its          */
+/* delimiter and quote bytes (SSE2 compares under AIUTILS_SIMD, 8-byte      */
+/* SWAR words otherwise), and only the set bits are visited.                */
 /****************************************************************************/
-void replace_char_safe_copy(char *dest, const char *src, size_t dest_size, 
-                            char ch, char newch, int skipends) {
-    if (dest == NULL || src == NULL || dest_size == 0) {
-        if (dest_size > 0) dest[0] = '\0';
-        return;
-    }
 
-    // 1. Safely copy the string using our standard utility
-    strzcpy(dest, (char*)src, dest_size);
+/* High bit set in each zero byte of "v" (exact, unlike AIU_HAS_ZERO) */
+static uint64_t aiu_zero_bytes8(uint64_t v) {
+    const uint64_t lows = UINT64_C(0x7F7F7F7F7F7F7F7F);
 
-    // 2. Perform the replacement on the new, safe copy
-    replace_char_inplace(dest, ch, newch, skipends);
+    return ~(((v & lows) + lows) | v | lows);
 }
 
-/****************************************************************************/
-/* substring_safe_copy() - Safely copies a substring from "src" into "dest" */
-/*                                                                          */
-/* NOTE: This function writes to a buffer provided by the caller, just like */
-/*       just like strzcpy() and trim_safe_copy().                          */
-/*                                                                          */
-/* EXAMPLE: substring_safe_copy(dest, src, sizeof(dest), 5, 10);            */
-/****************************************************************************/
-void substring_safe_copy(char *dest, const char *src, size_t dest_size,
-                         size_t position, size_t length) {
-    /* --- 1. Handle Nulls and Empty Buffer --- */
-    if (dest == NULL || src == NULL || dest_size == 0) {
-        if (dest != NULL && dest_size > 0) dest[0] = '\0';
-        return;
-    }
+/* Bit i set where p[i] is "a" or "b", over the first "n" (<= 64) bytes */
+static uint64_t aiu_csv_mask(const char *p, size_t n, char a, char b) {
+    const uint64_t ones = UINT64_C(0x0101010101010101);
+    uint64_t m = 0;
+    size_t i = 0;
 
-    size_t src_len = strlen(src);
+#if defined(AIU_HAVE_SSE2)
+    if (n == 64 && AIU_VECTOR_ON()) {
+        __m128i va = _mm_set1_epi8(a), vb = _mm_set1_epi8(b);
 
-    /* --- 2. Check if start position is out-of-bounds --- */
-    if (position >= src_len) {
-        dest[0] = '\0'; /* Start is past the end, just return empty */
-        return;
+        for (; i < 64; i += 16) {
+            __m128i v = _mm_loadu_si128((const __m128i *)(p + i));
+            __m128i hit = _mm_or_si128(_mm_cmpeq_epi8(v, va), _mm_cmpeq_epi8(v, vb));
+            m |= (uint64_t)(uint32_t)_mm_movemask_epi8(hit) << i;
+        }
+        return m;
     }
+#endif
+    {
+        uint64_t ra = ones * (unsigned char)a, rb = ones * (unsigned char)b;
 
-    /* --- 3. Calculate a 100% safe copy length --- */
-    /* a) How many chars are available from the start position? */
-    size_t chars_available = src_len - position;
+        for (; i + 8 <= n; i += 8) {
+            uint64_t x = aiu_load_le64((const unsigned char *)p + i);
+            uint64_t hit = aiu_zero_bytes8(x ^ ra) | aiu_zero_bytes8(x ^ rb);
 
-    /* b) We can only copy the *smaller* of the requested length
-          and the available chars. */
-    size_t copy_len = (length < chars_available) ? length : chars_available;
+            /* Gather the 8 high bits into the low 8 bits, byte 0 first */
+            m |= (((hit >> 7) * UINT64_C(0x0102040810204080)) >> 56) << i;
+        }
+    }
+    for (; i < n; i++) if (p[i] == a || p[i] == b) m |= (uint64_t)1 << i;
+    return m;
+}
 
-    /* c) We can only copy the *smaller* of *that* length
-          and the destination buffer size (minus 1 for null). */
-    size_t max_dest_copy = dest_size - 1;
-    if (copy_len > max_dest_copy) copy_len = max_dest_copy;
+/* Parse one field span into row "row" of column "col" */
+static void aiu_csv_store(const aiu_csvcol *col, size_t row, const char *p, size_t n) {
+    aiu_str f;
+    int rc = 1;
 
-    /* --- 4. Perform the copy --- */
-    /* This is the *other* correct and safe use of strncpy:
-       copying a specific-length slice from a buffer. */
-    strncpy(dest, src + position, copy_len);
-    dest[copy_len] = '\0';
+    switch (col->type) {
+    case AIU_COL_DEC:
+        f = trim_span(p, n, 'b');
+        rc = decatoi(f.ptr, f.len, &col->ints[row]);
+        break;
+    case AIU_COL_HEX:               /* 0 and 4 are hexatoi() successes      */
+        f = trim_span(p, n, 'b');
+        rc = hexatoi(f.ptr, f.len, &col->ints[row]) != 1;
+        break;
+    case AIU_COL_OCT:
+        f = trim_span(p, n, 'b');
+        rc = octatoi(f.ptr, f.len, &col->ints[row]);
+        break;
+    case AIU_COL_STR:
+        col->strs[row].ptr = p;
+        col->strs[row].len = n;
+        break;
+    case AIU_COL_TRIM:
+        col->strs[row] = trim_span(p, n, 'b');
+        break;
+    default:
+        break;
+    }
+    if (col->rcs) col->rcs[row] = rc;
 }
 
 /****************************************************************************/
-/* strcasestr() - case-insensitive string search (replaces strstr)          */
+/* aiu_csv_init() - set up a record parser over caller-owned column arrays  */
 /*                                                                          */
-/* Finds the first occurrence of "needle" in "haystack", ignoring case.     */
+/* "cols" is the schema: field i of every record goes to cols[i], parsed    */
+/* as cols[i].type. Numeric columns need "ints" and string columns need     */
+/* "strs", each with room for "max_rows" entries; "rcs" is optional.        */
+/* "quote" is '\0' to treat quote characters as ordinary text.              */
 /*                                                                          */
-/* EXAMPLE: const char *p = strcasestr("Hello World", "world"); // p points to "World" */
+/* NOTE: "cols" and its arrays are not copied; keep them alive while the    */
+/*       parser is in use.                                                  */
+/*                                                                          */
+/* RETURNS: 1 on success, 0 if an argument or a column is bad.              */
+/*                                                                          */
+/* EXAMPLE: int64_t ids[256]; aiu_str names[256];                           */
+/*          aiu_csvcol cols[2] = { { AIU_COL_DEC, ids, NULL, NULL },        */
+/*                                 { AIU_COL_TRIM, NULL, names, NULL } };   */
+/*          aiu_csv csv;                                                    */
+/*          aiu_csv_init(&csv, cols, 2, 256, ',', '"');                     */
 /****************************************************************************/
-#if defined(_WIN32) || defined(_MSC_VER)
-const char *strcasestr(const char *haystack, const char *needle) {
-    if (haystack == NULL || needle == NULL) return NULL;
-    if (*needle == '\0') return haystack;
-
-    size_t needle_len = strlen(needle);
-
-    for (; *haystack; haystack++) {
-        /* Check for a match of the *first* character */
-        if (toupper((unsigned char)*haystack) == toupper((unsigned char)*needle)) {
-            /* If first char matched, check the rest of the string */
-            const char *h = haystack;
-            const char *n = needle;
-            size_t i = 0;
-
-            for (i = 0; i < needle_len; i++) {
-                /* Check for end of haystack *before* end of needle */
-                if (*h == '\0') return NULL; 
-                
-                if (toupper((unsigned char)*h) != toupper((unsigned char)*n))
-                  break; /* Mismatch, break inner loop */
-                h++;
-                n++;
-            }
+int aiu_csv_init(aiu_csv *c, const aiu_csvcol *cols, size_t ncols,
+                 size_t max_rows, char delim, char quote) {
+    size_t i;
 
-            /* If loop finished, we found a full match */
-            if (i == needle_len) return haystack; /* Success! */
+    if (c == NULL || (cols == NULL && ncols > 0)) return 0;
+    if (delim == '\0' || delim == '\n' || delim == '\r' || delim == quote) return 0;
+    if (quote == '\n' || quote == '\r') return 0;
+
+    for (i = 0; i < ncols; i++) {
+        switch (cols[i].type) {
+        case AIU_COL_SKIP:
+            break;
+        case AIU_COL_DEC: case AIU_COL_HEX: case AIU_COL_OCT:
+            if (cols[i].ints == NULL && max_rows > 0) return 0;
+            break;
+        case AIU_COL_STR: case AIU_COL_TRIM:
+            if (cols[i].strs == NULL && max_rows > 0) return 0;
+            break;
+        default:
+            return 0;
         }
     }
-    
-    return NULL; /* No match found */
+
+    c->cols = cols;
+    c->ncols = ncols;
+    c->rows = 0;
+    c->max_rows = max_rows;
+    c->delim = delim;
+    c->quote = quote;
+    return 1;
 }
-#endif
 
 /****************************************************************************/
-/* safe_gets() - safe line reader that strips the newline (replaces fgets)  */
+/* aiu_csv_parse_record() - parse one record (a line, without its newline)  */
 /*                                                                          */
-/* RETURNS: The "buf" pointer on success, or NULL on EOF or error.          */
+/* Stores the record's fields as row c->rows of the columns, then counts    */
+/* the row. Numeric fields are trimmed of blanks on both ends and parsed    */
+/* exactly as decatoi()/hexatoi()/octatoi() would; a field that fails       */
+/* leaves its "ints" entry as that parser does and stores 0 in "rcs"        */
+/* (hexatoi()'s 0 and 4 codes are both stored as 1). Fields missing from a  */
+/* short record are parsed as empty; extra fields are ignored.              */
 /*                                                                          */
-/* EXAMPLE: char line[100];                                                 */
-/*          if (safe_gets(line, sizeof(line), stdin) != NULL) { ... }       */
+/* A field that starts with the quote character is quoted: delimiters       */
+/* inside it are text, "" is an escaped quote, and the stored span is the   */
+/* text between the quotes. Anything between the closing quote and the      */
+/* next delimiter is dropped; an unclosed quote runs to the end of line.    */
+/*                                                                          */
+/* NOTE: The span of a quoted field still holds each escaped quote as "",   */
+/*       since the input is never rewritten. Records cannot span lines.     */
+/*                                                                          */
+/* RETURNS: The number of fields in the record, or -1 if the column arrays  */
+/*          are full (c->rows == c->max_rows) or an argument is bad.        */
+/*                                                                          */
+/* EXAMPLE: aiu_csv_parse_record(&csv, line.ptr, line.len);                 */
 /****************************************************************************/
-char *safe_gets(char *buf, size_t buf_size, FILE *stream) {
-    if (buf == NULL || buf_size == 0 || stream == NULL) return NULL;
+int aiu_csv_parse_record(aiu_csv *c, const char *line, size_t len) {
+    size_t row, field = 0, start = 0, end = 0, skip = 0, base, nfields;
+    int in_quote = 0, quoted = 0;
+    char q;
 
-    /* 1. Read the line using fgets */
-    if (fgets(buf, (int)buf_size,stream) == NULL) return NULL; /* Error/EOF */
+    if (c == NULL || c->rows >= c->max_rows || (line == NULL && len > 0)) return -1;
+    if (line == NULL) line = "";
+    row = c->rows;
+    q = c->quote ? c->quote : c->delim; /* no quoting: only look for delims */
 
-    /* 2. Find and remove the newline character
-     * strcspn() finds the index of the first '\n' or '\r'.
-     * This is a safe way to find the end of the line.
-     */
-    size_t len = strcspn(buf, "\r\n");
-    buf[len] = '\0';
+    for (base = 0; base < len; base += 64) {
+        uint64_t m = aiu_csv_mask(line + base, len - base < 64 ? len - base : 64,
+                                  c->delim, q);
+        while (m) {
+            size_t at = base + aiu_ctz64(m);
 
-    /* 3. Handle a potential buffer-fill edge case
-     * If len == buf_size - 1 AND the last char isn't '\0' (from
-     * our strip), it means fgets() stopped *because the buffer
-     * was full* and the newline is still in the input stream.
-     * We must clear it to prevent it from being read by the
-     * *next* call to safe_gets().
-     */
-    if (len == buf_size - 1 && buf[len] != '\0') {
-        int ch;
-        while ((ch = fgetc(stream)) != '\n' && ch != EOF);
+            m &= m - 1;
+            if (at < skip) continue;    /* second quote of an escaped ""    */
+            if (in_quote) {
+                if (line[at] != c->quote) continue; /* delimiter as text    */
+                if (at + 1 < len && line[at + 1] == c->quote) {
+                    skip = at + 2;
+                    continue;
+                }
+                in_quote = 0;
+                end = at;
+            } else if (line[at] == c->delim) {
+                if (!quoted) end = at;
+                if (field < c->ncols)
+                    aiu_csv_store(&c->cols[field], row, line + start + quoted,
+                                  end - start - quoted);
+                field++;
+                start = at + 1;
+                quoted = 0;
+            } else if (at == start) {   /* a quote opens only a field       */
+                in_quote = quoted = 1;
+            }
+        }
     }
 
-    return buf;
+    /* Last field, then empty fields for any columns the record lacks */
+    if (!quoted || in_quote) end = len;
+    if (field < c->ncols)
+        aiu_csv_store(&c->cols[field], row, line + start + quoted, end - start - quoted);
+    nfields = ++field;
+    for (; field < c->ncols; field++) aiu_csv_store(&c->cols[field], row, line + len, 0);
+
+    c->rows++;
+    return (int)(nfields > INT32_MAX ? INT32_MAX : nfields);
 }
 
 /****************************************************************************/
-/* safe_strtok() - safe, re-entrant string tokenizer (replaces strtok)      */
+/* aiu_csv_parse() - parse the records in a buffer into the column arrays   */
 /*                                                                          */
-/* A safe, re-entrant wrapper for the platform-specific tokenizer           */
-/* (strtok_r / strtok_s) that replaces the standard, unsafe strtok().       */
+/* Runs aiu_csv_parse_record() on each line of "data" (as returned by       */
+/* aiu_linereader_init_mem(), so a "\r\n" ending is dropped), skipping      */
+/* empty lines, until the data ends or the column arrays are full.          */
+/* "*consumed", if not NULL, is set to the number of bytes used, so a full  */
+/* batch can be processed and the parse resumed at data + *consumed after   */
+/* setting c->rows back to 0.                                               */
 /*                                                                          */
-/* WHY IT'S NEEDED: The standard strtok() is *not re-entrant*. It uses a    */
-/* hidden internal static pointer to maintain state. Thus, dangerous for:   */
-/* 1. Nested loops (an inner strtok() call will break an outer one).        */
-/* 2. Multi-threaded applications.                                          */
+/* RETURNS: The number of records stored by this call.                      */
 /*                                                                          */
-/* This function fixes the problem by forcing the caller to provide a       */
-/* state pointer ("save_ptr"), which is the correct, safe pattern.          */
+/* EXAMPLE: while (pos < len) {                                             */
+/*              csv.rows = 0;                                               */
+/*              if (!aiu_csv_parse(&csv, data + pos, len - pos, &used))     */
+/*                  break;                                                  */
+/*              pos += used;    // ... use the csv.rows rows ...            */
+/*          }                                                               */
+/****************************************************************************/
+size_t aiu_csv_parse(aiu_csv *c, const char *data, size_t len, size_t *consumed) {
+    aiu_linereader lr;
+    aiu_str line;
+    size_t first;
+
+    if (consumed) *consumed = 0;
+    if (c == NULL || (data == NULL && len > 0)) return 0;
+
+    first = c->rows;
+    aiu_linereader_init_mem(&lr, data, len);
+    while (c->rows < c->max_rows && aiu_linereader_next(&lr, &line)) {
+        if (line.len > 0) aiu_csv_parse_record(c, line.ptr, line.len);
+    }
+    if (consumed) *consumed = lr.pos;
+    return c->rows - first;
+}
+
+/****************************************************************************/
+/* CPU dispatch                                                             */
 /*                                                                          */
-/* NOTE: This function *modifies* the "str" buffer in-place by writing      */
-/* null terminators. "str" must be modifiable.                              */
+/* A -DAIUTILS_SIMD build carries every block kernel its target can use and */
+/* binds one set of them on first use, from what the running CPU supports   */
+/* (cpuid on x86, getauxval() on Linux/ARM64): AVX2 where the CPU has it,   */
+/* else SSE2 on x86-64, NEON on ARM64, and the word-at-a-time kernels on    */
+/* other targets. One binary therefore runs at full speed on old and new    */
+/* machines alike.                                                          */
 /*                                                                          */
-/* EXAMPLE:                                                                 */
-/* char my_str[] = "a,b,c";                                                 */
-/* char *save_ptr;                                                          */
-/* char *token = safe_strtok(my_str, ",", &save_ptr);                       */
-/* while (token != NULL) {                                                  */
-/*   // use token                                                           */
-/*   token = safe_strtok(NULL, ",", &save_ptr);                             */
-/* }                                                                        */
+/* Setting the environment variable AIUTILS_CPU to the name of a lower      */
+/* variant forces it for the whole process: "scalar" turns every block      */
+/* kernel off, and on x86 "sse2" turns AVX2 off. It is read once, when the  */
+/* kernels are bound. Names of variants the CPU lacks are ignored.          */
 /****************************************************************************/
-char *safe_strtok(char *str, const char *delim, char **save_ptr)
-{
-/* Use the correct, safe function based on the operating system */
-#if defined(_WIN32) || defined(_MSC_VER)
-    return strtok_s(str, delim, save_ptr);
+
+/****************************************************************************/
+/* aiu_cpu_variant() - the kernel variant this process runs                 */
+/*                                                                          */
+/* Binds the kernels if nothing has used them yet, so calling it at startup */
+/* also moves the one-time CPU probe out of the first string call.          */
+/*                                                                          */
+/* RETURNS: AIU_VARIANT_SCALAR, _SWAR, _SSE2, _AVX2 or _NEON. A build       */
+/*          without AIUTILS_SIMD is always AIU_VARIANT_SCALAR.              */
+/*                                                                          */
+/* EXAMPLE: if (aiu_cpu_variant() == AIU_VARIANT_SCALAR) { ... }            */
+/****************************************************************************/
+int aiu_cpu_variant(void) {
+#if defined(AIUTILS_SIMD)
+    return aiu_kernels_get()->variant;
 #else
-    return strtok_r(str, delim, save_ptr);
+    return AIU_VARIANT_SCALAR;
 #endif
 }
 
 /****************************************************************************/
-/* laststrstr() - Find the last occurrence of "needle" in "haystack"        */
+/* aiu_cpu_variant_name() - name of the kernel variant this process runs    */
 /*                                                                          */
-/* EXAMPLE: const char *p = laststrstr("a-b-c", "-"); // p points to "-c"   */
+/* RETURNS: "scalar", "swar", "sse2", "avx2" or "neon" (a static string).   */
+/*                                                                          */
+/* EXAMPLE: log_info("aiutils kernels: %s", aiu_cpu_variant_name());        */
 /****************************************************************************/
-const char *laststrstr(const char *haystack, const char *needle) {
-    if (haystack == NULL || needle == NULL) return NULL;
-
-    size_t needle_len = strlen(needle);
-    
-    /* CRITICAL FIX: Empty needle always matches the end of the string */
-    if (needle_len == 0) return (haystack + strlen(haystack));
-
-    const char *last_match = NULL;
-    const char *p;
-
-    /* Find all matches and just remember the last one */
-    for (p = haystack; (p = strstr(p, needle)) != NULL; p++) {
-        last_match = p;
-    }
-
-    return last_match;
+const char *aiu_cpu_variant_name(void) {
+#if defined(AIUTILS_SIMD)
+    return aiu_kernels_get()->name;
+#else
+    return "scalar";
+#endif
 }
 
 /****************************************************************************/
-/* lastN() - get the last n characters of a string                          */
+/* aiu_cpu_features() - CPU features found when the kernels were bound      */
 /*                                                                          */
-/* Returns a pointer to the last 'n' characters of 's'.                     */
-/* If 'n' > strlen(s), returns 's'.                                         */
+/* Reports what the CPU has, whatever AIUTILS_CPU forced, so a log line of  */
+/* both tells a forced variant from a missing feature. AVX-512 is reported  */
+/* for that purpose only; there are no AVX-512 kernels, so such CPUs run    */
+/* the AVX2 ones.                                                           */
 /*                                                                          */
-/* EXAMPLE: const char *p = lastN("hello", 3); // p points to "llo"         */
+/* RETURNS: AIU_CPU_* bits, or 0 in a build without AIUTILS_SIMD (which     */
+/*          never probes the CPU).                                          */
+/*                                                                          */
+/* EXAMPLE: if (aiu_cpu_features() & AIU_CPU_AVX2) { ... }                  */
 /****************************************************************************/
-const char *lastN(const char *s, size_t n) {
-   size_t length = strlen(s);
-   return (length < n ? s : s + length - n);
-} 
+unsigned aiu_cpu_features(void) {
+#if defined(AIUTILS_SIMD)
+    aiu_kernels_get();
+    return AIU_READ(&aiu_cpu_found);
+#else
+    return 0;
+#endif
+}
 
 /****************************************************************************/
-/* uppercase_inplace() - convert line to uppercase, in-place                */
+/* aiu_stats_snapshot() - totals of the AIUTILS_STATS call counters         */
 /*                                                                          */
-/* NOTE: "line" must be a modifiable string (e.g., an array or malloc'd).   */
+/* Sums every thread's counters into "stats", indexed by AIU_STAT_*.        */
+/* Each counter is read atomically, but threads keep counting while the     */
+/* sum is taken, so the totals are a near-instant, not a frozen, view.      */
+/* Counters only ever grow; diff two snapshots to get a rate.               */
 /*                                                                          */
-/* EXAMPLE: uppercase_inplace(my_buffer);                                   */
+/* RETURNS: 1, or 0 with "stats" zeroed if built without AIUTILS_STATS.     */
+/*                                                                          */
+/* EXAMPLE: aiu_stat st[AIU_STAT_COUNT];                                    */
+/*          aiu_stats_snapshot(st);                                         */
+/*          printf("%s cut %llu times\n", aiu_stats_name(AIU_STAT_STRZCPY), */
+/*                 (unsigned long long)st[AIU_STAT_STRZCPY].truncations);   */
 /****************************************************************************/
-void uppercase_inplace(char *line) {
-    if (line == NULL) return;
+int aiu_stats_snapshot(aiu_stat stats[AIU_STAT_COUNT]) {
+    if (stats == NULL) return 0;
+    memset(stats, 0, sizeof(aiu_stat) * AIU_STAT_COUNT);
+
+#if defined(AIUTILS_STATS)
+    {
+        size_t i;
+        int fn;
 
-    for (; *line; line++) {
-        /* CRITICAL FIX: Cast to (unsigned char) */
-        if (islower((unsigned char)*line)) {
-            *line = (char)toupper((unsigned char)*line);
+        for (i = 0; i <= AIU_STATS_SLOTS; i++) {
+            for (fn = 0; fn < AIU_STAT_COUNT; fn++) {
+                const aiu_stat *st = &aiu_statslots[i].fn[fn];
+                stats[fn].calls += AIU_STAT_LOAD(&st->calls);
+                stats[fn].bytes += AIU_STAT_LOAD(&st->bytes);
+                stats[fn].truncations += AIU_STAT_LOAD(&st->truncations);
+            }
         }
     }
+    return 1;
+#else
+    return 0;
+#endif
 }
 
 /****************************************************************************/
-/* makelower_safe_copy() - safely copy a string, making it lowercase        */
+/* aiu_stats_name() - function name of an AIU_STAT_* index                  */
 /*                                                                          */
-/* EXAMPLE: makelower_safe_copy(dest, src, sizeof(dest));                   */
+/* RETURNS: A static string such as "strzcpy", or "?" for a bad index.      */
 /****************************************************************************/
-void makelower_safe_copy(char *dest, const char *src, size_t dest_size) {
-    if (dest == NULL || src == NULL || dest_size == 0) {
-        if (dest != NULL && dest_size > 0) dest[0] = '\0';
-        return;
-    }
-    
-    /* Loop as long as there is source and we have room in dest */
-    while (*src && --dest_size > 0) {
-        /* CRITICAL FIX: Cast to (unsigned char) */
-        *dest++ = isupper((unsigned char)*src) ? 
-                    (char)tolower((unsigned char)*src) : *src;
-        src++;
-    }
-    
-    /* Always null-terminate */
-    *dest = '\0';
+const char *aiu_stats_name(int fn) {
+    static const char *const names[AIU_STAT_COUNT] = {
+        "strzcpy", "strzcat", "strzcpy_n", "strzcat_at", "substring_safe_copy",
+        "trim_safe_copy", "replace_char_safe_copy", "makelower_safe_copy",
+        "safe_gets"
+    };
+
+    return (fn >= 0 && fn < AIU_STAT_COUNT) ? names[fn] : "?";
 }
@@ -1,3 +1,6 @@
+#ifndef AIUTILS_H
+#define AIUTILS_H
+
 /* Required headers */
 #include <errno.h>  /* For errno, ERANGE */
 #include <stdlib.h> /* For strtoll */
@@ -6,39 +9,351 @@
 #include <stdint.h> /* For int64_t */
 #include <stdio.h>
 #include <ctype.h>  /* For toupper */
+#include <time.h>   /* For struct tm, time_t */
+
+/* --- Build Mode --- */
+/* By default every function is compiled once, in aiutils.c. Define         */
+/* AIUTILS_HEADER_ONLY before including this header (and do not link        */
+/* aiutils.c) to get every function as "static inline" in each file that    */
+/* includes it instead, so short calls inline and constant sizes fold.      */
+/* Internal state is then per file too: each file binds its own CPU kernels */
+/* and keeps its own AIUTILS_STATS counters and time cache.                 */
+#if defined(AIUTILS_HEADER_ONLY)
+#if defined(_MSC_VER) && !defined(__cplusplus)
+#define AIU_API static __inline
+#elif (defined(__GNUC__) || defined(__clang__)) && !defined(__cplusplus)
+#define AIU_API static __inline__
+#else
+#define AIU_API static inline
+#endif
+#else
+#define AIU_API
+#endif
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/* --- Length-Carrying String View --- */
+typedef struct aiu_str {
+    const char *ptr;                /* first char; need not be terminated   */
+    size_t      len;                /* number of chars                      */
+} aiu_str;
 
 /* --- Safe String Copy & Concat --- */
-void strzcpy(char *d, const char *s, size_t dsize);
-void strzcat(char *d, const char *s, size_t dsize);
-void numzcat(char *d, uint32_t n, size_t dsize);
+AIU_API void strzcpy(char *d, const char *s, size_t dsize);
+AIU_API void strzcat(char *d, const char *s, size_t dsize);
+AIU_API void numzcat(char *d, uint32_t n, size_t dsize);
+
+/* --- Length-Returning Copy & Concat (for long append chains) --- */
+typedef struct aiu_cursor {
+    char   *buf;                    /* target buffer                        */
+    size_t  size;                   /* total size of "buf", including null  */
+    size_t  len;                    /* current length (offset of the null)  */
+    int     truncated;              /* set once any append was cut short    */
+} aiu_cursor;
+
+AIU_API size_t strzcpy_n(char *d, const char *s, size_t dsize, int *truncated);
+AIU_API size_t strzcat_at(char *d, size_t dlen, const char *s, size_t dsize, int *truncated);
+AIU_API size_t numzcat_at(char *d, size_t dlen, uint32_t n, size_t dsize, int *truncated);
+AIU_API void aiu_cursor_init(aiu_cursor *c, char *buf, size_t size);
+AIU_API size_t aiu_cursor_cat(aiu_cursor *c, const char *s);
+AIU_API size_t aiu_cursor_num(aiu_cursor *c, uint32_t n);
 
 /* --- Safe String Conversion --- */
-int decatoi(const char *string, size_t length, int64_t *value);
-int hexatoi(const char *string, size_t length, int64_t *value);
-void fitoa(uint32_t n, size_t wid, char *s);
+AIU_API int decatoi(const char *string, size_t length, int64_t *value);
+AIU_API size_t decatoi_batch(const aiu_str *fields, size_t count, int64_t *values, int *rcs);
+AIU_API int hexatoi(const char *string, size_t length, int64_t *value);
+AIU_API size_t hexatoi_batch(const aiu_str *fields, size_t count, int64_t *values, int *rcs);
+AIU_API int octatoi(const char *string, size_t length, int64_t *value);
+AIU_API void fitoa(uint32_t n, size_t wid, char *s);
+AIU_API void fitoa64(uint64_t n, size_t wid, char *s);
+AIU_API void fitoa_column(const uint32_t *values, size_t count, size_t wid, char *s, size_t stride);
+AIU_API size_t fitoa_batch(const uint32_t *values, size_t count, size_t wid, char *s, int *rcs);
 
 /* --- Safe String Comparison & Search --- */
-int strcmpii(const char *s1, const char *s2);
-int strbgw(const char *str, const char *sub);
+AIU_API int strcmpii(const char *s1, const char *s2);
+AIU_API int strcmpii_n(const char *s1, size_t len1, const char *s2, size_t len2);
+AIU_API int strbgw(const char *str, const char *sub);
 #if defined(_WIN32) || defined(_MSC_VER)
 /* Windows doesn't have strcasestr, so we declare our own */
-const char *strcasestr(const char *haystack, const char *needle);
+AIU_API const char *strcasestr(const char *haystack, const char *needle);
 #endif
-const char *laststrstr(const char *haystack, const char *needle);
-const char *lastN(const char *s, size_t n);
+AIU_API const char *laststrstr(const char *haystack, const char *needle);
+AIU_API const char *laststrstr_n(const char *haystack, size_t hay_len, const char *needle, size_t needle_len);
+AIU_API const char *lastN(const char *s, size_t n);
+AIU_API const char *lastN_n(const char *s, size_t len, size_t n);
+
+/* --- Compiled Case-Insensitive Search (all platforms) --- */
+typedef struct aiu_casesearch {
+    const char   *needle;           /* caller's needle, not copied          */
+    size_t        len;              /* strlen(needle)                       */
+    size_t        skip[256];        /* Horspool shift per folded char       */
+    unsigned char fold[256];        /* byte -> toupper(byte)                */
+    unsigned char first[2];         /* bytes that fold to needle[0]         */
+    unsigned char last[2];          /* bytes that fold to needle[len-1]     */
+    int           filter;           /* first/last block filter usable       */
+} aiu_casesearch;
+
+AIU_API int aiu_casesearch_compile(aiu_casesearch *cs, const char *needle);
+AIU_API const char *aiu_casesearch_find(const aiu_casesearch *cs, const char *hay, size_t len);
 
 /* --- Safe String Manipulation (In-Place) --- */
-void trim_inplace(char *s, char mode);
-void remove_char_inplace(char *str, char char_to_remove);
-void replace_char_inplace(char *str, char ch, char newch, int skipends);
-void uppercase_inplace(char *line);
+AIU_API void trim_inplace(char *s, char mode);
+AIU_API size_t trim_inplace_n(char *s, size_t len, char mode);
+AIU_API void remove_char_inplace(char *str, char char_to_remove);
+AIU_API size_t remove_char_inplace_n(char *str, size_t len, char char_to_remove);
+AIU_API void replace_char_inplace(char *str, char ch, char newch, int skipends);
+AIU_API void replace_char_inplace_n(char *str, size_t len, char ch, char newch, int skipends);
+AIU_API void uppercase_inplace(char *line);
+AIU_API void uppercase_inplace_n(char *s, size_t len);
+AIU_API void lowercase_inplace(char *line);
+AIU_API void lowercase_inplace_n(char *s, size_t len);
+
+/* --- One-Pass Multi-Char Replace/Delete --- */
+typedef struct aiu_charmap {
+    unsigned char map[256];         /* byte -> replacement byte             */
+    uint32_t      del[8];           /* 256-bit set of bytes to delete       */
+    unsigned char list[8];          /* first 8 changed bytes, for blocks    */
+    int           count;            /* number of bytes changed or deleted   */
+    int           deletes;          /* any byte is deleted                  */
+} aiu_charmap;
+
+AIU_API int aiu_charmap_compile(aiu_charmap *cm, const char *from, const char *to, const char *del);
+AIU_API size_t aiu_translate_inplace(const aiu_charmap *cm, char *s, size_t len, int skipends);
+AIU_API size_t aiu_translate_copy(const aiu_charmap *cm, char *dest, const char *src, size_t src_len, size_t dest_size, int skipends);
 
 /* --- Safe String Manipulation (Copying) --- */
-void trim_safe_copy(char *dest, const char *src, size_t dest_size, char mode);
-void replace_char_safe_copy(char *dest, const char *src, size_t dest_size, char ch, char newch, int skipends);
-void substring_safe_copy(char *dest, const char *src, size_t dest_size, size_t position, size_t length);
-void makelower_safe_copy(char *dest, const char *src, size_t dest_size);
+AIU_API void trim_safe_copy(char *dest, const char *src, size_t dest_size, char mode);
+AIU_API aiu_str trim_span(const char *s, size_t len, char mode);
+AIU_API void replace_char_safe_copy(char *dest, const char *src, size_t dest_size, char ch, char newch, int skipends);
+AIU_API size_t replace_char_safe_copy_n(char *dest, const char *src, size_t src_len, size_t dest_size, char ch, char newch, int skipends);
+AIU_API void substring_safe_copy(char *dest, const char *src, size_t dest_size, size_t position, size_t length);
+AIU_API size_t substring_safe_copy_n(char *dest, const char *src, size_t src_len, size_t dest_size, size_t position, size_t length);
+AIU_API void makelower_safe_copy(char *dest, const char *src, size_t dest_size);
+
+/* --- Fixed-Width Slicing (many fields of one record per call) --- */
+typedef struct aiu_slice {
+    size_t position;                /* offset of the field in the record    */
+    size_t length;                  /* chars wanted                         */
+    char  *dest;                    /* aiu_slice_copy() target, or NULL     */
+    size_t dest_size;               /* size of "dest", including the null   */
+} aiu_slice;
+
+AIU_API size_t aiu_slice_copy(const char *src, size_t src_len, const aiu_slice *slices, size_t count, size_t *lens);
+AIU_API size_t aiu_slice_spans(const char *src, size_t src_len, const aiu_slice *slices, size_t count, aiu_str *spans);
 
 /* --- Safe Line Reading & Tokenizing --- */
-char *safe_gets(char *buf, size_t buf_size, FILE *stream);
-char *safe_strtok(char *str, const char *delim, char **save_ptr);
+AIU_API char *safe_gets(char *buf, size_t buf_size, FILE *stream);
+AIU_API char *safe_strtok(char *str, const char *delim, char **save_ptr);
+AIU_API struct tm *safe_gmtime(const time_t *timer, struct tm *result);
+
+/* --- Fast UTC Time (arithmetic, per-thread day cache) --- */
+#define AIU_ISO8601_LEN 20          /* "YYYY-MM-DDTHH:MM:SSZ"               */
+AIU_API int aiu_gmtime(int64_t secs, struct tm *out);
+AIU_API size_t aiu_format_iso8601(int64_t secs, char *buf, size_t size);
+
+/* --- Buffered Line Reading (block reads, zero-copy line spans) --- */
+typedef struct aiu_linereader {
+    FILE   *stream;
+    char   *buf;                    /* caller's block buffer                */
+    size_t  size;                   /* size of "buf"                        */
+    size_t  pos;                    /* start of unread data in "buf"        */
+    size_t  len;                    /* end of valid data in "buf"           */
+    int     eof;                    /* the stream has no more data          */
+    int     skipping;               /* discarding the rest of a long line   */
+    int     truncated;              /* the last line returned was cut short */
+} aiu_linereader;
+
+AIU_API int aiu_linereader_init(aiu_linereader *lr, FILE *stream, char *buf, size_t buf_size);
+AIU_API int aiu_linereader_next(aiu_linereader *lr, aiu_str *line);
+AIU_API int aiu_linereader_init_mem(aiu_linereader *lr, const char *data, size_t len);
+
+/* --- Memory-Mapped Files (read-only) --- */
+typedef struct aiu_mapfile {
+    const char *data;               /* file contents, not null terminated   */
+    size_t      len;                /* file size                            */
+    int         mapped;             /* a mapping must be released           */
+} aiu_mapfile;
+
+AIU_API int aiu_mapfile_open(aiu_mapfile *mf, const char *path);
+AIU_API void aiu_mapfile_close(aiu_mapfile *mf);
+
+/* --- Parallel Line Processing (newline-aligned chunks, one per thread) --- */
+#define AIU_MAX_THREADS 64
+typedef void (*aiu_line_fn)(void *state, const aiu_str *line);
+
+AIU_API size_t aiu_parallel_lines(const char *data, size_t len, int nthreads, aiu_line_fn fn, void *states, size_t state_size);
+AIU_API int aiu_parallel_file(const char *path, int nthreads, aiu_line_fn fn, void *states, size_t state_size, size_t *lines);
+
+/* --- Zero-Copy Tokenizing (spans; the input is never written) --- */
+typedef struct aiu_delims {
+    uint32_t      bits[8];          /* 256-bit delimiter bitmap             */
+    unsigned char list[4];          /* first 4 delimiters, for block scans  */
+    int           count;            /* number of distinct delimiters        */
+} aiu_delims;
+
+typedef struct aiu_tokenizer {
+    const char       *p;            /* next char to look at                 */
+    const char       *end;          /* one past the last char               */
+    const aiu_delims *delims;
+} aiu_tokenizer;
+
+AIU_API void aiu_delims_init(aiu_delims *d, const char *delim);
+AIU_API void aiu_tok_init(aiu_tokenizer *t, const char *s, size_t len, const aiu_delims *d);
+AIU_API int aiu_tok_next(aiu_tokenizer *t, aiu_str *tok);
+AIU_API size_t aiu_split(const char *s, size_t len, const aiu_delims *d, aiu_str *fields, size_t max_fields, int keep_empty);
+
+/* --- Arena Allocation (caller-owned memory; still no hidden malloc) --- */
+typedef struct aiu_arena {
+    char   *base;                   /* caller's memory                      */
+    size_t  size;                   /* size of "base"                       */
+    size_t  used;                   /* bytes handed out so far              */
+    size_t  last;                   /* offset of the latest allocation      */
+    int     full;                   /* an allocation failed since reset     */
+} aiu_arena;
+
+AIU_API void aiu_arena_init(aiu_arena *a, void *mem, size_t size);
+AIU_API void aiu_arena_reset(aiu_arena *a);
+AIU_API void *aiu_arena_alloc(aiu_arena *a, size_t n, size_t align);
+AIU_API char *aiu_arena_strzcpy(aiu_arena *a, const char *s);
+AIU_API char *aiu_arena_strzcpy_n(aiu_arena *a, const char *s, size_t len);
+AIU_API char *aiu_arena_strzcat(aiu_arena *a, char *d, const char *s);
+AIU_API char *aiu_arena_substring(aiu_arena *a, const char *src, size_t src_len, size_t position, size_t length);
+AIU_API char *aiu_arena_tok_next(aiu_arena *a, aiu_tokenizer *t);
+
+/* --- Growable String Builder (in an arena, or on the heap) --- */
+typedef struct aiu_sb {
+    char      *buf;                 /* text; not null terminated until cstr */
+    size_t     len;                 /* chars appended                       */
+    size_t     cap;                 /* chars that fit, less the null        */
+    aiu_arena *arena;               /* grow in here; NULL for the heap      */
+    int        failed;              /* an append ran out of memory          */
+} aiu_sb;
+
+AIU_API void aiu_sb_init(aiu_sb *sb, aiu_arena *arena);
+AIU_API int aiu_sb_reserve(aiu_sb *sb, size_t extra);
+AIU_API int aiu_sb_append(aiu_sb *sb, const char *s, size_t len);
+AIU_API int aiu_sb_append_str(aiu_sb *sb, const char *s);
+AIU_API int aiu_sb_append_char(aiu_sb *sb, char c);
+AIU_API int aiu_sb_append_u32(aiu_sb *sb, uint32_t n);
+AIU_API int aiu_sb_append_i64(aiu_sb *sb, int64_t n);
+AIU_API int aiu_sb_append_hex(aiu_sb *sb, uint64_t n, size_t min_digits);
+AIU_API int aiu_sb_append_padded(aiu_sb *sb, const char *s, size_t len, size_t width, char pad, char mode);
+AIU_API const char *aiu_sb_cstr(aiu_sb *sb);
+AIU_API aiu_str aiu_sb_view(const aiu_sb *sb);
+AIU_API void aiu_sb_reset(aiu_sb *sb);
+AIU_API void aiu_sb_free(aiu_sb *sb);
+
+/* --- Prefix Sets (strbgw() against many prefixes in one pass) --- */
+#define AIU_PREFIX_NOCASE 1         /* fold like strcmpii()                 */
+#define AIU_PREFIX_FIRST  2         /* lowest ID wins instead of longest    */
+
+typedef struct aiu_prefixent {
+    const unsigned char *key;       /* folded copy, in the arena            */
+    size_t               len;
+    int                  id;        /* index in the caller's prefix array   */
+} aiu_prefixent;
+
+typedef struct aiu_prefixset {
+    aiu_prefixent *ents;            /* sorted keys, in the arena            */
+    size_t         count;
+    uint32_t       first[257];      /* first-byte index into "ents"         */
+    unsigned char  fold[256];       /* byte -> compared byte                */
+    int            flags;
+    int            empty_id;        /* ID of a "" prefix, or -1             */
+} aiu_prefixset;
+
+AIU_API int aiu_prefixset_compile(aiu_prefixset *ps, const char *const *prefixes, size_t count, int flags, aiu_arena *arena);
+AIU_API int aiu_prefixset_match(const aiu_prefixset *ps, const char *s, size_t len, size_t *match_len);
+
+/* --- Case-Insensitive Keyword Tables (hashed; O(1) lookup) --- */
+typedef struct aiu_kwslot {
+    uint32_t hash;                  /* folded hash of the keyword           */
+    int      id;                    /* keyword ID; -1 for a free slot       */
+} aiu_kwslot;
+
+typedef struct aiu_kwtable {
+    aiu_kwslot *slots;              /* open-addressed, in the arena         */
+    size_t      mask;               /* number of slots - 1                  */
+    aiu_str    *words;              /* keyword copies by ID, in the arena   */
+    size_t      count;
+} aiu_kwtable;
+
+AIU_API int aiu_kwtable_build(aiu_kwtable *kw, const char *const *words, size_t count, aiu_arena *arena);
+AIU_API int aiu_kwtable_find(const aiu_kwtable *kw, const char *s, size_t len);
+
+/* --- Delimited Records (CSV rows into caller-owned column arrays) --- */
+#define AIU_COL_SKIP 0              /* ignore the field                     */
+#define AIU_COL_DEC  1              /* decatoi() into "ints"                */
+#define AIU_COL_HEX  2              /* hexatoi() into "ints"                */
+#define AIU_COL_OCT  3              /* octatoi() into "ints"                */
+#define AIU_COL_STR  4              /* (ptr,len) span into "strs"           */
+#define AIU_COL_TRIM 5              /* trim_span(, 'b') span into "strs"    */
+
+typedef struct aiu_csvcol {
+    int      type;                  /* AIU_COL_*                            */
+    int64_t *ints;                  /* max_rows values, numeric columns     */
+    aiu_str *strs;                  /* max_rows spans, string columns       */
+    int     *rcs;                   /* max_rows 1/0 parse codes, or NULL    */
+} aiu_csvcol;
+
+typedef struct aiu_csv {
+    const aiu_csvcol *cols;         /* schema: one entry per field          */
+    size_t            ncols;
+    size_t            rows;         /* records stored; set to 0 to reuse    */
+    size_t            max_rows;     /* capacity of every column array       */
+    char              delim;        /* field separator, e.g. ','            */
+    char              quote;        /* e.g. '"'; '\0' for no quoting        */
+} aiu_csv;
+
+AIU_API int aiu_csv_init(aiu_csv *c, const aiu_csvcol *cols, size_t ncols, size_t max_rows, char delim, char quote);
+AIU_API int aiu_csv_parse_record(aiu_csv *c, const char *line, size_t len);
+AIU_API size_t aiu_csv_parse(aiu_csv *c, const char *data, size_t len, size_t *consumed);
+
+/* --- CPU Dispatch (which AIUTILS_SIMD kernels this process runs) --- */
+#define AIU_VARIANT_SCALAR 0        /* byte loops only                      */
+#define AIU_VARIANT_SWAR   1        /* portable 8-bytes-per-word blocks     */
+#define AIU_VARIANT_SSE2   2
+#define AIU_VARIANT_AVX2   3
+#define AIU_VARIANT_NEON   4
+
+#define AIU_CPU_SSE2   1            /* aiu_cpu_features() bits              */
+#define AIU_CPU_AVX2   2
+#define AIU_CPU_AVX512 4            /* AVX-512BW                            */
+#define AIU_CPU_NEON   8
+
+AIU_API int aiu_cpu_variant(void);
+AIU_API const char *aiu_cpu_variant_name(void);
+AIU_API unsigned aiu_cpu_features(void);
+
+/* --- Call Counters (filled in only when built with -DAIUTILS_STATS) --- */
+#define AIU_STAT_STRZCPY      0
+#define AIU_STAT_STRZCAT      1     /* also numzcat()                       */
+#define AIU_STAT_STRZCPY_N    2
+#define AIU_STAT_STRZCAT_AT   3     /* also numzcat_at(), aiu_cursor_*()    */
+#define AIU_STAT_SUBSTRING    4     /* substring_safe_copy() and its _n     */
+#define AIU_STAT_TRIM_COPY    5     /* trim_safe_copy()                     */
+#define AIU_STAT_REPLACE_COPY 6     /* replace_char_safe_copy() and its _n  */
+#define AIU_STAT_MAKELOWER    7     /* makelower_safe_copy()                */
+#define AIU_STAT_SAFE_GETS    8
+#define AIU_STAT_COUNT        9
+
+typedef struct aiu_stat {
+    uint64_t calls;
+    uint64_t bytes;                 /* chars written (read, for safe_gets)  */
+    uint64_t truncations;           /* calls whose result was cut short     */
+} aiu_stat;
+
+AIU_API int aiu_stats_snapshot(aiu_stat stats[AIU_STAT_COUNT]);
+AIU_API const char *aiu_stats_name(int fn);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#if defined(AIUTILS_HEADER_ONLY)
+#include "aiutils.c"                /* the definitions, as static inline    */
+#endif
+
+#endif /* AIUTILS_H */
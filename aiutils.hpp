@@ -0,0 +1,264 @@
+/* aiutils.hpp - C++17 wrappers over the aiutils C functions.               */
+/*                                                                          */
+/* The wrappers take the size of a char[N] target from its type and the    */
+/* length of a source from std::string_view (or from a char array), so     */
+/* nothing is passed as sizeof() by hand and no strlen() is needed. Short   */
+/* targets are copied with a few fixed-size moves; longer ones go to the    */
+/* C functions. The number parsers are constexpr: on a literal they run at  */
+/* compile time with the same rules as decatoi()/hexatoi()/octatoi(), and   */
+/* at run time they call those functions.                                   */
+/*                                                                          */
+/* BUILD:   link aiutils.c as usual (it stays C), or define                 */
+/*          AIUTILS_HEADER_ONLY before including this header.               */
+/*                                                                          */
+/* EXAMPLE: char name[32];                                                  */
+/*          aiu::copy(name, user.name);           // std::string, no strlen */
+/*          auto port = aiu::parse_dec<uint16_t>(field);                    */
+/*          static_assert(*aiu::parse_hex<int>("ff") == 255);               */
+#ifndef AIUTILS_HPP
+#define AIUTILS_HPP
+
+#if !(__cplusplus >= 201703L || (defined(_MSVC_LANG) && _MSVC_LANG >= 201703L))
+#error "aiutils.hpp needs C++17 (std::string_view, if constexpr)"
+#endif
+
+#include "aiutils.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <optional>
+#include <string_view>
+#include <type_traits>
+
+/* Nonzero while a constexpr function is being evaluated at compile time */
+#if defined(__cpp_lib_is_constant_evaluated)
+#define AIU_CONSTANT_EVALUATED() std::is_constant_evaluated()
+#elif defined(__GNUC__) && __GNUC__ >= 9 || defined(__clang__) && __clang_major__ >= 9 || \
+      defined(_MSC_VER) && _MSC_VER >= 1925
+#define AIU_CONSTANT_EVALUATED() __builtin_is_constant_evaluated()
+#else
+#define AIU_CONSTANT_EVALUATED() true   /* always run the constexpr port   */
+#endif
+
+namespace aiu {
+
+/* --- Spans --- */
+
+/* An aiu_str span as a std::string_view, and back */
+inline constexpr std::string_view view(const aiu_str &s) noexcept {
+    return std::string_view(s.ptr, s.len);
+}
+
+inline constexpr aiu_str span(std::string_view v) noexcept {
+    return aiu_str{v.data(), v.size()};
+}
+
+namespace detail {
+
+/* Copy n <= 16 chars as two overlapping fixed-size moves (each memcpy has  */
+/* a constant size, so each compiles to one load and one store)             */
+inline void copy_small(char *d, const char *s, std::size_t n) noexcept {
+    if (n >= 8) {
+        std::memcpy(d, s, 8);
+        std::memcpy(d + n - 8, s + n - 8, 8);
+    } else if (n >= 4) {
+        std::memcpy(d, s, 4);
+        std::memcpy(d + n - 4, s + n - 4, 4);
+    } else if (n >= 2) {
+        std::memcpy(d, s, 2);
+        std::memcpy(d + n - 2, s + n - 2, 2);
+    } else if (n == 1) {
+        d[0] = s[0];
+    }
+}
+
+/* Chars before the first null in src[0..m), or m (folds for literals) */
+inline std::size_t bounded_len(const char *src, std::size_t m) noexcept {
+    const void *nul = std::memchr(src, '\0', m);
+    return nul ? (std::size_t)(static_cast<const char *>(nul) - src) : m;
+}
+
+/* Store "v" in a T if it fits. Hex results are 64-bit patterns (the way    */
+/* hexatoi() wraps), so an unsigned T takes them as unsigned.               */
+template <class T>
+constexpr std::optional<T> narrow(std::int64_t v, bool as_bits) noexcept {
+    if constexpr (std::is_unsigned_v<T>) {
+        if (v < 0 && !as_bits) return std::nullopt;
+        if ((std::uint64_t)v > (std::uint64_t)std::numeric_limits<T>::max())
+            return std::nullopt;
+    } else {
+        if (v < (std::int64_t)std::numeric_limits<T>::min() ||
+            v > (std::int64_t)std::numeric_limits<T>::max())
+            return std::nullopt;
+    }
+    return static_cast<T>(v);
+}
+
+/* decatoi() for constant evaluation: same rules, same results */
+constexpr bool dec(std::string_view s, std::int64_t *value) noexcept {
+    std::size_t i = 0, n = s.size();
+    std::uint64_t limit = (std::uint64_t)INT64_MAX, mag = 0;
+    bool neg = false;
+
+    if (n > 20) return false;
+    if (n == 0) { *value = 0; return true; }
+    while (i < n && (s[i] == ' ' || (s[i] >= '\t' && s[i] <= '\r'))) i++;
+    if (i < n && (s[i] == '+' || s[i] == '-')) {
+        neg = (s[i] == '-');
+        if (neg) limit = (std::uint64_t)INT64_MAX + 1;
+        i++;
+    }
+    if (i == n) return false;
+    for (; i < n; i++) {
+        unsigned d = (unsigned)(s[i] - '0');
+        if (d > 9) return false;
+        if (mag > (limit - d) / 10) return false;
+        mag = mag * 10 + d;
+    }
+    *value = neg ? (std::int64_t)(0 - mag) : (std::int64_t)mag;
+    return true;
+}
+
+/* octatoi() for constant evaluation */
+constexpr bool oct(std::string_view s, std::int64_t *value) noexcept {
+    std::size_t i = 0, n = s.size();
+    std::uint64_t limit = (std::uint64_t)INT64_MAX, mag = 0;
+    bool neg = false;
+
+    if (n > 23) return false;
+    if (n == 0) { *value = 0; return true; }
+    while (i < n && (s[i] == ' ' || (s[i] >= '\t' && s[i] <= '\r'))) i++;
+    if (i < n && (s[i] == '+' || s[i] == '-')) {
+        neg = (s[i] == '-');
+        if (neg) limit = (std::uint64_t)INT64_MAX + 1;
+        i++;
+    }
+    if (i == n) return false;
+    for (; i < n; i++) {
+        unsigned d = (unsigned)(s[i] - '0');
+        if (d > 7) return false;
+        if (mag > (limit - d) >> 3) return false;
+        mag = (mag << 3) | d;
+    }
+    *value = neg ? (std::int64_t)(0 - mag) : (std::int64_t)mag;
+    return true;
+}
+
+/* hexatoi() for constant evaluation: signs and blanks anywhere, the sign   */
+/* applied at the end, high bits shifted out                                */
+constexpr bool hex(std::string_view s, std::int64_t *value) noexcept {
+    std::uint64_t acc = 0;
+    bool neg = false;
+
+    for (char c : s) {
+        if (c >= '0' && c <= '9')      acc = (acc << 4) | (std::uint64_t)(c - '0');
+        else if (c >= 'a' && c <= 'f') acc = (acc << 4) | (std::uint64_t)(c - 'a' + 10);
+        else if (c >= 'A' && c <= 'F') acc = (acc << 4) | (std::uint64_t)(c - 'A' + 10);
+        else if (c == '-')             neg = true;
+        else if (c == '+')             neg = false;
+        else if (c != ' ')             return false;
+    }
+    if (neg) acc = 0 - acc;
+    *value = (std::int64_t)acc;
+    return true;
+}
+
+} /* namespace detail */
+
+/* --- Copy & Concat into char[N] --- */
+
+/* strzcpy() into "dest" with N from its type: copies as much of "src" as   */
+/* fits, always null terminates, and returns the length copied (less than   */
+/* src.size() means it was cut short). Embedded nulls in "src" are copied.  */
+template <std::size_t N>
+inline std::size_t copy(char (&dest)[N], std::string_view src) noexcept {
+    static_assert(N > 0, "aiu::copy needs room for the null");
+    const std::size_t n = src.size() < N - 1 ? src.size() : N - 1;
+
+    if constexpr (N <= 17) {
+        detail::copy_small(dest, src.data(), n);
+        dest[n] = '\0';
+        return n;
+    } else {
+        return substring_safe_copy_n(dest, src.data(), src.size(), N, 0, src.size());
+    }
+}
+
+/* copy() from a char array: stops at its first null, or after M chars */
+template <std::size_t N, std::size_t M>
+inline std::size_t copy(char (&dest)[N], const char (&src)[M]) noexcept {
+    return copy(dest, std::string_view(src, detail::bounded_len(src, M)));
+}
+
+/* strzcat_at(): append "src" to "dest", whose length is "len", and return  */
+/* the new length                                                           */
+template <std::size_t N>
+inline std::size_t cat(char (&dest)[N], std::size_t len, std::string_view src) noexcept {
+    static_assert(N > 0, "aiu::cat needs room for the null");
+    if (len >= N - 1) return N - 1;
+    const std::size_t room = N - 1 - len;
+    const std::size_t n = src.size() < room ? src.size() : room;
+
+    if constexpr (N <= 17) {
+        detail::copy_small(dest + len, src.data(), n);
+        dest[len + n] = '\0';
+        return len + n;
+    } else {
+        return len + substring_safe_copy_n(dest + len, src.data(), src.size(), N - len, 0, src.size());
+    }
+}
+
+template <std::size_t N, std::size_t M>
+inline std::size_t cat(char (&dest)[N], std::size_t len, const char (&src)[M]) noexcept {
+    return cat(dest, len, std::string_view(src, detail::bounded_len(src, M)));
+}
+
+/* --- Number Parsing --- */
+
+/* decatoi()/hexatoi()/octatoi() on a string_view, as a T. Empty means the  */
+/* text did not parse or the value does not fit in T. constexpr on          */
+/* literals; at run time the C parser does the work.                        */
+template <class T = std::int64_t>
+constexpr std::optional<T> parse_dec(std::string_view s) noexcept {
+    static_assert(std::is_integral_v<T>, "parse_dec needs an integer type");
+    std::int64_t v = 0;
+
+    if (AIU_CONSTANT_EVALUATED()) {
+        if (!detail::dec(s, &v)) return std::nullopt;
+    } else if (!decatoi(s.data(), s.size(), &v)) {
+        return std::nullopt;
+    }
+    return detail::narrow<T>(v, false);
+}
+
+template <class T = std::int64_t>
+constexpr std::optional<T> parse_hex(std::string_view s) noexcept {
+    static_assert(std::is_integral_v<T>, "parse_hex needs an integer type");
+    std::int64_t v = 0;
+
+    if (AIU_CONSTANT_EVALUATED()) {
+        if (!detail::hex(s, &v)) return std::nullopt;
+    } else if (hexatoi(s.data(), s.size(), &v) == 1) {  /* 1 is failure    */
+        return std::nullopt;
+    }
+    return detail::narrow<T>(v, true);
+}
+
+template <class T = std::int64_t>
+constexpr std::optional<T> parse_oct(std::string_view s) noexcept {
+    static_assert(std::is_integral_v<T>, "parse_oct needs an integer type");
+    std::int64_t v = 0;
+
+    if (AIU_CONSTANT_EVALUATED()) {
+        if (!detail::oct(s, &v)) return std::nullopt;
+    } else if (!octatoi(s.data(), s.size(), &v)) {
+        return std::nullopt;
+    }
+    return detail::narrow<T>(v, false);
+}
+
+} /* namespace aiu */
+
+#endif /* AIUTILS_HPP */
@@ -0,0 +1,1150 @@
+/* aiutils_bench - throughput microbenchmarks for every aiutils function.   */
+/*                                                                          */
+/* Each function is run over inputs from 8 B to 1 MB and reported in bytes  */
+/* or values per second, next to its closest libc equivalent where there    */
+/* is one (strncpy, strtoll, strstr, strtok_r, ...).                        */
+/*                                                                          */
+/* BUILD:   make aiutils_bench, or                                          */
+/*          cc -O2 -pthread -o aiutils_bench aiutils_bench.c aiutils.c      */
+/*          (add -DAIUTILS_SIMD etc. to measure the optional kernels)       */
+/*          or, header-only: cc -O2 -pthread -DAIUTILS_HEADER_ONLY          */
+/*                           -o aiutils_bench aiutils_bench.c               */
+/*                                                                          */
+/* USAGE:   aiutils_bench [--json] [--ms N] [--runs N] [--filter NAME]      */
+/*                        [--baseline FILE [--tolerance PCT]]               */
+/*          --json    machine-readable output for perf dashboards           */
+/*          --ms N    minimum run time per measurement (default 20 ms)      */
+/*          --runs N  measurements per function and size, of which the      */
+/*                    median is reported (default 5, at most 15)            */
+/*          --filter  only run functions whose name contains NAME           */
+/*          --baseline  perf gate: compare with a saved --json run and      */
+/*                    exit 1 if any function/size is more than PCT percent  */
+/*                    (default 10) slower; e.g. save one with               */
+/*                    aiutils_bench --json > baseline.json                  */
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE                     /* for strcasestr()                 */
+#endif
+#include "aiutils.h"
+#include <time.h>
+
+#if defined(_WIN32) || defined(_MSC_VER)
+#include <windows.h>
+#define strcasecmp _stricmp
+#define strtok_r   strtok_s
+#else
+#include <strings.h>                    /* For strcasecmp                   */
+#endif
+
+#define BENCH_MAX_SIZE (1024 * 1024)
+
+static const size_t bench_sizes[] = {
+    8, 64, 512, 4096, 32768, 262144, BENCH_MAX_SIZE
+};
+#define BENCH_NSIZES (sizeof(bench_sizes) / sizeof(bench_sizes[0]))
+
+#define BENCH_MAX_FIELDS (BENCH_MAX_SIZE / 2)
+#define BENCH_MAX_ROWS   (BENCH_MAX_SIZE / 16)   /* records are >= 16 chars */
+#define BENCH_RECORD     120                     /* fixed-width record      */
+#define BENCH_FIELDS     30                      /* slices per record       */
+
+/* Inputs, rebuilt for every size by bench_prepare() */
+static char     *g_src;                 /* mixed-case words, null at "size" */
+static char     *g_pad;                 /* g_src with blanks on both ends   */
+static char     *g_work;                /* scratch copy for in-place calls  */
+static char     *g_upper;               /* g_src in upper case              */
+static char     *g_dst;                 /* output buffer                    */
+static char     *g_dec, *g_hex, *g_oct; /* comma separated numeric fields   */
+static aiu_str  *g_dec_f, *g_hex_f, *g_oct_f;
+static size_t    g_dec_n, g_hex_n, g_oct_n;
+static uint32_t *g_vals;                /* values to format                 */
+static size_t    g_vals_n;
+static int64_t  *g_out;
+static FILE     *g_lines;               /* "size" bytes of text lines       */
+static char     *g_text;                /* the same lines, in memory        */
+static char     *g_csv;                 /* "dec,hex,oct,name" records       */
+static size_t    g_pad_len;
+static aiu_casesearch g_needle;         /* compiled once per size           */
+static aiu_delims g_delims;             /* " ," for the tokenizers          */
+static aiu_charmap g_charmap;           /* " ," -> "_;", for aiu_translate  */
+static aiu_str  *g_spans;
+static aiu_csvcol g_csvcols[4];         /* dec, hex, oct, trimmed name      */
+static aiu_slice g_slices[BENCH_FIELDS]; /* 4-char fields of one record     */
+
+static volatile size_t g_sink;          /* keeps results observable         */
+
+static uint32_t bench_rand_state = 12345;
+static uint32_t bench_rand(void) {
+    bench_rand_state = bench_rand_state * 1103515245u + 12345u;
+    return bench_rand_state >> 8;
+}
+
+/****************************************************************************/
+/* bench_now() - monotonic time in seconds                                  */
+/****************************************************************************/
+static double bench_now(void) {
+#if defined(_WIN32) || defined(_MSC_VER)
+    LARGE_INTEGER f, c;
+    QueryPerformanceFrequency(&f);
+    QueryPerformanceCounter(&c);
+    return (double)c.QuadPart / (double)f.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+#endif
+}
+
+/* Fill "buf" with "n" comma separated numeric fields of "base" digits */
+static size_t bench_fields(char *buf, size_t size, aiu_str *f, int base) {
+    static const char digits[] = "0123456789abcdef";
+    size_t pos = 0, n = 0;
+
+    for (;;) {
+        size_t len, i;
+
+        if (base == 16) len = 16;                   /* 64-bit hex IDs       */
+        else len = 1 + bench_rand() % (base == 10 ? 18 : 21);
+        if (pos + len > size) len = size - pos;
+        if (len == 0) break;
+
+        for (i = 0; i < len; i++) buf[pos + i] = digits[bench_rand() % base];
+        f[n].ptr = buf + pos;
+        f[n].len = len;
+        n++;
+        pos += len;
+        if (pos >= size) break;
+        buf[pos++] = ',';
+    }
+    buf[pos] = '\0';
+    return n;
+}
+
+/****************************************************************************/
+/* bench_prepare() - build every input for one size                         */
+/****************************************************************************/
+static void bench_prepare(size_t size) {
+    static const char alpha[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ";
+    size_t i;
+
+    for (i = 0; i < size; i++) {
+        uint32_t r = bench_rand() % 8;
+        g_src[i] = r == 0 ? ' ' : r == 1 ? ',' : alpha[bench_rand() % 52];
+    }
+    g_src[size] = '\0';
+    if (size > 2) memcpy(g_src + size - 2, "/x", 2);  /* laststrstr target  */
+
+    memset(g_pad, ' ', 4);
+    memcpy(g_pad + 4, g_src, size);
+    memset(g_pad + 4 + size, ' ', 4);
+    g_pad_len = size + 8;
+    g_pad[g_pad_len] = '\0';
+
+    memcpy(g_upper, g_src, size + 1);
+    uppercase_inplace(g_upper);
+    aiu_casesearch_compile(&g_needle, "/X");
+    aiu_delims_init(&g_delims, " ,");
+    aiu_charmap_compile(&g_charmap, " ,", "_;", NULL);
+
+    g_dec_n = bench_fields(g_dec, size, g_dec_f, 10);
+    g_hex_n = bench_fields(g_hex, size, g_hex_f, 16);
+    g_oct_n = bench_fields(g_oct, size, g_oct_f, 8);
+
+    g_vals_n = size / 4 ? size / 4 : 1;
+    for (i = 0; i < g_vals_n; i++) g_vals[i] = bench_rand() >> (bench_rand() % 24);
+
+    /* Lines of 8..120 chars for the line readers */
+    if (g_lines) fclose(g_lines);
+    g_lines = tmpfile();
+    if (g_lines) {
+        for (i = 0; i < size;) {
+            size_t len = 8 + bench_rand() % 113;
+            if (i + len > size) len = size - i;
+            fwrite(g_src + i, 1, len - 1, g_lines);
+            fputc('\n', g_lines);
+            memcpy(g_text + i, g_src + i, len - 1);
+            g_text[i + len - 1] = '\n';
+            i += len;
+        }
+        fflush(g_lines);
+    }
+
+    /* Records of a decimal, a hex ID, an octal mode and a padded name */
+    for (i = 0; i < size;) {
+        char rec[64];
+        size_t len = (size_t)sprintf(rec, "%u,%08x,%o,  %.*s \n",
+                                     (unsigned)bench_rand(), (unsigned)bench_rand(),
+                                     (unsigned)(bench_rand() % 01000),
+                                     (int)(1 + bench_rand() % 12), alpha + bench_rand() % 32);
+        if (i + len > size) {           /* pad the tail with blank lines    */
+            memset(g_csv + i, '\n', size - i);
+            break;
+        }
+        memcpy(g_csv + i, rec, len);
+        i += len;
+    }
+    g_csv[size] = '\0';
+}
+
+/* --- aiutils runners: one pass over the input, returning units done --- */
+
+static size_t b_strzcpy(size_t n) {
+    strzcpy(g_dst, g_src, n + 1);
+    g_sink += (size_t)g_dst[n / 2];
+    return n;
+}
+
+static size_t b_strncpy(size_t n) {
+    strncpy(g_dst, g_src, n);
+    g_dst[n] = '\0';
+    g_sink += (size_t)g_dst[n / 2];
+    return n;
+}
+
+static size_t b_strzcat(size_t n) {
+    g_dst[0] = '\0';
+    strzcat(g_dst, g_src, n + 1);
+    g_sink += (size_t)g_dst[n / 2];
+    return n;
+}
+
+static size_t b_strncat(size_t n) {
+    g_dst[0] = '\0';
+    strncat(g_dst, g_src, n);
+    g_sink += (size_t)g_dst[n / 2];
+    return n;
+}
+
+static size_t b_strzcpy_n(size_t n) {
+    int cut;
+    g_sink += strzcpy_n(g_dst, g_src, n + 1, &cut);
+    return n;
+}
+
+/* Append chains of 16-char fields: the quadratic case strzcat_at() fixes */
+#define BENCH_FIELD 16
+static size_t b_strzcat_at(size_t n) {
+    char field[BENCH_FIELD + 1];
+    size_t len = 0, i, flen = n < BENCH_FIELD ? n : BENCH_FIELD;
+
+    memcpy(field, g_src, flen);
+    field[flen] = '\0';
+    g_dst[0] = '\0';
+    for (i = 0; i + flen <= n; i += flen)
+        len = strzcat_at(g_dst, len, field, n + 1, NULL);
+    g_sink += len;
+    return i;
+}
+
+static size_t b_strzcat_chain(size_t n) {
+    char field[BENCH_FIELD + 1];
+    size_t i, flen = n < BENCH_FIELD ? n : BENCH_FIELD;
+
+    memcpy(field, g_src, flen);
+    field[flen] = '\0';
+    g_dst[0] = '\0';
+    for (i = 0; i + flen <= n; i += flen)
+        strcat(g_dst, field);
+    g_sink += (size_t)g_dst[0];
+    return i;
+}
+
+static size_t b_cursor(size_t n) {
+    aiu_cursor c;
+    size_t i;
+
+    aiu_cursor_init(&c, g_dst, n + 1);
+    for (i = 0; i < g_vals_n; i++) {
+        aiu_cursor_num(&c, g_vals[i]);
+        aiu_cursor_cat(&c, ",");
+    }
+    g_sink += c.len;
+    return g_vals_n;
+}
+
+static size_t b_sb(size_t n) {
+    aiu_arena a;
+    aiu_sb sb;
+    size_t i;
+
+    aiu_arena_init(&a, g_dst, BENCH_MAX_SIZE * 4 + 16);
+    aiu_sb_init(&sb, &a);
+    for (i = 0; i < g_vals_n; i++) {
+        aiu_sb_append_u32(&sb, g_vals[i]);
+        aiu_sb_append_char(&sb, ',');
+    }
+    g_sink += sb.len;
+    (void)n;
+    return g_vals_n;
+}
+
+static size_t b_numzcat(size_t n) {
+    size_t i;
+
+    g_dst[0] = '\0';
+    for (i = 0; i < g_vals_n; i++) numzcat(g_dst, g_vals[i], n + 1);
+    g_sink += (size_t)g_dst[0];
+    return g_vals_n;
+}
+
+static size_t b_numzcat_at(size_t n) {
+    size_t i, len = 0;
+
+    g_dst[0] = '\0';
+    for (i = 0; i < g_vals_n; i++) len = numzcat_at(g_dst, len, g_vals[i], n + 1, NULL);
+    g_sink += len;
+    return g_vals_n;
+}
+
+static size_t b_snprintf_append(size_t n) {
+    size_t i, len = 0;
+
+    g_dst[0] = '\0';
+    for (i = 0; i < g_vals_n && len < n; i++) {
+        int w = snprintf(g_dst + len, n + 1 - len, "%u", (unsigned)g_vals[i]);
+        if (w < 0) break;
+        len += (size_t)w;
+    }
+    g_sink += len;
+    return g_vals_n;
+}
+
+static size_t b_decatoi(size_t n) {
+    size_t i;
+    int64_t v = 0;
+    (void)n;
+    for (i = 0; i < g_dec_n; i++) {
+        decatoi(g_dec_f[i].ptr, g_dec_f[i].len, &v);
+        g_sink += (size_t)v;
+    }
+    return g_dec_n;
+}
+
+static size_t b_decatoi_batch(size_t n) {
+    (void)n;
+    g_sink += decatoi_batch(g_dec_f, g_dec_n, g_out, NULL);
+    return g_dec_n;
+}
+
+static size_t bench_strtoll(const aiu_str *f, size_t count, int base) {
+    size_t i;
+    char *end;
+    for (i = 0; i < count; i++) g_sink += (size_t)strtoll(f[i].ptr, &end, base);
+    return count;
+}
+
+static size_t b_strtoll10(size_t n) { (void)n; return bench_strtoll(g_dec_f, g_dec_n, 10); }
+static size_t b_strtoll16(size_t n) { (void)n; return bench_strtoll(g_hex_f, g_hex_n, 16); }
+static size_t b_strtoll8(size_t n)  { (void)n; return bench_strtoll(g_oct_f, g_oct_n, 8); }
+
+static size_t b_hexatoi(size_t n) {
+    size_t i;
+    int64_t v;
+    (void)n;
+    for (i = 0; i < g_hex_n; i++) {
+        hexatoi(g_hex_f[i].ptr, g_hex_f[i].len, &v);
+        g_sink += (size_t)v;
+    }
+    return g_hex_n;
+}
+
+static size_t b_hexatoi_batch(size_t n) {
+    (void)n;
+    g_sink += hexatoi_batch(g_hex_f, g_hex_n, g_out, NULL);
+    return g_hex_n;
+}
+
+static size_t b_octatoi(size_t n) {
+    size_t i;
+    int64_t v = 0;
+    (void)n;
+    for (i = 0; i < g_oct_n; i++) {
+        octatoi(g_oct_f[i].ptr, g_oct_f[i].len, &v);
+        g_sink += (size_t)v;
+    }
+    return g_oct_n;
+}
+
+static size_t b_fitoa(size_t n) {
+    char b[16];
+    size_t i;
+    (void)n;
+    for (i = 0; i < g_vals_n; i++) {
+        fitoa(g_vals[i], 10, b);
+        g_sink += (size_t)b[9];
+    }
+    return g_vals_n;
+}
+
+static size_t b_fitoa64(size_t n) {
+    char b[24];
+    size_t i;
+    (void)n;
+    for (i = 0; i < g_vals_n; i++) {
+        fitoa64((uint64_t)g_vals[i] * 1000003u, 20, b);
+        g_sink += (size_t)b[19];
+    }
+    return g_vals_n;
+}
+
+static size_t b_fitoa_batch(size_t n) {
+    (void)n;
+    g_sink += fitoa_batch(g_vals, g_vals_n, 10, g_dst, NULL);
+    return g_vals_n;
+}
+
+static size_t b_snprintf_fixed(size_t n) {
+    char b[16];
+    size_t i;
+    (void)n;
+    for (i = 0; i < g_vals_n; i++) {
+        snprintf(b, sizeof(b), "%10u", (unsigned)g_vals[i]);
+        g_sink += (size_t)b[9];
+    }
+    return g_vals_n;
+}
+
+static size_t b_fitoa_column(size_t n) {
+    (void)n;
+    fitoa_column(g_vals, g_vals_n, 10, g_dst, 10);
+    g_sink += (size_t)g_dst[0];
+    return g_vals_n;
+}
+
+static size_t b_strcmpii(size_t n) {
+    g_sink += (size_t)strcmpii(g_src, g_upper);
+    return n;
+}
+
+static size_t b_strcmpii_n(size_t n) {
+    g_sink += (size_t)strcmpii_n(g_src, n, g_upper, n);
+    return n;
+}
+
+static size_t b_strcasecmp(size_t n) {
+    g_sink += (size_t)strcasecmp(g_src, g_upper);
+    return n;
+}
+
+/* g_pad + 4 holds the same text as g_src, so the whole prefix matches */
+static size_t b_strbgw(size_t n) {
+    g_sink += (size_t)strbgw(g_pad + 4, g_src);
+    return n;
+}
+
+/* A router: 300 route prefixes, and request paths of which ~1/7 miss     */
+#define BENCH_ROUTES 300
+static char g_route_buf[BENCH_ROUTES][16];
+static const char *g_routes[BENCH_ROUTES];
+static char g_paths[64][24];
+static aiu_prefixset g_prefixes;
+
+static void bench_routes(void) {
+    static char mem[BENCH_ROUTES * 32];
+    static int done;
+    aiu_arena a;
+    size_t i;
+
+    if (done) return;
+    for (i = 0; i < BENCH_ROUTES; i++) {
+        sprintf(g_route_buf[i], "/api/r%03u/", (unsigned)i);
+        g_routes[i] = g_route_buf[i];
+    }
+    for (i = 0; i < 64; i++)
+        sprintf(g_paths[i], "/api/r%03u/item/%u", (unsigned)(bench_rand() % 350), (unsigned)i);
+    aiu_arena_init(&a, mem, sizeof(mem));
+    aiu_prefixset_compile(&g_prefixes, g_routes, BENCH_ROUTES, 0, &a);
+    done = 1;
+}
+
+static size_t b_prefixset(size_t n) {
+    size_t i, q = n / 16 + 1;
+    bench_routes();
+    for (i = 0; i < q; i++) {
+        const char *p = g_paths[i & 63];
+        g_sink += (size_t)aiu_prefixset_match(&g_prefixes, p, strlen(p), NULL);
+    }
+    return q;
+}
+
+/* 150 header-style keywords, looked up in mixed case; ~1/4 are misses */
+#define BENCH_KEYWORDS 150
+static char g_kw_buf[BENCH_KEYWORDS][24];
+static const char *g_kws[BENCH_KEYWORDS];
+static char g_kw_q[64][24];
+static aiu_kwtable g_kw;
+
+static void bench_keywords(void) {
+    static char mem[BENCH_KEYWORDS * 64];
+    static int done;
+    aiu_arena a;
+    size_t i, k;
+
+    if (done) return;
+    for (i = 0; i < BENCH_KEYWORDS; i++) {
+        sprintf(g_kw_buf[i], "x-header-%u", (unsigned)(i * 7));
+        g_kws[i] = g_kw_buf[i];
+    }
+    for (i = 0; i < 64; i++) {
+        sprintf(g_kw_q[i], "X-Header-%u", (unsigned)(bench_rand() % 200) * 7);
+        for (k = 0; g_kw_q[i][k]; k++)
+            if (bench_rand() & 1) g_kw_q[i][k] = (char)toupper((unsigned char)g_kw_q[i][k]);
+    }
+    aiu_arena_init(&a, mem, sizeof(mem));
+    aiu_kwtable_build(&g_kw, g_kws, BENCH_KEYWORDS, &a);
+    done = 1;
+}
+
+static size_t b_kwtable(size_t n) {
+    size_t i, q = n / 16 + 1;
+    bench_keywords();
+    for (i = 0; i < q; i++) {
+        const char *k = g_kw_q[i & 63];
+        g_sink += (size_t)aiu_kwtable_find(&g_kw, k, strlen(k));
+    }
+    return q;
+}
+
+static size_t b_strcmpii_loop(size_t n) {
+    size_t i, k, q = n / 16 + 1;
+    bench_keywords();
+    for (i = 0; i < q; i++) {
+        for (k = 0; k < BENCH_KEYWORDS; k++) if (strcmpii(g_kw_q[i & 63], g_kws[k]) == 0) break;
+        g_sink += k;
+    }
+    return q;
+}
+
+static size_t b_strbgw_loop(size_t n) {
+    size_t i, r, q = n / 16 + 1;
+    bench_routes();
+    for (i = 0; i < q; i++) {
+        for (r = 0; r < BENCH_ROUTES; r++) if (strbgw(g_paths[i & 63], g_routes[r])) break;
+        g_sink += r;
+    }
+    return q;
+}
+
+static size_t b_strncmp(size_t n) {
+    g_sink += (size_t)strncmp(g_pad + 4, g_src, n);
+    return n;
+}
+
+static size_t b_casesearch(size_t n) {
+    g_sink += (size_t)aiu_casesearch_find(&g_needle, g_src, n);
+    return n;
+}
+
+static size_t b_strcasestr(size_t n) {
+    g_sink += (size_t)strcasestr(g_src, "/X");
+    return n;
+}
+
+static size_t b_laststrstr(size_t n) {
+    g_sink += (size_t)laststrstr(g_src, "ab");
+    return n;
+}
+
+static size_t b_laststrstr_n(size_t n) {
+    g_sink += (size_t)laststrstr_n(g_src, n, "ab", 2);
+    return n;
+}
+
+static size_t b_strstr(size_t n) {
+    g_sink += (size_t)strstr(g_src, "/x");
+    return n;
+}
+
+static size_t b_lastN(size_t n) {
+    g_sink += (size_t)lastN(g_src, 4);
+    return n;
+}
+
+static size_t b_strlen(size_t n) {
+    g_sink += strlen(g_src);
+    return n;
+}
+
+/* In-place calls restore their input first; the libc rows do the same */
+static size_t b_trim_inplace(size_t n) {
+    memcpy(g_work, g_pad, g_pad_len + 1);
+    trim_inplace(g_work, 'b');
+    g_sink += (size_t)g_work[0];
+    return n;
+}
+
+static size_t b_trim_span(size_t n) {
+    aiu_str t = trim_span(g_pad, g_pad_len, 'b');
+    g_sink += t.len;
+    return n;
+}
+
+static size_t b_trim_safe_copy(size_t n) {
+    trim_safe_copy(g_dst, g_pad, n + 1, 'b');
+    g_sink += (size_t)g_dst[0];
+    return n;
+}
+
+static size_t b_remove_char(size_t n) {
+    memcpy(g_work, g_src, n + 1);
+    remove_char_inplace(g_work, ' ');
+    g_sink += (size_t)g_work[0];
+    return n;
+}
+
+static size_t b_replace_char(size_t n) {
+    memcpy(g_work, g_src, n + 1);
+    replace_char_inplace(g_work, ' ', '_', 0);
+    g_sink += (size_t)g_work[0];
+    return n;
+}
+
+static size_t b_translate(size_t n) {
+    memcpy(g_work, g_src, n + 1);
+    g_sink += aiu_translate_inplace(&g_charmap, g_work, n, 0);
+    return n;
+}
+
+static size_t b_translate_copy(size_t n) {
+    g_sink += aiu_translate_copy(&g_charmap, g_dst, g_src, n, n + 1, 0);
+    return n;
+}
+
+static size_t b_replace_char_copy(size_t n) {
+    replace_char_safe_copy(g_dst, g_src, n + 1, ' ', '_', 0);
+    g_sink += (size_t)g_dst[0];
+    return n;
+}
+
+static size_t b_substring(size_t n) {
+    substring_safe_copy(g_dst, g_src, n + 1, n / 4, n / 2);
+    g_sink += (size_t)g_dst[0];
+    return n;
+}
+
+static size_t b_memcpy_restore(size_t n) {
+    memcpy(g_work, g_src, n + 1);
+    g_sink += (size_t)g_work[0];
+    return n;
+}
+
+static size_t b_uppercase(size_t n) {
+    memcpy(g_work, g_src, n + 1);
+    uppercase_inplace(g_work);
+    g_sink += (size_t)g_work[0];
+    return n;
+}
+
+static size_t b_uppercase_n(size_t n) {
+    memcpy(g_work, g_src, n + 1);
+    uppercase_inplace_n(g_work, n);
+    g_sink += (size_t)g_work[0];
+    return n;
+}
+
+static size_t b_lowercase(size_t n) {
+    memcpy(g_work, g_src, n + 1);
+    lowercase_inplace(g_work);
+    g_sink += (size_t)g_work[0];
+    return n;
+}
+
+static size_t b_lowercase_n(size_t n) {
+    memcpy(g_work, g_src, n + 1);
+    lowercase_inplace_n(g_work, n);
+    g_sink += (size_t)g_work[0];
+    return n;
+}
+
+static size_t b_toupper_loop(size_t n) {
+    size_t i;
+    memcpy(g_work, g_src, n + 1);
+    for (i = 0; i < n; i++) g_work[i] = (char)toupper((unsigned char)g_work[i]);
+    g_sink += (size_t)g_work[0];
+    return n;
+}
+
+static size_t b_makelower(size_t n) {
+    makelower_safe_copy(g_dst, g_src, n + 1);
+    g_sink += (size_t)g_dst[0];
+    return n;
+}
+
+static size_t b_tolower_loop(size_t n) {
+    size_t i;
+    for (i = 0; i < n; i++) g_dst[i] = (char)tolower((unsigned char)g_src[i]);
+    g_dst[n] = '\0';
+    g_sink += (size_t)g_dst[0];
+    return n;
+}
+
+static size_t b_safe_strtok(size_t n) {
+    char *save, *tok;
+    memcpy(g_work, g_src, n + 1);
+    for (tok = safe_strtok(g_work, " ,", &save); tok; tok = safe_strtok(NULL, " ,", &save))
+        g_sink += (size_t)tok[0];
+    return n;
+}
+
+static size_t b_strtok_r(size_t n) {
+    char *save, *tok;
+    memcpy(g_work, g_src, n + 1);
+    for (tok = strtok_r(g_work, " ,", &save); tok; tok = strtok_r(NULL, " ,", &save))
+        g_sink += (size_t)tok[0];
+    return n;
+}
+
+static size_t b_tok_next(size_t n) {
+    aiu_tokenizer t;
+    aiu_str tok;
+    aiu_tok_init(&t, g_src, n, &g_delims);
+    while (aiu_tok_next(&t, &tok)) g_sink += tok.len;
+    return n;
+}
+
+static size_t b_split(size_t n) {
+    g_sink += aiu_split(g_src, n, &g_delims, g_spans, BENCH_MAX_FIELDS, 1);
+    return n;
+}
+
+static size_t b_arena_tok(size_t n) {
+    aiu_arena a;
+    aiu_tokenizer t;
+    char *tok;
+    aiu_arena_init(&a, g_dst, BENCH_MAX_SIZE * 4 + 16);
+    aiu_tok_init(&t, g_src, n, &g_delims);
+    while ((tok = aiu_arena_tok_next(&a, &t)) != NULL) g_sink += (size_t)tok[0];
+    return n;
+}
+
+/* A logger's timestamps: the same second many times, then the next one */
+static size_t b_iso8601(size_t n) {
+    char ts[AIU_ISO8601_LEN + 1];
+    size_t i, q = n / 16 + 1;
+    for (i = 0; i < q; i++) {
+        if (aiu_format_iso8601(INT64_C(1700000000) + (int64_t)(i >> 6), ts, sizeof(ts)))
+            g_sink += (size_t)ts[18];
+    }
+    return q;
+}
+
+static size_t b_gmtime_strftime(size_t n) {
+    char ts[32];
+    struct tm tm;
+    size_t i, q = n / 16 + 1;
+    for (i = 0; i < q; i++) {
+        time_t t = (time_t)(1700000000 + (i >> 6));
+        if (safe_gmtime(&t, &tm) && strftime(ts, sizeof(ts), "%Y-%m-%dT%H:%M:%SZ", &tm))
+            g_sink += (size_t)ts[18];
+    }
+    return q;
+}
+
+static size_t b_aiu_gmtime(size_t n) {
+    struct tm tm;
+    size_t i, q = n / 16 + 1;
+    for (i = 0; i < q; i++) {
+        if (aiu_gmtime(INT64_C(1700000000) + (int64_t)i * 7, &tm))
+            g_sink += (size_t)tm.tm_sec;
+    }
+    return q;
+}
+
+static size_t b_gmtime_r(size_t n) {
+    struct tm tm;
+    size_t i, q = n / 16 + 1;
+    for (i = 0; i < q; i++) {
+        time_t t = (time_t)(1700000000 + (int64_t)i * 7);
+        if (safe_gmtime(&t, &tm)) g_sink += (size_t)tm.tm_sec;
+    }
+    return q;
+}
+
+static size_t b_safe_gets(size_t n) {
+    char line[256];
+    if (g_lines == NULL) return 0;
+    rewind(g_lines);
+    while (safe_gets(line, sizeof(line), g_lines)) g_sink += (size_t)line[0];
+    return n;
+}
+
+static size_t b_linereader(size_t n) {
+    static char block[65536];
+    aiu_linereader lr;
+    aiu_str line;
+    if (g_lines == NULL) return 0;
+    rewind(g_lines);
+    aiu_linereader_init(&lr, g_lines, block, sizeof(block));
+    while (aiu_linereader_next(&lr, &line)) g_sink += line.len;
+    return n;
+}
+
+static size_t b_linereader_mem(size_t n) {
+    aiu_linereader lr;
+    aiu_str line;
+    aiu_linereader_init_mem(&lr, g_text, n);
+    while (aiu_linereader_next(&lr, &line)) g_sink += line.len;
+    return n;
+}
+
+static void bench_count_line(void *state, const aiu_str *line) {
+    *(size_t *)state += line->len;
+}
+
+static size_t b_parallel_lines(size_t n) {
+    static size_t counts[AIU_MAX_THREADS * 8];  /* one cache line each  */
+    size_t k;
+    aiu_parallel_lines(g_text, n, 0, bench_count_line, counts, 8 * sizeof(size_t));
+    for (k = 0; k < AIU_MAX_THREADS; k++) g_sink += counts[k * 8];
+    return n;
+}
+
+static size_t b_csv(size_t n) {
+    aiu_csv c;
+    aiu_csv_init(&c, g_csvcols, 4, BENCH_MAX_ROWS, ',', '"');
+    g_sink += aiu_csv_parse(&c, g_csv, n, NULL);
+    return n;
+}
+
+static size_t b_slice_copy(size_t n) {
+    size_t pos, len;
+    for (pos = 0; pos < n; pos += BENCH_RECORD) {
+        len = n - pos < BENCH_RECORD ? n - pos : BENCH_RECORD;
+        g_sink += aiu_slice_copy(g_src + pos, len, g_slices, BENCH_FIELDS, NULL);
+    }
+    return n;
+}
+
+static size_t b_slice_substring(size_t n) {
+    size_t pos, k;
+    for (pos = 0; pos < n; pos += BENCH_RECORD) {
+        for (k = 0; k < BENCH_FIELDS; k++)
+            substring_safe_copy(g_slices[k].dest, g_src + pos, g_slices[k].dest_size,
+                                g_slices[k].position, g_slices[k].length);
+    }
+    g_sink += (size_t)g_dst[0];
+    return n;
+}
+
+static size_t b_csv_strtok(size_t n) {
+    int64_t *dec = g_csvcols[0].ints, *hex = g_csvcols[1].ints, *oct = g_csvcols[2].ints;
+    char *lsave, *fsave, *line;
+    size_t row = 0;
+    memcpy(g_work, g_csv, n + 1);
+    for (line = strtok_r(g_work, "\n", &lsave); line; line = strtok_r(NULL, "\n", &lsave)) {
+        char *f = strtok_r(line, ",", &fsave);
+        if (f) { dec[row] = strtoll(f, NULL, 10); f = strtok_r(NULL, ",", &fsave); }
+        if (f) { hex[row] = strtoll(f, NULL, 16); f = strtok_r(NULL, ",", &fsave); }
+        if (f) { oct[row] = strtoll(f, NULL, 8);  f = strtok_r(NULL, ",", &fsave); }
+        if (f) { g_csvcols[3].strs[row].ptr = f; g_csvcols[3].strs[row].len = strlen(f); }
+        row++;
+    }
+    g_sink += row;
+    return n;
+}
+
+static size_t b_fgets(size_t n) {
+    char line[256];
+    if (g_lines == NULL) return 0;
+    rewind(g_lines);
+    while (fgets(line, sizeof(line), g_lines)) g_sink += (size_t)line[0];
+    return n;
+}
+
+/* --- Benchmark table --- */
+typedef struct bench {
+    const char *name;                   /* aiutils function                 */
+    size_t (*run)(size_t);
+    const char *libc;                   /* closest libc equivalent, or NULL */
+    size_t (*run_libc)(size_t);
+    const char *unit;                   /* "bytes" or "values"              */
+} bench;
+
+static const bench benches[] = {
+    { "strzcpy",             b_strzcpy,           "strncpy",         b_strncpy,         "bytes"  },
+    { "strzcat",             b_strzcat,           "strncat",         b_strncat,         "bytes"  },
+    { "strzcpy_n",           b_strzcpy_n,         "strncpy",         b_strncpy,         "bytes"  },
+    { "strzcat_at",          b_strzcat_at,        "strcat",          b_strzcat_chain,   "bytes"  },
+    { "aiu_cursor",          b_cursor,            "snprintf",        b_snprintf_append, "values" },
+    { "aiu_sb",              b_sb,                "snprintf",        b_snprintf_append, "values" },
+    { "numzcat",             b_numzcat,           "snprintf",        b_snprintf_append, "values" },
+    { "numzcat_at",          b_numzcat_at,        "snprintf",        b_snprintf_append, "values" },
+    { "decatoi",             b_decatoi,           "strtoll",         b_strtoll10,       "values" },
+    { "decatoi_batch",       b_decatoi_batch,     "strtoll",         b_strtoll10,       "values" },
+    { "hexatoi",             b_hexatoi,           "strtoll",         b_strtoll16,       "values" },
+    { "hexatoi_batch",       b_hexatoi_batch,     "strtoll",         b_strtoll16,       "values" },
+    { "octatoi",             b_octatoi,           "strtoll",         b_strtoll8,        "values" },
+    { "fitoa",               b_fitoa,             "snprintf",        b_snprintf_fixed,  "values" },
+    { "fitoa64",             b_fitoa64,           "snprintf",        b_snprintf_fixed,  "values" },
+    { "fitoa_column",        b_fitoa_column,      "snprintf",        b_snprintf_fixed,  "values" },
+    { "fitoa_batch",         b_fitoa_batch,       "snprintf",        b_snprintf_fixed,  "values" },
+    { "strcmpii",            b_strcmpii,          "strcasecmp",      b_strcasecmp,      "bytes"  },
+    { "strcmpii_n",          b_strcmpii_n,        "strcasecmp",      b_strcasecmp,      "bytes"  },
+    { "strbgw",              b_strbgw,            "strncmp",         b_strncmp,         "bytes"  },
+    { "aiu_prefixset_match", b_prefixset,         "strbgw loop",     b_strbgw_loop,     "values" },
+    { "aiu_kwtable_find",    b_kwtable,           "strcmpii loop",   b_strcmpii_loop,   "values" },
+    { "aiu_casesearch_find", b_casesearch,        "strcasestr",      b_strcasestr,      "bytes"  },
+    { "laststrstr",          b_laststrstr,        "strstr",          b_strstr,          "bytes"  },
+    { "laststrstr_n",        b_laststrstr_n,      "strstr",          b_strstr,          "bytes"  },
+    { "lastN",               b_lastN,             "strlen",          b_strlen,          "bytes"  },
+    { "trim_inplace",        b_trim_inplace,      "memcpy",          b_memcpy_restore,  "bytes"  },
+    { "trim_span",           b_trim_span,         "strlen",          b_strlen,          "bytes"  },
+    { "trim_safe_copy",      b_trim_safe_copy,    "strncpy",         b_strncpy,         "bytes"  },
+    { "remove_char_inplace", b_remove_char,       "memcpy",          b_memcpy_restore,  "bytes"  },
+    { "replace_char_inplace", b_replace_char,     "memcpy",          b_memcpy_restore,  "bytes"  },
+    { "replace_char_safe_copy", b_replace_char_copy, "strncpy",      b_strncpy,         "bytes"  },
+    { "aiu_translate_inplace", b_translate,       "memcpy",          b_memcpy_restore,  "bytes"  },
+    { "aiu_translate_copy",  b_translate_copy,    "strncpy",         b_strncpy,         "bytes"  },
+    { "substring_safe_copy", b_substring,         "strncpy",         b_strncpy,         "bytes"  },
+    { "uppercase_inplace",   b_uppercase,         "toupper",         b_toupper_loop,    "bytes"  },
+    { "uppercase_inplace_n", b_uppercase_n,       "toupper",         b_toupper_loop,    "bytes"  },
+    { "lowercase_inplace",   b_lowercase,         "tolower",         b_tolower_loop,    "bytes"  },
+    { "lowercase_inplace_n", b_lowercase_n,       "tolower",         b_tolower_loop,    "bytes"  },
+    { "makelower_safe_copy", b_makelower,         "tolower",         b_tolower_loop,    "bytes"  },
+    { "safe_strtok",         b_safe_strtok,       "strtok_r",        b_strtok_r,        "bytes"  },
+    { "aiu_tok_next",        b_tok_next,          "strtok_r",        b_strtok_r,        "bytes"  },
+    { "aiu_split",           b_split,             "strtok_r",        b_strtok_r,        "bytes"  },
+    { "aiu_csv_parse",       b_csv,               "strtoll",         b_csv_strtok,      "bytes"  },
+    { "aiu_slice_copy",      b_slice_copy,        "substring loop",  b_slice_substring, "bytes"  },
+    { "aiu_arena_tok_next",  b_arena_tok,         "strtok_r",        b_strtok_r,        "bytes"  },
+    { "aiu_gmtime",          b_aiu_gmtime,        "gmtime_r",        b_gmtime_r,        "values" },
+    { "aiu_format_iso8601",  b_iso8601,           "strftime",        b_gmtime_strftime, "values" },
+    { "safe_gets",           b_safe_gets,         "fgets",           b_fgets,           "bytes"  },
+    { "aiu_linereader_next", b_linereader,        "fgets",           b_fgets,           "bytes"  },
+    { "aiu_linereader_mem",  b_linereader_mem,    "fgets",           b_fgets,           "bytes"  },
+    { "aiu_parallel_lines",  b_parallel_lines,    "fgets",           b_fgets,           "bytes"  },
+};
+#define BENCH_COUNT (sizeof(benches) / sizeof(benches[0]))
+
+/****************************************************************************/
+/* bench_rate() - units per second of "run" at "size", over >= "ms" ms      */
+/****************************************************************************/
+static double bench_rate(size_t (*run)(size_t), size_t size, double ms) {
+    double start, elapsed;
+    size_t units = 0, iters = 1, i;
+
+    run(size);                          /* warm caches and branch history   */
+    start = bench_now();
+    for (;;) {
+        for (i = 0; i < iters; i++) units += run(size);
+        elapsed = bench_now() - start;
+        if (elapsed * 1000.0 >= ms) break;
+        iters *= 2;
+    }
+    return (double)units / elapsed;
+}
+
+#define BENCH_MAX_RUNS 15
+
+/****************************************************************************/
+/* bench_median() - median of "runs" bench_rate() measurements              */
+/*                                                                          */
+/* Every function is measured the same number of times, with or without   */
+/* --baseline, so a saved run and a gated run are taken the same way and    */
+/* one slow (or lucky) measurement moves neither.                           */
+/****************************************************************************/
+static double bench_median(size_t (*run)(size_t), size_t size, double ms, int runs) {
+    double r[BENCH_MAX_RUNS], rate;
+    int i, j;
+
+    for (i = 0; i < runs; i++) {        /* insertion sort as they come      */
+        rate = bench_rate(run, size, ms);
+        for (j = i; j > 0 && r[j - 1] > rate; j--) r[j] = r[j - 1];
+        r[j] = rate;
+    }
+    return runs % 2 ? r[runs / 2] : (r[runs / 2 - 1] + r[runs / 2]) / 2.0;
+}
+
+static int bench_alloc(void) {
+    int i;
+
+    g_src  = (char *)malloc(BENCH_MAX_SIZE + 1);
+    g_pad  = (char *)malloc(BENCH_MAX_SIZE + 9);
+    g_work = (char *)malloc(BENCH_MAX_SIZE + 9);
+    g_upper = (char *)malloc(BENCH_MAX_SIZE + 1);
+    g_dst  = (char *)malloc(BENCH_MAX_SIZE * 4 + 16);
+    g_dec  = (char *)malloc(BENCH_MAX_SIZE + 1);
+    g_hex  = (char *)malloc(BENCH_MAX_SIZE + 1);
+    g_oct  = (char *)malloc(BENCH_MAX_SIZE + 1);
+    g_dec_f = (aiu_str *)malloc(BENCH_MAX_FIELDS * sizeof(aiu_str));
+    g_hex_f = (aiu_str *)malloc(BENCH_MAX_FIELDS * sizeof(aiu_str));
+    g_oct_f = (aiu_str *)malloc(BENCH_MAX_FIELDS * sizeof(aiu_str));
+    g_vals = (uint32_t *)malloc(BENCH_MAX_SIZE / 4 * sizeof(uint32_t));
+    g_out  = (int64_t *)malloc(BENCH_MAX_FIELDS * sizeof(int64_t));
+    g_spans = (aiu_str *)malloc(BENCH_MAX_FIELDS * sizeof(aiu_str));
+    g_text = (char *)malloc(BENCH_MAX_SIZE + 1);
+    g_csv  = (char *)malloc(BENCH_MAX_SIZE + 1);
+    for (i = 0; i < BENCH_FIELDS; i++) {
+        g_slices[i].position  = (size_t)i * 4;
+        g_slices[i].length    = 4;
+        g_slices[i].dest      = g_dst + i * 8;
+        g_slices[i].dest_size = 8;
+    }
+    for (i = 0; i < 4; i++) {
+        g_csvcols[i].type = i == 0 ? AIU_COL_DEC : i == 1 ? AIU_COL_HEX :
+                            i == 2 ? AIU_COL_OCT : AIU_COL_TRIM;
+        g_csvcols[i].ints = (int64_t *)malloc(BENCH_MAX_ROWS * sizeof(int64_t));
+        g_csvcols[i].strs = (aiu_str *)malloc(BENCH_MAX_ROWS * sizeof(aiu_str));
+        g_csvcols[i].rcs  = NULL;
+        if (!g_csvcols[i].ints || !g_csvcols[i].strs) return 0;
+    }
+
+    return g_src && g_pad && g_work && g_upper && g_dst && g_dec && g_hex && g_oct &&
+           g_dec_f && g_hex_f && g_oct_f && g_vals && g_out && g_spans &&
+           g_text && g_csv;
+}
+
+/* One result of a saved --json run, for --baseline */
+typedef struct bench_base {
+    char   name[32];
+    size_t size;
+    double per_sec;
+} bench_base;
+
+static bench_base g_base[BENCH_COUNT * BENCH_NSIZES];
+static size_t     g_base_n;
+
+/****************************************************************************/
+/* bench_load_baseline() - read the results of a saved --json run           */
+/*                                                                          */
+/* Only the "function", "size" and "per_sec" fields are used, in the order  */
+/* this program writes them.                                                */
+/*                                                                          */
+/* RETURNS: 1 on success, 0 if the file can't be read or has no results.    */
+/****************************************************************************/
+static int bench_load_baseline(const char *path) {
+    FILE *f = fopen(path, "rb");
+    char *text, *p;
+    long len;
+
+    if (!f) return 0;
+    if (fseek(f, 0, SEEK_END) != 0 || (len = ftell(f)) < 0 || fseek(f, 0, SEEK_SET) != 0 ||
+        (text = (char *)malloc((size_t)len + 1)) == NULL) {
+        fclose(f);
+        return 0;
+    }
+    len = (long)fread(text, 1, (size_t)len, f);
+    text[len] = '\0';
+    fclose(f);
+
+    for (p = text; g_base_n < BENCH_COUNT * BENCH_NSIZES &&
+                   (p = strstr(p, "{\"function\":\"")) != NULL; p++) {
+        bench_base *e = &g_base[g_base_n];
+        unsigned long size;
+        char *q;
+
+        if (sscanf(p, "{\"function\":\"%31[^\"]\",\"size\":%lu", e->name, &size) != 2) continue;
+        if ((q = strstr(p, "\"per_sec\":")) == NULL) break;
+        e->size = (size_t)size;
+        e->per_sec = atof(q + 10);
+        g_base_n++;
+    }
+    free(text);
+    return g_base_n > 0;
+}
+
+/* Baseline rate of "name" at "size", or 0 if the baseline has none */
+static double bench_baseline_rate(const char *name, size_t size) {
+    size_t i;
+
+    for (i = 0; i < g_base_n; i++)
+        if (g_base[i].size == size && !strcmp(g_base[i].name, name)) return g_base[i].per_sec;
+    return 0.0;
+}
+
+int main(int argc, char **argv) {
+    const char *filter = NULL, *baseline = NULL;
+    double ms = 20.0, tolerance = 10.0;
+    int json = 0, first = 1, runs = 5, i;
+    size_t s, b, compared = 0, regressions = 0;
+
+    for (i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--json")) json = 1;
+        else if (!strcmp(argv[i], "--ms") && i + 1 < argc) ms = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--runs") && i + 1 < argc) runs = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--filter") && i + 1 < argc) filter = argv[++i];
+        else if (!strcmp(argv[i], "--baseline") && i + 1 < argc) baseline = argv[++i];
+        else if (!strcmp(argv[i], "--tolerance") && i + 1 < argc) tolerance = atof(argv[++i]);
+        else {
+            fprintf(stderr, "usage: %s [--json] [--ms N] [--runs N] [--filter NAME] "
+                    "[--baseline FILE [--tolerance PCT]]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (runs < 1 || runs > BENCH_MAX_RUNS) {
+        fprintf(stderr, "aiutils_bench: --runs must be 1 to %d\n", BENCH_MAX_RUNS);
+        return 2;
+    }
+    if (baseline && !bench_load_baseline(baseline)) {
+        fprintf(stderr, "aiutils_bench: no results in baseline \"%s\"\n", baseline);
+        return 2;
+    }
+    if (!bench_alloc()) {
+        fprintf(stderr, "aiutils_bench: out of memory\n");
+        return 1;
+    }
+
+    if (json) {
+#if defined(AIUTILS_SIMD)
+        printf("{\"simd\":true,\"variant\":\"%s\",\"results\":[", aiu_cpu_variant_name());
+#else
+        printf("{\"simd\":false,\"variant\":\"%s\",\"results\":[", aiu_cpu_variant_name());
+#endif
+    } else {
+        printf("kernels: %s (AIUTILS_CPU overrides)\n", aiu_cpu_variant_name());
+        printf("%-24s %8s %14s %-6s %-10s %14s %7s\n", "function", "size",
+               "per_sec", "unit", "libc", "libc_per_sec", "ratio");
+    }
+
+    for (s = 0; s < BENCH_NSIZES; s++) {
+        size_t size = bench_sizes[s];
+
+        bench_prepare(size);
+        for (b = 0; b < BENCH_COUNT; b++) {
+            const bench *bn = &benches[b];
+            double rate, libc_rate = 0.0;
+
+            if (filter && !strstr(bn->name, filter)) continue;
+            rate = bench_median(bn->run, size, ms, runs);
+            if (bn->run_libc) libc_rate = bench_median(bn->run_libc, size, ms, runs);
+
+            if (baseline) {
+                double base = bench_baseline_rate(bn->name, size);
+                double floor = base * (1.0 - tolerance / 100.0);
+
+                if (base > 0.0) {
+                    compared++;
+                    if (rate < floor) {
+                        fprintf(stderr, "REGRESSION %s size %lu: %.4g/s vs baseline "
+                                "%.4g/s (%+.1f%%)\n",
+                                bn->name, (unsigned long)size, rate, base,
+                                (rate / base - 1.0) * 100.0);
+                        regressions++;
+                    }
+                }
+            }
+
+            if (json) {
+                printf("%s\n{\"function\":\"%s\",\"size\":%lu,\"unit\":\"%s\","
+                       "\"per_sec\":%.0f,\"libc\":\"%s\",\"libc_per_sec\":%.0f}",
+                       first ? "" : ",", bn->name, (unsigned long)size, bn->unit,
+                       rate, bn->libc ? bn->libc : "", libc_rate);
+                first = 0;
+            } else {
+                printf("%-24s %8lu %14.4g %-6s %-10s %14.4g %7.2f\n",
+                       bn->name, (unsigned long)size, rate, bn->unit,
+                       bn->libc ? bn->libc : "-", libc_rate,
+                       libc_rate > 0.0 ? rate / libc_rate : 0.0);
+            }
+            fflush(stdout);
+        }
+    }
+    if (json) printf("\n]}\n");
+
+    if (g_lines) fclose(g_lines);
+    if (baseline) {
+        fprintf(stderr, "perf gate: %lu of %lu results more than %.0f%% below \"%s\"\n",
+                (unsigned long)regressions, (unsigned long)compared, tolerance, baseline);
+        if (regressions) return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,334 @@
+/* aiutils_fuzz - differential fuzz target for the accelerated functions.   */
+/*                                                                          */
+/* Every input is run through the optimized functions (word-at-a-time       */
+/* parsers, SIMD kernels, batch and slice APIs) and through frozen scalar   */
+/* copies of the legacy code (aiutils_legacy.h), and the run aborts on the  */
+/* first difference in output, return code or bytes written. The frozen     */
+/* copies are the compatibility contract: hexatoi()'s signs anywhere and    */
+/* 0/1/4 codes, decatoi()'s strtoll() rules and length > 20 rejection,      */
+/* fitoa()'s '*' fill. Do not speed them up.                                */
+/*                                                                          */
+/* BUILD:   libFuzzer: clang -g -O1 -fsanitize=fuzzer,address,undefined     */
+/*                     -DAIUTILS_SIMD -o aiutils_fuzz aiutils_fuzz.c        */
+/*                     aiutils.c                                            */
+/*          AFL++:     afl-clang-fast -g -O1 -DAIUTILS_SIMD                 */
+/*                     -DAIUTILS_FUZZ_MAIN -o aiutils_fuzz aiutils_fuzz.c   */
+/*                     aiutils.c                                            */
+/*          plain:     cc -g -O1 -DAIUTILS_FUZZ_MAIN -o aiutils_fuzz        */
+/*                     aiutils_fuzz.c aiutils.c                             */
+/*                                                                          */
+/* USAGE:   (AIUTILS_FUZZ_MAIN builds)                                      */
+/*          aiutils_fuzz [FILE...]   one input per file (AFL's @@, or a     */
+/*                                   corpus replay); stdin if no FILE       */
+/*          aiutils_fuzz -n N [-s SEED]  N generated inputs                 */
+/*          Run once per kernel variant: AIUTILS_CPU=scalar, sse2, ...      */
+#include "aiutils.h"
+#include "aiutils_legacy.h"
+#include <errno.h>
+
+/* Copy chars, dest sizes and widths the harness works within */
+#define FUZZ_BUF    160                 /* every dest buffer, with canary   */
+#define FUZZ_FIELDS 64                  /* ','-separated numeric fields     */
+
+static void fuzz_fail(const char *what) {
+    fprintf(stderr, "aiutils_fuzz: %s differs from the legacy code\n", what);
+    abort();
+}
+
+#define FUZZ_CHECK(cond, what) do { if (!(cond)) fuzz_fail(what); } while (0)
+
+static int fuzz_sign(int x) { return (x > 0) - (x < 0); }
+
+/****************************************************************************/
+/* fuzz_numbers() - decatoi()/octatoi()/hexatoi() and their batch forms     */
+/*                                                                          */
+/* The whole text is parsed as one field, then split on ',' for the batch   */
+/* functions. Values are compared even on failure: hexatoi() keeps the      */
+/* digits seen so far, decatoi() and octatoi() leave "*value" untouched.    */
+/****************************************************************************/
+static void fuzz_numbers(const char *t, size_t len) {
+    aiu_str f[FUZZ_FIELDS];
+    int64_t got[FUZZ_FIELDS], want[FUZZ_FIELDS];
+    int rcs[FUZZ_FIELDS], rc, ref;
+    size_t n = 0, i, start = 0, ok;
+    int64_t a = -7, b = -7;
+
+    rc = decatoi(t, len, &a);
+    ref = ref_decatoi(t, len, &b);
+    FUZZ_CHECK(rc == ref && a == b, "decatoi");
+    a = b = -7;
+    rc = octatoi(t, len, &a);
+    ref = ref_octatoi(t, len, &b);
+    FUZZ_CHECK(rc == ref && a == b, "octatoi");
+    rc = hexatoi(t, len, &a);
+    ref = ref_hexatoi(t, len, &b);
+    FUZZ_CHECK(rc == ref && a == b, "hexatoi");
+
+    for (i = 0; i <= len && n < FUZZ_FIELDS; i++) {
+        if (i == len || t[i] == ',') {
+            f[n].ptr = t + start;
+            f[n].len = i - start;
+            n++;
+            start = i + 1;
+        }
+    }
+
+    for (i = 0; i < n; i++) got[i] = want[i] = -7;
+    ok = decatoi_batch(f, n, got, rcs);
+    for (i = 0; i < n; i++) {
+        ref = ref_decatoi(f[i].ptr, f[i].len, &want[i]);
+        FUZZ_CHECK(rcs[i] == ref && got[i] == want[i], "decatoi_batch");
+        ok -= (size_t)ref;
+    }
+    FUZZ_CHECK(ok == 0, "decatoi_batch count");
+
+    ok = hexatoi_batch(f, n, got, rcs);
+    for (i = 0; i < n; i++) {
+        ref = ref_hexatoi(f[i].ptr, f[i].len, &want[i]);
+        FUZZ_CHECK(rcs[i] == ref && got[i] == want[i], "hexatoi_batch");
+        ok -= (size_t)(ref != 1);
+    }
+    FUZZ_CHECK(ok == 0, "hexatoi_batch count");
+}
+
+/****************************************************************************/
+/* fuzz_format() - fitoa() and friends, with values taken from the input    */
+/****************************************************************************/
+static void fuzz_format(const unsigned char *d, size_t len, size_t wid) {
+    uint32_t vals[FUZZ_FIELDS];
+    char got[FUZZ_FIELDS * 24 + 1], want[FUZZ_FIELDS * 24 + 1];
+    int rcs[FUZZ_FIELDS], fit[FUZZ_FIELDS];
+    size_t n = 0, i, ok;
+
+    for (; len >= 4 && n < FUZZ_FIELDS; d += 4, len -= 4, n++) {
+        vals[n] = (uint32_t)d[0] | (uint32_t)d[1] << 8 |
+                  (uint32_t)d[2] << 16 | (uint32_t)d[3] << 24;
+        vals[n] >>= d[0] % 32;          /* short numbers too, not just huge */
+    }
+    if (n == 0) return;
+
+    for (i = 0; i < n; i++) {
+        uint64_t wide = (uint64_t)vals[i] * (vals[i] | 1);
+
+        memset(got, 'x', 24);
+        memset(want, 'x', 24);
+        fitoa(vals[i], wid, got);
+        fit[i] = ref_fitoa(vals[i], wid, want);
+        FUZZ_CHECK(!memcmp(got, want, 24), "fitoa");
+        fitoa64(wide, wid, got);
+        ref_fitoa(wide, wid, want);
+        FUZZ_CHECK(!memcmp(got, want, 24), "fitoa64");
+    }
+
+    memset(got, 'x', sizeof(got));
+    memset(want, 'x', sizeof(want));
+    fitoa_column(vals, n, wid, got, wid + 1);
+    for (i = 0; i < n; i++) {
+        ref_fitoa(vals[i], wid, want + i * (wid + 1));
+        want[i * (wid + 1) + wid] = 'x';    /* fitoa_column() writes no null */
+    }
+    FUZZ_CHECK(!memcmp(got, want, n * (wid + 1)), "fitoa_column");
+
+    memset(got, 'x', sizeof(got));
+    ok = fitoa_batch(vals, n, wid, got, rcs);
+    for (i = 0; i < n; i++) {
+        ref_fitoa(vals[i], wid, want + i * (wid + 1));
+        FUZZ_CHECK(rcs[i] == fit[i], "fitoa_batch code");
+        ok -= (size_t)fit[i];
+    }
+    FUZZ_CHECK(!memcmp(got, want, n * (wid + 1)) && got[n * (wid + 1)] == 'x', "fitoa_batch");
+    FUZZ_CHECK(ok == 0, "fitoa_batch count");
+}
+
+/****************************************************************************/
+/* fuzz_strings() - the copy, case, compare and slice functions             */
+/*                                                                          */
+/* "s" is the text up to its first null, "t"/"len" all of it (nulls too).   */
+/* Every dest is a FUZZ_BUF buffer pre-filled with 'x', compared whole, so  */
+/* writing past the null or past "dsize" shows up as a difference.          */
+/****************************************************************************/
+static void fuzz_strings(const char *s, const char *t, size_t len, size_t dsize,
+                         size_t pos, size_t want_len) {
+    char got[FUZZ_BUF], want[FUZZ_BUF];
+    size_t slen = strlen(s), split = len / 2, n, m;
+    const char *tail;
+    int cut;
+
+    memset(got, 'x', FUZZ_BUF);
+    memset(want, 'x', FUZZ_BUF);
+    strzcpy(got, s, dsize);
+    ref_strzcpy(want, s, dsize);
+    FUZZ_CHECK(!memcmp(got, want, FUZZ_BUF), "strzcpy");
+
+    memset(got, 'x', FUZZ_BUF);
+    n = strzcpy_n(got, s, dsize, &cut);
+    FUZZ_CHECK(!memcmp(got, want, FUZZ_BUF), "strzcpy_n");
+    FUZZ_CHECK(n == (dsize ? strlen(want) : 0), "strzcpy_n length");
+    FUZZ_CHECK(cut == (dsize ? slen > dsize - 1 : slen > 0), "strzcpy_n truncated");
+
+    /* Appending the back half of "s" to a prefix of it that fits */
+    tail = s + slen / 2;
+    m = dsize ? (pos < dsize - 1 ? pos : dsize - 1) : 0;
+    if (m > slen) m = slen;
+    memset(got, 'x', FUZZ_BUF);
+    memcpy(got, s, m);
+    got[m] = '\0';
+    memcpy(want, got, FUZZ_BUF);
+    if (dsize > m) {
+        strzcat(got, tail, dsize);
+        ref_strzcat(want, tail, dsize);
+        FUZZ_CHECK(!memcmp(got, want, FUZZ_BUF), "strzcat");
+        memset(got + m, 'x', FUZZ_BUF - m);
+        got[m] = '\0';
+        n = strzcat_at(got, m, tail, dsize, &cut);
+        FUZZ_CHECK(!memcmp(got, want, FUZZ_BUF), "strzcat_at");
+        FUZZ_CHECK(n == strlen(want), "strzcat_at length");
+        FUZZ_CHECK(cut == (strlen(tail) > dsize - 1 - m), "strzcat_at truncated");
+    }
+
+    memset(got, 'x', FUZZ_BUF);
+    memset(want, 'x', FUZZ_BUF);
+    makelower_safe_copy(got, s, dsize);
+    ref_makelower(want, s, dsize);
+    FUZZ_CHECK(!memcmp(got, want, FUZZ_BUF), "makelower_safe_copy");
+
+    memset(got, 'x', FUZZ_BUF);
+    memset(want, 'x', FUZZ_BUF);
+    substring_safe_copy(got, s, dsize, pos, want_len);
+    ref_substring(want, s, dsize, pos, want_len);
+    FUZZ_CHECK(!memcmp(got, want, FUZZ_BUF), "substring_safe_copy");
+
+    memset(got, 'x', FUZZ_BUF);
+    memset(want, 'x', FUZZ_BUF);
+    n = substring_safe_copy_n(got, t, len, dsize, pos, want_len);
+    m = ref_substring_n(want, t, len, dsize, pos, want_len);
+    FUZZ_CHECK(n == m && !memcmp(got, want, FUZZ_BUF), "substring_safe_copy_n");
+
+    {
+        aiu_slice sl;
+        aiu_str span;
+
+        sl.position = pos;
+        sl.length = want_len;
+        sl.dest = got;
+        sl.dest_size = dsize;
+        memset(got, 'x', FUZZ_BUF);
+        aiu_slice_copy(t, len, &sl, 1, &n);
+        FUZZ_CHECK(n == m && !memcmp(got, want, FUZZ_BUF), "aiu_slice_copy");
+        aiu_slice_spans(t, len, &sl, 1, &span);
+        n = pos < len ? len - pos : 0;
+        if (n > want_len) n = want_len;
+        FUZZ_CHECK(span.len == n && (n == 0 || span.ptr == t + pos), "aiu_slice_spans");
+    }
+
+    n = len < FUZZ_BUF ? len : FUZZ_BUF;
+    memcpy(got, t, n);
+    memcpy(want, t, n);
+    uppercase_inplace_n(got, n);
+    ref_case_n(want, n, 1);
+    FUZZ_CHECK(!memcmp(got, want, n), "uppercase_inplace_n");
+    lowercase_inplace_n(got, n);
+    ref_case_n(want, n, 0);
+    FUZZ_CHECK(!memcmp(got, want, n), "lowercase_inplace_n");
+
+    FUZZ_CHECK(fuzz_sign(strcmpii_n(t, split, t + split, len - split)) ==
+               fuzz_sign(ref_strcmpii_n(t, split, t + split, len - split)), "strcmpii_n");
+    memcpy(got, t, n);
+    uppercase_inplace_n(got, n);                /* equal apart from case    */
+    FUZZ_CHECK(fuzz_sign(strcmpii_n(t, n, got, n)) ==
+               fuzz_sign(ref_strcmpii_n(t, n, got, n)), "strcmpii_n (case)");
+}
+
+/****************************************************************************/
+/* LLVMFuzzerTestOneInput() - one input through every comparison            */
+/*                                                                          */
+/* The first 3 bytes pick the dest size, position and length; the rest is   */
+/* the text (and, 4 bytes at a time, the numbers to format).                */
+/****************************************************************************/
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+    size_t dsize, pos, want_len, len;
+    char *t;
+
+    if (size < 3) return 0;
+    dsize = data[0] % (FUZZ_BUF - 32);
+    pos = data[1] % 64;
+    want_len = data[2] == 255 ? SIZE_MAX : data[2] % 96;
+    data += 3, size -= 3;
+
+    len = size < 4096 ? size : 4096;
+    t = (char *)malloc(len + 1);
+    if (!t) return 0;
+    memcpy(t, data, len);
+    t[len] = '\0';
+
+    fuzz_numbers(t, len);
+    fuzz_format(data, len, dsize % 24);
+    fuzz_strings(t, t, len, dsize, pos, want_len);
+
+    free(t);
+    return 0;
+}
+
+#if defined(AIUTILS_FUZZ_MAIN)
+/* Inputs made mostly of the chars the parsers and case code care about */
+static size_t fuzz_generate(unsigned char *buf, size_t max, uint32_t *state) {
+    static const char alpha[] = "0123456789abcdefABCDEF+- \t\n,xXzZ";
+    size_t n, i;
+
+    *state = *state * 1103515245u + 12345u;
+    n = (*state >> 8) % max;
+    for (i = 0; i < n; i++) {
+        uint32_t r;
+
+        *state = *state * 1103515245u + 12345u;
+        r = *state >> 8;
+        if (i < 3 || r % 8 == 0) buf[i] = (unsigned char)(r >> 8);
+        else if (r % 8 == 1) buf[i] = (unsigned char)"0123456789"[(r >> 8) % 10];
+        else buf[i] = (unsigned char)alpha[(r >> 8) % (sizeof(alpha) - 1)];
+    }
+    return n;
+}
+
+static int fuzz_file(FILE *f) {
+    static unsigned char buf[1 << 16];
+    size_t n = fread(buf, 1, sizeof(buf), f);
+
+    LLVMFuzzerTestOneInput(buf, n);
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    unsigned long iters = 0, i;
+    uint32_t seed = 1;
+    int a, files = 0;
+
+    for (a = 1; a < argc; a++) {
+        if (!strcmp(argv[a], "-n") && a + 1 < argc) iters = strtoul(argv[++a], NULL, 10);
+        else if (!strcmp(argv[a], "-s") && a + 1 < argc)
+            seed = (uint32_t)strtoul(argv[++a], NULL, 10);
+        else {
+            FILE *f = fopen(argv[a], "rb");
+
+            if (!f) {
+                fprintf(stderr, "aiutils_fuzz: can't open \"%s\"\n", argv[a]);
+                return 2;
+            }
+            fuzz_file(f);
+            fclose(f);
+            files++;
+        }
+    }
+
+    if (iters) {
+        static unsigned char buf[512];
+
+        for (i = 0; i < iters; i++)
+            LLVMFuzzerTestOneInput(buf, fuzz_generate(buf, sizeof(buf), &seed));
+        printf("aiutils_fuzz: %lu generated inputs match (kernels: %s)\n",
+               iters, aiu_cpu_variant_name());
+    } else if (!files) {
+        fuzz_file(stdin);
+    }
+    return 0;
+}
+#endif
@@ -0,0 +1,186 @@
+/* aiutils_hpp_test - checks of the C++17 wrappers in aiutils.hpp.          */
+/*                                                                          */
+/* The constexpr number parsers are checked twice: on literals with         */
+/* static_assert (so a wrong port fails the build), and at run time, where  */
+/* the detail:: ports are compared with decatoi()/hexatoi()/octatoi() on    */
+/* random text. copy() and cat() are compared with a plain reference on     */
+/* both sides of the 17-char fixed-move limit, embedded nulls included.     */
+/*                                                                          */
+/* BUILD:   make check (builds and runs it), or                             */
+/*          cc -O2 -c aiutils.c &&                                          */
+/*          c++ -std=c++17 -O2 -o aiutils_hpp_test aiutils_hpp_test.cpp     */
+/*              aiutils.o                                                   */
+/*                                                                          */
+/* USAGE:   aiutils_hpp_test [-n N]                                         */
+/*          -n N      random inputs per check (default 200000)              */
+/*          Exits 0 if every check passed, 1 otherwise.                     */
+#include "aiutils.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+/****************************************************************************/
+/* Compile-time checks: these run the detail:: ports                        */
+/****************************************************************************/
+static_assert(*aiu::parse_dec<int>("42") == 42);
+static_assert(*aiu::parse_dec<int>(" -17") == -17);
+static_assert(*aiu::parse_dec("") == 0);
+static_assert(!aiu::parse_dec<int>("12a"));
+static_assert(!aiu::parse_dec<int>("-"));
+static_assert(!aiu::parse_dec<std::int8_t>("128"));
+static_assert(*aiu::parse_dec<std::int8_t>("-128") == -128);
+static_assert(!aiu::parse_dec<unsigned>("-1"));
+static_assert(*aiu::parse_dec("9223372036854775807") == INT64_MAX);
+static_assert(*aiu::parse_dec("-9223372036854775808") == INT64_MIN);
+static_assert(!aiu::parse_dec("9223372036854775808"));
+
+static_assert(*aiu::parse_hex<int>("ff") == 255);
+static_assert(*aiu::parse_hex<int>("-1F") == -31);
+static_assert(*aiu::parse_hex<int>("1 0") == 16);
+static_assert(*aiu::parse_hex<std::uint64_t>("ffffffffffffffff") == UINT64_MAX);
+static_assert(*aiu::parse_hex<std::int64_t>("ffffffffffffffff") == -1);
+static_assert(!aiu::parse_hex<std::uint8_t>("100"));
+static_assert(!aiu::parse_hex<int>("0x10"));
+
+static_assert(*aiu::parse_oct<int>("755") == 493);
+static_assert(*aiu::parse_oct<int>("-10") == -8);
+static_assert(!aiu::parse_oct<int>("8"));
+static_assert(*aiu::parse_oct("777777777777777777777") == INT64_MAX);
+static_assert(!aiu::parse_oct("1000000000000000000000"));
+
+static unsigned long g_checks;          /* comparisons made                 */
+static unsigned long g_failures;        /* comparisons that differed        */
+static unsigned long g_iters = 200000;  /* random inputs per check          */
+
+static std::uint32_t test_rand_state = 1;
+static std::uint32_t test_rand() {
+    test_rand_state = test_rand_state * 1103515245u + 12345u;
+    return test_rand_state >> 8;
+}
+
+/* Count one comparison; print the first 20 that differ */
+static void test_check(bool ok, const char *what, std::string_view s) {
+    g_checks++;
+    if (ok || ++g_failures > 20) return;
+    std::fprintf(stderr, "FAIL %s on \"", what);
+    for (char ch : s) {
+        unsigned char c = (unsigned char)ch;
+
+        if (c >= 0x20 && c < 0x7F && c != '"' && c != '\\') std::fputc(c, stderr);
+        else std::fprintf(stderr, "\\x%02X", c);
+    }
+    std::fprintf(stderr, "\" (%lu bytes)\n", (unsigned long)s.size());
+}
+
+/* Random text of up to "max" chars, mostly from "alpha" */
+static std::string test_text(std::size_t max, const char *alpha) {
+    std::size_t n = test_rand() % (max + 1), na = std::strlen(alpha);
+    std::string s(n, '\0');
+
+    for (char &c : s) {
+        std::uint32_t r = test_rand();
+
+        c = (r % 16 == 0) ? (char)(r >> 8) : alpha[(r >> 8) % na];
+    }
+    return s;
+}
+
+/****************************************************************************/
+/* test_parse() - the constexpr ports against the C parsers                 */
+/*                                                                          */
+/* Each of detail::dec/hex/oct() must succeed exactly when the C parser     */
+/* does (hexatoi()'s 0 and 4 are both success) and give the same value, on  */
+/* random text near the length and range limits.                            */
+/****************************************************************************/
+static void test_parse() {
+    for (unsigned long i = 0; i < g_iters; i++) {
+        static const char *const alphas[] = { "0123456789abcdefABCDEF +-", " +-0123456789", "01234567" };
+        std::string s = test_text(i % 2 ? 24 : 6, alphas[i % 3]);
+        std::int64_t a = 0, b = 0;
+        bool ok;
+
+        ok = aiu::detail::dec(s, &a);
+        test_check(ok == (decatoi(s.data(), s.size(), &b) != 0) && (!ok || a == b),
+                   "detail::dec", s);
+        ok = aiu::detail::oct(s, &a);
+        test_check(ok == (octatoi(s.data(), s.size(), &b) != 0) && (!ok || a == b),
+                   "detail::oct", s);
+        ok = aiu::detail::hex(s, &a);
+        test_check(ok == (hexatoi(s.data(), s.size(), &b) != 1) && (!ok || a == b),
+                   "detail::hex", s);
+
+        auto p = aiu::parse_dec<std::int16_t>(s);
+        ok = decatoi(s.data(), s.size(), &b) && b >= INT16_MIN && b <= INT16_MAX;
+        test_check(p.has_value() == ok && (!ok || *p == b), "parse_dec<int16_t>", s);
+    }
+}
+
+/****************************************************************************/
+/* test_copy() - copy() and cat() into char[N], N <= 17 and N > 17          */
+/*                                                                          */
+/* Targets sit in a buffer of 'x' bytes; the result must be the source cut  */
+/* to N - 1 chars (nulls in a string_view copied as text), one null, and    */
+/* every other byte untouched. The char-array overloads stop at the first   */
+/* null of the array.                                                       */
+/****************************************************************************/
+template <std::size_t N>
+static void test_copy_n() {
+    struct { char d[N]; char guard[8]; } t;
+
+    for (unsigned long i = 0; i < g_iters / 8; i++) {
+        std::string s = test_text(N + 4, "abc"), want(sizeof(t), 'x');
+        if (!s.empty() && i % 2) s[test_rand() % s.size()] = '\0';
+        std::size_t len = test_rand() % (N + 2), n = s.size() < N - 1 ? s.size() : N - 1, got;
+
+        std::memset(&t, 'x', sizeof(t));
+        got = aiu::copy(t.d, std::string_view(s));
+        want.replace(0, n, s, 0, n);
+        want[n] = '\0';
+        test_check(got == n && !std::memcmp(&t, want.data(), sizeof(t)), "aiu::copy", s);
+
+        /* cat() after "len" chars of 'y', or nothing if that fills dest */
+        std::memset(&t, 'x', sizeof(t));
+        std::memset(t.d, 'y', len < N ? len : N);
+        want.assign(sizeof(t), 'x');
+        want.replace(0, len < N ? len : N, len < N ? len : N, 'y');
+        if (len < N - 1) {
+            n = s.size() < N - 1 - len ? s.size() : N - 1 - len;
+            want.replace(len, n, s, 0, n);
+            want[len + n] = '\0';
+            n += len;
+        } else {
+            n = N - 1;
+        }
+        got = aiu::cat(t.d, len, std::string_view(s));
+        test_check(got == n && !std::memcmp(&t, want.data(), sizeof(t)), "aiu::cat", s);
+    }
+
+    char d[N];
+    const char src[] = "ab\0cdefghijklmnopqrstuvw";      /* stops at the null */
+    test_check(aiu::copy(d, src) == (N > 2 ? 2 : N - 1) && d[N > 2 ? 2 : N - 1] == '\0',
+               "aiu::copy array", std::string_view(src, sizeof(src)));
+    test_check(aiu::cat(d, std::strlen(d), src) == (N > 4 ? 4 : N - 1), "aiu::cat array",
+               std::string_view(src, sizeof(src)));
+}
+
+static void test_copy() {
+    test_copy_n<1>();
+    test_copy_n<2>();
+    test_copy_n<8>();
+    test_copy_n<16>();
+    test_copy_n<17>();
+    test_copy_n<18>();
+    test_copy_n<40>();
+}
+
+int main(int argc, char **argv) {
+    for (int a = 1; a < argc; a++) {
+        if (!std::strcmp(argv[a], "-n") && a + 1 < argc) g_iters = std::strtoul(argv[++a], NULL, 10);
+    }
+
+    test_parse();
+    test_copy();
+    std::printf("aiutils_hpp_test: %lu checks, %lu failed\n", g_checks, g_failures);
+    return g_failures ? 1 : 0;
+}
@@ -0,0 +1,265 @@
+/* aiutils_legacy.h - frozen copies of the code the rewrites replaced.      */
+/*                                                                          */
+/* Scalar code of aiutils.c as it was before each rewrite, shared by        */
+/* aiutils_test.c and aiutils_fuzz.c so both check against one contract:    */
+/* hexatoi()'s signs anywhere and 0/1/4 codes, decatoi()'s strtoll() rules  */
+/* and length > 20 rejection, fitoa()'s '*' fill, and so on. Signed         */
+/* overflow that the old code relied on is done unsigned; nothing else      */
+/* changes. Do not speed these up.                                          */
+/*                                                                          */
+/* Every function is static and inline, so a file that uses only some of    */
+/* them builds without unused-function warnings. Not part of the library.   */
+#ifndef AIUTILS_LEGACY_H
+#define AIUTILS_LEGACY_H
+
+#include "aiutils.h"
+
+#if defined(_MSC_VER)
+#define AIU_LEGACY static __inline
+#elif defined(__GNUC__) || defined(__clang__)
+#define AIU_LEGACY static __inline__
+#else
+#define AIU_LEGACY static
+#endif
+
+/* hexatoi() before the table and the 8-digit fast path */
+AIU_LEGACY int ref_hexatoi(const char *string, size_t length, int64_t *value) {
+    uint64_t v = 0;
+    int retcode = 0, sign = 0;
+    size_t i;
+
+    *value = 0;
+    for (i = 0; i < length; i++) {
+        switch (string[i]) {
+        case '0': case '1': case '2': case '3': case '4':
+        case '5': case '6': case '7': case '8': case '9':
+            v = (v << 4) | (uint64_t)(string[i] - '0');
+            break;
+        case 'A': case 'B': case 'C': case 'D': case 'E': case 'F':
+            v = (v << 4) | (uint64_t)(string[i] + 10 - 'A');
+            break;
+        case 'a': case 'b': case 'c': case 'd': case 'e': case 'f':
+            v = (v << 4) | (uint64_t)(string[i] + 10 - 'a');
+            break;
+        case ' ':
+            retcode |= 4;
+            break;
+        case '-':
+            sign = -1;
+            retcode |= 4;
+            break;
+        case '+':
+            sign = 1;
+            retcode |= 4;
+            break;
+        default:
+            *value = (int64_t)v;        /* the digits so far are kept       */
+            return 1;
+        }
+        *value = (int64_t)v;
+    }
+    if (sign == -1) *value = (int64_t)(0 - v);
+    return retcode;
+}
+
+/* decatoi() before the in-place parser: a copy and strtoll() */
+AIU_LEGACY int ref_decatoi(const char *string, size_t length, int64_t *value) {
+    char *eptr;
+    char str2conv[21];
+    int64_t result;
+
+    if (length > 20) return(0);
+    strncpy(str2conv, string, length);
+    str2conv[length] = '\0';
+
+    errno = 0;
+    result = strtoll(str2conv, &eptr, 10);
+    if (errno == EINVAL || errno == ERANGE) return(0);
+    if ((size_t)(eptr - str2conv) != length) return(0);
+    if (*eptr != 0) return(0);
+
+    *value = result;
+    return(1);
+}
+
+/* octatoi() as README.md documented it: decatoi()'s wrapper with base 8 */
+AIU_LEGACY int ref_octatoi(const char *string, size_t length, int64_t *value) {
+    char *eptr;
+    char str2conv[24];
+    int64_t result;
+
+    if (length > 23) return(0);
+    strncpy(str2conv, string, length);
+    str2conv[length] = '\0';
+
+    errno = 0;
+    result = strtoll(str2conv, &eptr, 8);
+    if (errno == EINVAL || errno == ERANGE) return(0);
+    if ((size_t)(eptr - str2conv) != length) return(0);
+
+    *value = result;
+    return(1);
+}
+
+/* laststrstr() before laststrstr_n(): strstr() again after every match */
+AIU_LEGACY const char *ref_laststrstr(const char *haystack, const char *needle) {
+    const char *last_match = NULL, *p;
+
+    if (*needle == '\0') return haystack + strlen(haystack);
+    for (p = haystack; (p = strstr(p, needle)) != NULL; p++) last_match = p;
+    return last_match;
+}
+
+/* The in-place and copy helpers before their _n variants: strlen() first */
+AIU_LEGACY void ref_strzcpy(char *d, const char *s, size_t dsize) {
+    if (dsize == 0) return;
+    while (*s && --dsize) *d++ = *s++;
+    *d = 0;
+}
+
+/* "d" must hold a string shorter than "dsize" (the legacy code overruns) */
+AIU_LEGACY void ref_strzcat(char *d, const char *s, size_t dsize) {
+    if (dsize <= 1) return;
+    while (*d) dsize--, d++;
+    while (*s && --dsize) *d++ = *s++;
+    *d = 0;
+}
+
+AIU_LEGACY void ref_trim_inplace(char *s, char mode) {
+    size_t len = strlen(s);
+    char *start = s, *end;
+
+    if (len == 0) return;
+    if (mode == 'l' || mode == 'b') {
+        while (*start != '\0' && isspace((unsigned char)*start)) start++;
+        if (start > s) {
+            memmove(s, start, len - (size_t)(start - s) + 1);
+            len = strlen(s);
+        }
+    }
+    if (mode == 'r' || mode == 'b') {
+        if (len == 0) return;
+        end = s + len - 1;
+        while (end >= s && isspace((unsigned char)*end)) end--;
+        *(end + 1) = '\0';
+    }
+}
+
+AIU_LEGACY void ref_remove_char(char *str, char c) {
+    size_t i, j, len = strlen(str);
+
+    for (i = 0, j = 0; i < len; i++)
+        if (str[i] != c) str[j++] = str[i];
+    str[j] = '\0';
+}
+
+AIU_LEGACY void ref_replace_char(char *str, char ch, char newch, int skipends) {
+    size_t i, len = strlen(str);
+
+    for (i = 0; i < len; i++)
+        if (str[i] == ch && !(skipends && (i == 0 || i == len - 1))) str[i] = newch;
+}
+
+AIU_LEGACY void ref_replace_char_copy(char *dest, const char *src, size_t dest_size,
+                                  char ch, char newch, int skipends) {
+    if (dest_size == 0) return;
+    ref_strzcpy(dest, src, dest_size);
+    ref_replace_char(dest, ch, newch, skipends);
+}
+
+AIU_LEGACY void ref_substring(char *dest, const char *src, size_t dest_size,
+                          size_t position, size_t length) {
+    size_t src_len, copy_len;
+
+    if (dest_size == 0) return;
+    src_len = strlen(src);
+    if (position >= src_len) {
+        dest[0] = '\0';
+        return;
+    }
+    copy_len = src_len - position;
+    if (copy_len > length) copy_len = length;
+    if (copy_len > dest_size - 1) copy_len = dest_size - 1;
+    strncpy(dest, src + position, copy_len);
+    dest[copy_len] = '\0';
+}
+
+/* substring_safe_copy_n(): the same on a (ptr,len) source */
+AIU_LEGACY size_t ref_substring_n(char *dest, const char *src, size_t src_len,
+                              size_t dest_size, size_t position, size_t length) {
+    size_t copy_len;
+
+    if (dest_size == 0) return 0;
+    if (position >= src_len) {
+        dest[0] = '\0';
+        return 0;
+    }
+    copy_len = src_len - position;
+    if (copy_len > length) copy_len = length;
+    if (copy_len > dest_size - 1) copy_len = dest_size - 1;
+    memcpy(dest, src + position, copy_len);
+    dest[copy_len] = '\0';
+    return copy_len;
+}
+
+AIU_LEGACY const char *ref_lastN(const char *s, size_t n) {
+    size_t length = strlen(s);
+
+    return length < n ? s : s + length - n;
+}
+
+/* trim_safe_copy() before trim_span(): copy everything, then trim it */
+AIU_LEGACY void ref_trim_copy(char *dest, const char *src, size_t dest_size, char mode) {
+    if (dest_size == 0) return;
+    ref_strzcpy(dest, src, dest_size);
+    ref_trim_inplace(dest, mode);
+}
+
+/* makelower_safe_copy() and the case _n functions before the blocks */
+AIU_LEGACY void ref_makelower(char *dest, const char *src, size_t dest_size) {
+    if (dest_size == 0) return;
+    while (*src && --dest_size > 0) {
+        *dest++ = isupper((unsigned char)*src) ? (char)tolower((unsigned char)*src) : *src;
+        src++;
+    }
+    *dest = '\0';
+}
+
+AIU_LEGACY void ref_case_n(char *s, size_t len, int upper) {
+    for (; len; len--, s++)
+        *s = (char)(upper ? toupper((unsigned char)*s) : tolower((unsigned char)*s));
+}
+
+/* fitoa() before the digit pairs, widened to 64 bits; 1 if "n" fit */
+AIU_LEGACY int ref_fitoa(uint64_t n, size_t wid, char *s) {
+    char *p = s + wid;
+
+    *p = '\0';
+    do {
+        if (p <= s) {
+            for (p = s + wid; p > s;) *--p = '*';
+            return 0;
+        }
+        *--p = (char)('0' + n % 10);
+        n /= 10;
+    } while (n);
+    while (p > s) *--p = ' ';
+    return 1;
+}
+
+/* strcmpii_n(): a byte loop over the ASCII fold */
+AIU_LEGACY int ref_fold(unsigned char c) {
+    return (c >= 'A' && c <= 'Z') ? c + 32 : c;
+}
+
+AIU_LEGACY int ref_strcmpii_n(const char *s1, size_t len1, const char *s2, size_t len2) {
+    size_t n = len1 < len2 ? len1 : len2, i;
+    int c;
+
+    for (i = 0; i < n; i++)
+        if ((c = ref_fold((unsigned char)s1[i]) - ref_fold((unsigned char)s2[i])) != 0) return c;
+    return (i < len1 ? ref_fold((unsigned char)s1[i]) : 0) -
+           (i < len2 ? ref_fold((unsigned char)s2[i]) : 0);
+}
+
+#endif /* AIUTILS_LEGACY_H */
@@ -0,0 +1,1397 @@
+/* aiutils_test - differential checks of the rewritten functions.           */
+/*                                                                          */
+/* Each check runs a function against a frozen copy of the code it          */
+/* replaced (aiutils_legacy.h, verbatim in behaviour) over every short      */
+/* input and a stream of random ones, and reports every difference in       */
+/* result, return code or bytes written. The frozen copies are the          */
+/* compatibility contract; do not speed them up.                            */
+/*                                                                          */
+/* BUILD:   make check (builds and runs it), or                             */
+/*          cc -O2 -pthread -o aiutils_test aiutils_test.c aiutils.c        */
+/*          (add -DAIUTILS_SIMD etc. to check the optional kernels)         */
+/*                                                                          */
+/* USAGE:   aiutils_test [-n N] [-s SEED] [NAME...]                         */
+/*          -n N      random inputs per check (default 200000)              */
+/*          -s SEED   random seed (default 1)                               */
+/*          NAME      only run the checks whose name contains NAME          */
+/*          Exits 0 if every check passed, 1 otherwise.                     */
+#include "aiutils.h"
+#include "aiutils_legacy.h"
+
+static unsigned long g_checks;          /* comparisons made                 */
+static unsigned long g_failures;        /* comparisons that differed        */
+static unsigned long g_iters = 200000;  /* random inputs per check          */
+
+static uint32_t test_rand_state = 1;
+static uint32_t test_rand(void) {
+    test_rand_state = test_rand_state * 1103515245u + 12345u;
+    return test_rand_state >> 8;
+}
+
+/****************************************************************************/
+/* test_fail() - report one difference, with the input that caused it       */
+/*                                                                          */
+/* Only the first 20 failures are printed; all of them are counted.         */
+/****************************************************************************/
+static int test_fail(const char *what, const char *s, size_t len) {
+    size_t i;
+
+    if (++g_failures > 20) return 0;
+    fprintf(stderr, "FAIL %s on \"", what);
+    for (i = 0; i < len; i++) {
+        unsigned char c = (unsigned char)s[i];
+
+        if (c >= 0x20 && c < 0x7F && c != '"' && c != '\\') fputc(c, stderr);
+        else fprintf(stderr, "\\x%02X", c);
+    }
+    fprintf(stderr, "\" (%lu bytes)\n", (unsigned long)len);
+    return 0;
+}
+
+#define TEST_CHECK(cond, what, s, len) \
+    (g_checks++, (cond) ? 1 : test_fail(what, s, len))
+
+/* Random text of up to "max" chars, mostly from "alpha" */
+static size_t test_text(char *buf, size_t max, const char *alpha) {
+    size_t n = test_rand() % (max + 1), na = strlen(alpha), i;
+
+    for (i = 0; i < n; i++) {
+        uint32_t r = test_rand();
+
+        buf[i] = (r % 16 == 0) ? (char)(r >> 8) : alpha[(r >> 8) % na];
+    }
+    return n;
+}
+
+/* Run "one" on every string of "len" chars from "alpha" (NULL: any byte) */
+static void test_every(size_t len, const char *alpha,
+                       int (*one)(const char *s, size_t len)) {
+    char s[8];
+    size_t na = alpha ? strlen(alpha) : 256, j;
+    unsigned long k, total = 1;
+
+    for (j = 0; j < len; j++) total *= na;
+    for (k = 0; k < total; k++) {
+        unsigned long x = k;
+
+        for (j = 0; j < len; j++, x /= na)
+            s[j] = alpha ? alpha[x % na] : (char)x;
+        one(s, len);
+    }
+}
+
+/****************************************************************************/
+/* test_hexatoi() - every string of 0..3 bytes, then random ones            */
+/*                                                                          */
+/* The random strings are long runs of hex digits (the 8-digit fast path    */
+/* and values shifted past 64 bits) with signs, blanks and bad chars mixed  */
+/* in. The value is compared on failure too: hexatoi() keeps the digits it  */
+/* parsed before the bad char. Then hexatoi_batch() over batches of 64      */
+/* fields, most of them 1..16 plain digits for its word path.               */
+/****************************************************************************/
+static int test_hexatoi_one(const char *s, size_t len) {
+    int64_t got = -7, want = -7;
+    int rc = hexatoi(s, len, &got);
+    int ref = ref_hexatoi(s, len, &want);
+
+    return TEST_CHECK(rc == ref && got == want, "hexatoi", s, len);
+}
+
+static void test_hexatoi(void) {
+    char s[48], text[64 * 24];
+    aiu_str f[64];
+    int64_t got[64], want[64];
+    int rcs[64];
+    unsigned long i;
+    size_t n, j;
+
+    for (n = 0; n <= 3; n++) test_every(n, NULL, test_hexatoi_one);
+
+    for (i = 0; i < g_iters; i++) {
+        size_t n = test_text(s, sizeof(s), i % 2 ? "0123456789abcdefABCDEF"
+                                                 : "0123456789abcdefABCDEF+- ");
+        test_hexatoi_one(s, n);
+    }
+
+    for (i = 0; i < g_iters / 64; i++) {
+        size_t ok, ref_ok = 0;
+
+        for (j = 0; j < 64; j++) {
+            f[j].ptr = text + j * 24;
+            f[j].len = test_text(text + j * 24, test_rand() % 4 ? 16 : 24,
+                                 j % 8 ? "0123456789abcdefABCDEF" : "0123456789aF+- ");
+            got[j] = want[j] = -7;
+        }
+        ok = hexatoi_batch(f, 64, got, rcs);
+        for (j = 0; j < 64; j++) {
+            int ref = ref_hexatoi(f[j].ptr, f[j].len, &want[j]);
+
+            TEST_CHECK(rcs[j] == ref && got[j] == want[j], "hexatoi_batch", f[j].ptr, f[j].len);
+            ref_ok += ref != 1;
+        }
+        TEST_CHECK(ok == ref_ok, "hexatoi_batch count", "", 0);
+    }
+}
+
+/* Random number text of up to "max" chars: a value of random magnitude in  */
+/* base "base" (INT64_MIN/MAX and their neighbours included), with blanks   */
+/* and a sign in front and, now and then, one char changed.                 */
+static size_t test_number(char *buf, size_t max, int base) {
+    static const char *const edges[] = {
+        "9223372036854775807", "9223372036854775808", "-9223372036854775808",
+        "-9223372036854775809", "777777777777777777777", "1000000000000000000000",
+        "-1000000000000000000000", "-1000000000000000000001",
+    };
+    char tmp[96];
+    size_t n = 0, i;
+    uint32_t r = test_rand();
+
+    if (r % 4 == 0) n += (size_t)snprintf(tmp, 8, "%.*s", (int)(r >> 2) % 3, " \t\n");
+    if (r % 8 == 1) tmp[n++] = "+-"[(r >> 8) % 2];
+    if (r % 16 == 2) {
+        n += (size_t)snprintf(tmp + n, sizeof(tmp) - n, "%s", edges[(r >> 8) % 8]);
+    } else {
+        uint64_t v = ((uint64_t)test_rand() << 40) ^ ((uint64_t)test_rand() << 20) ^ test_rand();
+
+        v >>= (r >> 4) % 64;
+        n += (size_t)snprintf(tmp + n, sizeof(tmp) - n, base == 8 ? "%llo" : "%llu",
+                              (unsigned long long)v);
+    }
+    if (r % 16 == 3 && n > 0) tmp[test_rand() % n] = " +-0x9\0"[(r >> 8) % 7];
+    if (n > max) n = max;
+    for (i = 0; i < n; i++) buf[i] = tmp[i];
+    return n;
+}
+
+/****************************************************************************/
+/* test_decatoi() - decatoi() and decatoi_batch() against strtoll()         */
+/*                                                                          */
+/* Every string of 0..3 bytes, every string of up to 6 chars from the ones  */
+/* strtoll() cares about, then random numbers of every length, including    */
+/* the overflow edges and the length > 20 rejection. "*value" must be left  */
+/* untouched on failure.                                                    */
+/****************************************************************************/
+static int test_decatoi_one(const char *s, size_t len) {
+    int64_t got = -7, want = -7;
+    int rc = decatoi(s, len, &got);
+    int ref = ref_decatoi(s, len, &want);
+
+    return TEST_CHECK(rc == ref && got == want, "decatoi", s, len);
+}
+
+static void test_decatoi(void) {
+    char s[32], text[64 * 32];
+    aiu_str f[64];
+    int64_t got[64], want[64];
+    int rcs[64];
+    unsigned long i;
+    size_t n, j;
+
+    for (n = 0; n <= 3; n++) test_every(n, NULL, test_decatoi_one);
+    for (n = 4; n <= 6; n++) test_every(n, " \t+-019x", test_decatoi_one);
+
+    for (i = 0; i < g_iters; i++) {
+        n = test_number(s, 24, 10);
+        test_decatoi_one(s, n);
+    }
+
+    /* Batches of 64 fields, mostly short plain digits for the word path */
+    for (i = 0; i < g_iters / 64; i++) {
+        size_t ok, ref_ok = 0;
+
+        for (j = 0; j < 64; j++) {
+            f[j].ptr = text + j * 32;
+            f[j].len = test_number(text + j * 32, test_rand() % 2 ? 16 : 24, 10);
+            got[j] = want[j] = -7;
+        }
+        ok = decatoi_batch(f, 64, got, rcs);
+        for (j = 0; j < 64; j++) {
+            int ref = ref_decatoi(f[j].ptr, f[j].len, &want[j]);
+
+            TEST_CHECK(rcs[j] == ref && got[j] == want[j], "decatoi_batch", f[j].ptr, f[j].len);
+            ref_ok += (size_t)ref;
+        }
+        TEST_CHECK(ok == ref_ok, "decatoi_batch count", "", 0);
+    }
+}
+
+/****************************************************************************/
+/* test_octatoi() - octatoi() against strtoll(, 8), as for decatoi()        */
+/****************************************************************************/
+static int test_octatoi_one(const char *s, size_t len) {
+    int64_t got = -7, want = -7;
+    int rc = octatoi(s, len, &got);
+    int ref = ref_octatoi(s, len, &want);
+
+    return TEST_CHECK(rc == ref && got == want, "octatoi", s, len);
+}
+
+static void test_octatoi(void) {
+    char s[32];
+    unsigned long i;
+    size_t n;
+
+    for (n = 0; n <= 3; n++) test_every(n, NULL, test_octatoi_one);
+    for (n = 4; n <= 6; n++) test_every(n, " \t+-0178", test_octatoi_one);
+    for (i = 0; i < g_iters; i++) {
+        n = test_number(s, 28, 8);
+        test_octatoi_one(s, n);
+    }
+}
+
+/****************************************************************************/
+/* test_casesearch() - aiu_casesearch_find() against a toupper() scan       */
+/*                                                                          */
+/* Random haystacks of up to 100 chars and needles of up to 20, most of     */
+/* them cut out of the haystack with their case flipped, so there are hits  */
+/* at every offset, partial hits and misses, inside the 16-position blocks  */
+/* and in the Horspool tail. The result must be the first match.            */
+/****************************************************************************/
+static const char *ref_casesearch(const char *hay, size_t len, const char *needle) {
+    size_t m = strlen(needle), pos, i;
+
+    for (pos = 0; pos + m <= len; pos++) {
+        for (i = 0; i < m; i++)
+            if (toupper((unsigned char)hay[pos + i]) != toupper((unsigned char)needle[i])) break;
+        if (i == m) return hay + pos;
+    }
+    return NULL;
+}
+
+static void test_casesearch(void) {
+    static const char alpha[] = "aAbBzZ-_0@[\xe9";
+    char hay[128], needle[24];
+    aiu_casesearch cs;
+    unsigned long i;
+
+    for (i = 0; i < g_iters / 4; i++) {
+        size_t len = test_text(hay, 100, alpha), m, j;
+
+        if (len > 0 && i % 4) {             /* a piece of "hay", case flipped */
+            size_t at = test_rand() % len;
+
+            m = test_rand() % 21;
+            if (m > len - at) m = len - at;
+            for (j = 0; j < m; j++) {
+                char c = hay[at + j];
+                needle[j] = (char)(isalpha((unsigned char)c) && test_rand() % 2 ? c ^ 0x20 : c);
+            }
+            if (m > 0 && i % 8 == 1) needle[test_rand() % m] = alpha[test_rand() % 12];
+        } else {
+            m = test_text(needle, 8, alpha);
+        }
+        needle[m] = '\0';
+        m = strlen(needle);                 /* random bytes may include a null  */
+
+        aiu_casesearch_compile(&cs, needle);
+        TEST_CHECK(aiu_casesearch_find(&cs, hay, len) == ref_casesearch(hay, len, needle),
+                   "aiu_casesearch_find", hay, len);
+    }
+}
+
+/****************************************************************************/
+/* test_laststrstr() - laststrstr_n() and laststrstr()                      */
+/*                                                                          */
+/* laststrstr_n() against a right-to-left memcmp() at every offset, on      */
+/* repetitive random haystacks (nulls included) and needles of 0 to 12      */
+/* chars, most of them cut out of the haystack, so the reverse skip table   */
+/* is crossed by near misses. laststrstr() must match the legacy repeated   */
+/* strstr() loop on the same text up to its first null.                     */
+/****************************************************************************/
+static const char *ref_laststrstr_n(const char *hay, size_t len, const char *needle, size_t m) {
+    size_t pos = len - m + 1;
+
+    if (m > len) return NULL;
+    while (pos-- > 0) if (memcmp(hay + pos, needle, m) == 0) return hay + pos;
+    return NULL;
+}
+
+static void test_laststrstr(void) {
+    char hay[96], needle[16];
+    unsigned long i;
+
+    for (i = 0; i < g_iters / 2; i++) {
+        size_t len = test_text(hay, 80, i % 2 ? "ab" : "abcab"), m;
+
+        if (len > 0 && i % 4) {
+            size_t at = test_rand() % len;
+
+            m = test_rand() % 13;
+            if (m > len - at) m = len - at;
+            memcpy(needle, hay + at, m);
+            if (m > 0 && i % 8 == 1) needle[test_rand() % m] ^= 1;
+        } else {
+            m = test_text(needle, 3, "abc");
+        }
+        TEST_CHECK(laststrstr_n(hay, len, needle, m) == ref_laststrstr_n(hay, len, needle, m),
+                   "laststrstr_n", hay, len);
+
+        hay[len] = needle[m] = '\0';
+        TEST_CHECK(laststrstr(hay, needle) == ref_laststrstr(hay, needle), "laststrstr",
+                   hay, len);
+    }
+}
+
+/****************************************************************************/
+/* test_split() - aiu_split() and aiu_tok_next() against a byte loop        */
+/*                                                                          */
+/* Random lines of up to 100 chars (nulls included) against delimiter sets  */
+/* of 0, 1, 2 to 4 and more than 4 chars, so the memchr(), block and bitmap */
+/* scans are all used, with "keep_empty" 0 and 1 and a "max_fields" that    */
+/* is often too small. Every stored span and the count must match.          */
+/****************************************************************************/
+static size_t ref_split(const char *s, size_t len, const char *delim, aiu_str *fields,
+                        size_t max_fields, int keep_empty) {
+    size_t nd = strlen(delim), n = 0, i = 0, start;
+
+#define REF_IS_DELIM(c) (memchr(delim, (unsigned char)(c), nd) != NULL)
+    if (keep_empty) {
+        for (start = 0; i <= len; i++) {
+            if (i < len && !REF_IS_DELIM(s[i])) continue;
+            if (n < max_fields) fields[n].ptr = s + start, fields[n].len = i - start;
+            n++;
+            start = i + 1;
+        }
+        return n;
+    }
+    for (;;) {
+        while (i < len && REF_IS_DELIM(s[i])) i++;
+        if (i == len) return n;
+        for (start = i; i < len && !REF_IS_DELIM(s[i]); i++) {}
+        if (n < max_fields) fields[n].ptr = s + start, fields[n].len = i - start;
+        n++;
+    }
+#undef REF_IS_DELIM
+}
+
+static void test_split(void) {
+    static const char *const delims[] = { "", ",", ",;", ", ;\t", ",;: \t|" };
+    char line[128];
+    aiu_str got[72], want[72];
+    unsigned long i;
+
+    for (i = 0; i < g_iters / 2; i++) {
+        const char *delim = delims[i % 5];
+        size_t len = test_text(line, 100, i % 3 ? "ab,;: \t|" : "abcdefghijklmnop,"), max, n, k;
+        int keep = (int)(i / 5 % 2);
+        aiu_delims d;
+        aiu_tokenizer t;
+        aiu_str tok;
+
+        max = (i % 7 == 0) ? test_rand() % 4 : 72;
+        aiu_delims_init(&d, delim);
+        n = aiu_split(line, len, &d, got, max, keep);
+        TEST_CHECK(n == ref_split(line, len, delim, want, max, keep), "aiu_split count", line, len);
+        for (k = 0; k < n && k < max; k++)
+            TEST_CHECK(got[k].ptr == want[k].ptr && got[k].len == want[k].len, "aiu_split span",
+                       line, len);
+
+        n = ref_split(line, len, delim, want, 72, 0);
+        aiu_tok_init(&t, line, len, &d);
+        for (k = 0; aiu_tok_next(&t, &tok); k++)
+            if (!TEST_CHECK(k < n && tok.ptr == want[k].ptr && tok.len == want[k].len,
+                            "aiu_tok_next", line, len)) break;
+        TEST_CHECK(k >= n, "aiu_tok_next count", line, len);
+    }
+}
+
+/****************************************************************************/
+/* test_mapfile() - mapped line iteration against safe_gets()               */
+/*                                                                          */
+/* Random files of short lines (blank ones, '\r', no final newline, an      */
+/* empty file) are written to TEST_FILE and read three ways: safe_gets()    */
+/* with a buffer longer than any line (the reference), aiu_mapfile_open()   */
+/* with aiu_linereader_init_mem(), and aiu_linereader on the stream with a  */
+/* small block, whose lines must be the reference cut to the block size,    */
+/* with "truncated" set exactly when the raw line was longer.               */
+/****************************************************************************/
+#define TEST_FILE "aiutils_test.tmp"
+
+static void test_mapfile(void) {
+    static char data[4096], ref[4096 + 2], block[64];
+    unsigned long i;
+
+    for (i = 0; i < g_iters / 200 + 1; i++) {
+        size_t len = i == 0 ? 0 : test_text(data, sizeof(data) - 1, "ab \t\r\n\n\n");
+        size_t bsize = 1 + test_rand() % sizeof(block), j;
+        const char *line = data, *end = data + len;
+        aiu_linereader mr, br;
+        aiu_mapfile mf;
+        aiu_str m, b;
+        FILE *f, *g;
+
+        for (j = 0; j < len; j++)       /* safe_gets() stops at a null      */
+            if (data[j] == '\0') data[j] = 'z';
+        f = fopen(TEST_FILE, "wb");
+        if (!f || fwrite(data, 1, len, f) != len || fclose(f) != 0) {
+            TEST_CHECK(0, "mapfile (can't write " TEST_FILE ")", "", 0);
+            return;
+        }
+
+        TEST_CHECK(aiu_mapfile_open(&mf, TEST_FILE) && mf.len == len &&
+                   (len == 0 || !memcmp(mf.data, data, len)), "aiu_mapfile_open", data, len);
+        aiu_linereader_init_mem(&mr, mf.data, mf.len);
+        f = fopen(TEST_FILE, "rb");
+        g = fopen(TEST_FILE, "rb");
+        if (!f || !g || !aiu_linereader_init(&br, f, block, bsize)) {
+            TEST_CHECK(0, "mapfile (can't read " TEST_FILE ")", "", 0);
+            return;
+        }
+
+        while (safe_gets(ref, sizeof(ref), g) != NULL) {
+            const char *nl = (const char *)memchr(line, '\n', (size_t)(end - line));
+            size_t raw = nl ? (size_t)(nl - line) : (size_t)(end - line);
+            size_t rl = strlen(ref), want = rl < bsize ? rl : bsize;
+
+            TEST_CHECK(aiu_linereader_next(&mr, &m) && m.len == rl &&
+                       !memcmp(m.ptr, ref, rl), "aiu_linereader_init_mem", line, raw);
+            TEST_CHECK(aiu_linereader_next(&br, &b) && b.len == want &&
+                       !memcmp(b.ptr, ref, want) && br.truncated == (raw > bsize),
+                       "aiu_linereader_next", line, raw);
+            line += raw + 1;
+        }
+        TEST_CHECK(!aiu_linereader_next(&mr, &m), "aiu_linereader_init_mem (extra line)", data, len);
+        TEST_CHECK(!aiu_linereader_next(&br, &b), "aiu_linereader_next (extra line)", data, len);
+        fclose(f);
+        fclose(g);
+        aiu_mapfile_close(&mf);
+    }
+    remove(TEST_FILE);
+}
+
+/****************************************************************************/
+/* test_inplace_n() - the _n helpers and the wrappers built on them         */
+/*                                                                          */
+/* Every call is made twice, null-terminated and as a (ptr,len) span, on    */
+/* random blank-padded text, and compared with the strlen()-based code.     */
+/* Copies go to TEST_BUF buffers filled with 'x', compared whole, so a      */
+/* write past the null or past "dest_size" shows up. trim_inplace() only    */
+/* promises the string: the old memmove() left other bytes past the null.   */
+/****************************************************************************/
+#define TEST_BUF 96
+
+static void test_inplace_n(void) {
+    static const char alpha[] = "  \t\n\vab_,xyz";
+    char s[64], a[TEST_BUF], b[TEST_BUF];
+    unsigned long i;
+
+    for (i = 0; i < g_iters; i++) {
+        size_t len = test_text(s, sizeof(s) - 1, alpha), n;
+        size_t dsize = test_rand() % 72, pos = test_rand() % 72;
+        size_t want = test_rand() % 4 == 0 ? SIZE_MAX : test_rand() % 72;
+        char mode = "lrbx"[test_rand() % 4];
+        char ch = alpha[test_rand() % (sizeof(alpha) - 1)], newch = (char)('A' + i % 26);
+        int skipends = (int)(test_rand() % 2);
+
+        s[len] = '\0';
+        len = strlen(s);                /* test_text() can put a null in    */
+
+        strcpy(a, s);
+        strcpy(b, s);
+        trim_inplace(a, mode);
+        ref_trim_inplace(b, mode);
+        TEST_CHECK(!strcmp(a, b), "trim_inplace", s, len);
+        memcpy(a, s, len);
+        n = trim_inplace_n(a, len, mode);
+        TEST_CHECK(n == strlen(b) && !memcmp(a, b, n), "trim_inplace_n", s, len);
+
+        strcpy(a, s);
+        strcpy(b, s);
+        remove_char_inplace(a, ch);
+        ref_remove_char(b, ch);
+        TEST_CHECK(!strcmp(a, b), "remove_char_inplace", s, len);
+        memcpy(a, s, len);
+        n = remove_char_inplace_n(a, len, ch);
+        TEST_CHECK(n == strlen(b) && !memcmp(a, b, n), "remove_char_inplace_n", s, len);
+
+        strcpy(a, s);
+        strcpy(b, s);
+        replace_char_inplace(a, ch, newch, skipends);
+        ref_replace_char(b, ch, newch, skipends);
+        TEST_CHECK(!memcmp(a, b, len + 1), "replace_char_inplace", s, len);
+        memcpy(a, s, len);
+        replace_char_inplace_n(a, len, ch, newch, skipends);
+        TEST_CHECK(!memcmp(a, b, len), "replace_char_inplace_n", s, len);
+
+        memset(a, 'x', TEST_BUF);
+        memset(b, 'x', TEST_BUF);
+        replace_char_safe_copy(a, s, dsize, ch, newch, skipends);
+        ref_replace_char_copy(b, s, dsize, ch, newch, skipends);
+        TEST_CHECK(!memcmp(a, b, TEST_BUF), "replace_char_safe_copy", s, len);
+        memset(a, 'x', TEST_BUF);
+        n = replace_char_safe_copy_n(a, s, len, dsize, ch, newch, skipends);
+        TEST_CHECK(!memcmp(a, b, TEST_BUF) && n == (dsize ? strlen(b) : 0),
+                   "replace_char_safe_copy_n", s, len);
+
+        memset(a, 'x', TEST_BUF);
+        memset(b, 'x', TEST_BUF);
+        substring_safe_copy(a, s, dsize, pos, want);
+        ref_substring(b, s, dsize, pos, want);
+        TEST_CHECK(!memcmp(a, b, TEST_BUF), "substring_safe_copy", s, len);
+        memset(a, 'x', TEST_BUF);
+        n = substring_safe_copy_n(a, s, len, dsize, pos, want);
+        TEST_CHECK(!memcmp(a, b, TEST_BUF) && n == (dsize ? strlen(b) : 0),
+                   "substring_safe_copy_n", s, len);
+
+        TEST_CHECK(lastN(s, pos) == ref_lastN(s, pos) &&
+                   lastN_n(s, len, pos) == ref_lastN(s, pos), "lastN", s, len);
+    }
+}
+
+/****************************************************************************/
+/* test_trim_span() - trim_span() and trim_safe_copy() against isspace()    */
+/*                                                                          */
+/* Every string of 0..2 bytes and every one of 3 from blanks and a letter   */
+/* (so each byte's table class is checked against isspace()), then long     */
+/* blank-padded fields for the 8-blanks-at-a-time runs. trim_span() must    */
+/* drop exactly the isspace() bytes at the ends, nulls included in the      */
+/* span, and agree with ref_trim_inplace() on a string.                     */
+/*                                                                          */
+/* trim_safe_copy() trims first and then cuts to fit: the reference is the  */
+/* whole trimmed source cut to "dest_size" - 1, right-trimmed again for     */
+/* 'r' and 'b' if it was cut. That is the old copy-then-trim result         */
+/* whenever the whole source fits, which is checked too.                    */
+/****************************************************************************/
+static int test_trim_span_one(const char *s, size_t len) {
+    static const char modes[] = "lrbx";
+    char cs[TEST_BUF], r[TEST_BUF], a[TEST_BUF], b[TEST_BUF];
+    size_t m, lead, end, rl, n, dsize = test_rand() % (len + 3);
+    int ok = 1;
+
+    memcpy(cs, s, len);
+    cs[len] = '\0';
+    for (m = 0; m < 4; m++) {
+        char mode = modes[m];
+        aiu_str t = trim_span(s, len, mode);
+
+        lead = 0;
+        end = len;
+        if (mode == 'l' || mode == 'b')
+            while (lead < len && isspace((unsigned char)s[lead])) lead++;
+        if (mode == 'r' || mode == 'b')
+            while (end > lead && isspace((unsigned char)s[end - 1])) end--;
+        strcpy(r, cs);
+        ref_trim_inplace(r, mode);
+        rl = strlen(r);
+        ok &= TEST_CHECK(t.ptr == s + lead && t.len == end - lead &&
+                         (strlen(cs) < len || (rl == t.len && !memcmp(t.ptr, r, rl))),
+                         "trim_span", s, len);
+
+        n = dsize == 0 ? 0 : rl < dsize - 1 ? rl : dsize - 1;
+        if (n < rl && (mode == 'r' || mode == 'b'))
+            while (n > 0 && isspace((unsigned char)r[n - 1])) n--;
+        memset(a, 'x', TEST_BUF);
+        memset(b, 'x', TEST_BUF);
+        if (dsize) {
+            memcpy(b, r, n);
+            b[n] = '\0';
+        }
+        trim_safe_copy(a, cs, dsize, mode);
+        ok &= TEST_CHECK(!memcmp(a, b, TEST_BUF), "trim_safe_copy", s, len);
+        if (strlen(cs) < dsize) {       /* as strings: see trim_inplace()  */
+            ref_trim_copy(b, cs, dsize, mode);
+            ok &= TEST_CHECK(!strcmp(a, b), "trim_safe_copy (legacy)", s, len);
+        }
+    }
+    return ok;
+}
+
+static void test_trim_span(void) {
+    char s[80];
+    unsigned long i;
+    size_t n;
+
+    for (n = 0; n <= 2; n++) test_every(n, NULL, test_trim_span_one);
+    test_every(3, " \t\n\v\f\ra", test_trim_span_one);
+    for (i = 0; i < g_iters; i++) {
+        n = test_text(s, sizeof(s) - 1, i % 2 ? "        a" : " \t b\n c\r");
+        test_trim_span_one(s, n);
+    }
+}
+
+/****************************************************************************/
+/* test_translate() - aiu_translate_inplace() and _copy() per byte          */
+/*                                                                          */
+/* Random maps of up to 12 replace pairs (repeats included, so later pairs  */
+/* win) and up to 2 deletes, so both the 8-or-fewer blend path and the      */
+/* table loop run, with and without deletions, on text of up to 80 chars    */
+/* from the same alphabet. The reference applies the pairs and deletes to   */
+/* one byte at a time. In place, nothing past the new length may change;    */
+/* the copy must be the reference cut to "dest_size - 1", with skipends     */
+/* too, and nothing past its null may be written.                           */
+/****************************************************************************/
+static size_t ref_translate(char *out, const char *s, size_t len, const char *from,
+                            const char *to, const char *del, int skipends) {
+    size_t i, j = 0;
+
+    for (i = 0; i < len; i++) {
+        char c = s[i];
+        const char *p;
+
+        if (skipends && (i == 0 || i == len - 1)) {
+            out[j++] = c;
+            continue;
+        }
+        if (c != '\0' && strchr(del, c)) continue;
+        for (p = from; *p; p++) if (*p == s[i]) c = to[p - from];
+        out[j++] = c;
+    }
+    return j;
+}
+
+static void test_translate(void) {
+    static const char alpha[] = "abcdefghij ,;\t";
+    char from[16], to[16], del[4], s[TEST_BUF], got[TEST_BUF], want[TEST_BUF];
+    aiu_charmap cm;
+    unsigned long i;
+
+    TEST_CHECK(!aiu_charmap_compile(&cm, "ab", "c", NULL), "aiu_charmap_compile", "ab", 2);
+    for (i = 0; i < g_iters / 2; i++) {
+        size_t np = (i % 2) ? test_rand() % 5 : 5 + test_rand() % 8;
+        size_t nd = (i % 3 == 0) ? test_rand() % 3 : 0, k, len, n, want_n, size;
+        int skip = (int)(i / 2 % 2);
+
+        for (k = 0; k < np; k++) {
+            from[k] = alpha[test_rand() % 14];
+            to[k] = alpha[test_rand() % 14];
+        }
+        from[np] = to[np] = '\0';
+        for (k = 0; k < nd; k++) del[k] = alpha[test_rand() % 14];
+        del[nd] = '\0';
+        aiu_charmap_compile(&cm, from, to, del);
+
+        len = test_text(s, 80, alpha);
+        want_n = ref_translate(want, s, len, from, to, del, skip);
+
+        memset(got, 'x', TEST_BUF);
+        memcpy(got, s, len);
+        n = aiu_translate_inplace(&cm, got, len, skip);
+        memcpy(want + want_n, s + want_n, len - want_n);
+        memset(want + len, 'x', TEST_BUF - len);
+        TEST_CHECK(n == want_n && !memcmp(got, want, TEST_BUF), "aiu_translate_inplace", s, len);
+
+        size = (i % 4 == 0) ? test_rand() % (len + 2) : TEST_BUF;
+        want_n = ref_translate(want, s, len, from, to, del, skip);
+        if (want_n + 1 > size) want_n = size ? size - 1 : 0;
+        memset(want + want_n, 'x', TEST_BUF - want_n);
+        if (size > 0) want[want_n] = '\0';
+        else memset(want, 'x', TEST_BUF);
+        memset(got, 'x', TEST_BUF);
+        n = aiu_translate_copy(&cm, got, s, len, size, skip);
+        TEST_CHECK(n == want_n && !memcmp(got, want, TEST_BUF), "aiu_translate_copy", s, len);
+    }
+}
+
+/****************************************************************************/
+/* test_sb() - aiu_sb appends against snprintf()                            */
+/*                                                                          */
+/* Random runs of every append go to three builders: on the heap, in an     */
+/* arena that always has room, and in a small arena that runs out. Other    */
+/* arena blocks are allocated and filled between appends, so the builder    */
+/* keeps moving to new blocks; they must come out intact. An append that    */
+/* returns 0 must set "failed" and append nothing.                          */
+/****************************************************************************/
+#define TEST_SB_OPS 48
+
+/* One random append to "sb"; "ref" gets the same text from snprintf() */
+static int test_sb_op(aiu_sb *sb, uint32_t op, const char *word, char *ref) {
+    uint64_t v = ((uint64_t)test_rand() << 40) ^ ((uint64_t)test_rand() << 16) ^ test_rand();
+    size_t wlen = strlen(word), width, fill, k;
+    int n = 0;
+
+    v >>= op % 64;
+    switch (op % 7) {
+    case 0:
+        n = snprintf(ref, 64, "%s", word);
+        return aiu_sb_append(sb, word, wlen) ? n : -1;
+    case 1:
+        n = snprintf(ref, 64, "%s", word);
+        return aiu_sb_append_str(sb, word) ? n : -1;
+    case 2:
+        ref[0] = word[0];
+        return aiu_sb_append_char(sb, word[0]) ? 1 : -1;
+    case 3:
+        n = snprintf(ref, 64, "%lu", (unsigned long)(uint32_t)v);
+        return aiu_sb_append_u32(sb, (uint32_t)v) ? n : -1;
+    case 4:
+        n = snprintf(ref, 64, "%lld", (long long)(op & 128 ? (int64_t)v : -(int64_t)v));
+        if (op % 61 == 0) n = snprintf(ref, 64, "%lld", (long long)INT64_MIN);
+        return aiu_sb_append_i64(sb, op % 61 == 0 ? INT64_MIN
+                                     : op & 128 ? (int64_t)v : -(int64_t)v) ? n : -1;
+    case 5:
+        width = (op >> 8) % 20;
+        n = snprintf(ref, 64, "%0*llx", (int)(width > 16 ? 16 : width), (unsigned long long)v);
+        return aiu_sb_append_hex(sb, v, width) ? n : -1;
+    default:
+        width = (op >> 8) % 24;
+        fill = width > wlen ? width - wlen : 0;
+        for (k = 0; k < fill; k++) ref[(op & 512 ? 0 : wlen) + k] = '.';
+        memcpy(ref + (op & 512 ? fill : 0), word, wlen);
+        return aiu_sb_append_padded(sb, word, wlen, width, '.', op & 512 ? 'r' : 'l')
+               ? (int)(wlen + fill) : -1;
+    }
+}
+
+static void test_sb(void) {
+    static const char *const words[] = { "", "a", "user=", "GET /index.html", "x-y-z" };
+    static char big[1 << 16], small[160], ref[2][TEST_SB_OPS * 64];
+    unsigned long i;
+
+    for (i = 0; i < g_iters / 50 + 1; i++) {
+        aiu_arena big_arena, small_arena;
+        aiu_sb sb[3];
+        size_t rlen[3] = { 0, 0, 0 }, bsize[TEST_SB_OPS], j, k, nblocks = 0;
+        unsigned char *blocks[TEST_SB_OPS];
+        char tmp[64];
+
+        aiu_arena_init(&big_arena, big, sizeof(big));
+        aiu_arena_init(&small_arena, small, 8 + test_rand() % (sizeof(small) - 8));
+        aiu_sb_init(&sb[0], NULL);
+        aiu_sb_init(&sb[1], &big_arena);
+        aiu_sb_init(&sb[2], &small_arena);
+
+        for (j = 0; j < TEST_SB_OPS; j++) {
+            uint32_t op = test_rand(), state = test_rand_state;
+            const char *word = words[(op >> 12) % 5];
+
+            for (k = 0; k < 3; k++) {
+                size_t before = sb[k].len;
+                int n;
+
+                test_rand_state = state;        /* same values for all 3    */
+                n = test_sb_op(&sb[k], op, word, tmp);
+                if (n < 0) {
+                    TEST_CHECK(k == 2 && sb[k].failed && sb[k].len == before,
+                               "aiu_sb (failed append)", word, strlen(word));
+                    continue;
+                }
+                memcpy(ref[k == 2] + rlen[k], tmp, (size_t)n);
+                rlen[k] += (size_t)n;
+            }
+            if (op % 5 == 0) {          /* another arena user in between    */
+                bsize[nblocks] = 1 + op % 13;
+                blocks[nblocks] = (unsigned char *)aiu_arena_alloc(&big_arena, bsize[nblocks], 1);
+                if (blocks[nblocks]) memset(blocks[nblocks], (int)nblocks, bsize[nblocks]);
+                nblocks++;
+            }
+        }
+
+        for (k = 0; k < 3; k++) {
+            aiu_str v = aiu_sb_view(&sb[k]);
+            const char *c = aiu_sb_cstr(&sb[k]);
+
+            TEST_CHECK(v.len == rlen[k] && !memcmp(v.ptr, ref[k == 2], rlen[k]) &&
+                       !memcmp(c, ref[k == 2], rlen[k]) && c[rlen[k]] == '\0' &&
+                       (k == 2 || !sb[k].failed),
+                       k == 0 ? "aiu_sb (heap)" : k == 1 ? "aiu_sb (arena)" : "aiu_sb (small arena)",
+                       v.ptr, v.len);
+        }
+        for (j = 0; j < nblocks; j++) {
+            TEST_CHECK(blocks[j] != NULL, "aiu_sb (arena full)", "", 0);
+            for (k = 0; blocks[j] && k < bsize[j]; k++)
+                if (blocks[j][k] != (unsigned char)j) break;
+            TEST_CHECK(!blocks[j] || k == bsize[j], "aiu_sb (arena block overwritten)", "", 0);
+        }
+        aiu_sb_free(&sb[0]);
+    }
+}
+
+/****************************************************************************/
+/* test_prefixset() - aiu_prefixset_match() against a loop of strbgw()      */
+/*                                                                          */
+/* Random sets of up to 40 short prefixes (duplicates, "" and NULL          */
+/* entries, prefixes of each other) in every flag combination, matched      */
+/* against inputs that mostly start with one of them. The reference is the  */
+/* loop the set replaces: strbgw() (or a tolower() compare) on every        */
+/* prefix, keeping the first hit or the longest, lowest ID on a tie.        */
+/****************************************************************************/
+static int ref_prefix_match(const char *const *prefixes, size_t count, int flags,
+                            const char *s, size_t *match_len) {
+    size_t i, best_len = 0;
+    int best = -1;
+
+    for (i = 0; i < count; i++) {
+        const char *p = prefixes[i];
+        size_t k, plen;
+
+        if (p == NULL) continue;
+        plen = strlen(p);
+        if (flags & AIU_PREFIX_NOCASE) {
+            for (k = 0; k < plen && tolower((unsigned char)s[k]) ==
+                                    tolower((unsigned char)p[k]); k++) {}
+            if (k < plen) continue;
+        } else if (!strbgw(s, p)) {
+            continue;
+        }
+        if (best < 0 || (!(flags & AIU_PREFIX_FIRST) && plen > best_len)) {
+            best = (int)i;
+            best_len = plen;
+        }
+    }
+    *match_len = best_len;
+    return best;
+}
+
+static void test_prefixset(void) {
+    static char mem[1 << 14];
+    char words[40][8], s[24];
+    const char *prefixes[40];
+    unsigned long i;
+
+    for (i = 0; i < g_iters / 100 + 1; i++) {
+        size_t count = test_rand() % 41, j, n, got_len, want_len;
+        int flags = (int)(i % 4), r, got, want;
+        aiu_prefixset ps;
+        aiu_arena arena;
+
+        for (j = 0; j < count; j++) {
+            n = test_text(words[j], 6, "/abAB");
+            words[j][n] = '\0';
+            prefixes[j] = test_rand() % 16 ? words[j] : NULL;
+        }
+        aiu_arena_init(&arena, mem, sizeof(mem));
+        if (!TEST_CHECK(aiu_prefixset_compile(&ps, prefixes, count, flags, &arena),
+                        "aiu_prefixset_compile", "", 0))
+            continue;
+
+        for (r = 0; r < 100; r++) {
+            n = 0;
+            if (count && test_rand() % 4) {
+                const char *p = words[test_rand() % count];
+
+                n = strlen(p);
+                memcpy(s, p, n);
+            }
+            n += test_text(s + n, 8, "/abAB");
+            s[n] = '\0';
+            n = strlen(s);              /* test_text() can put a null in    */
+
+            got = aiu_prefixset_match(&ps, s, n, &got_len);
+            want = ref_prefix_match(prefixes, count, flags, s, &want_len);
+            TEST_CHECK(got == want && got_len == want_len, flags == 0 ? "aiu_prefixset_match" :
+                       flags == AIU_PREFIX_NOCASE ? "aiu_prefixset_match (NOCASE)" :
+                       flags == AIU_PREFIX_FIRST ? "aiu_prefixset_match (FIRST)" :
+                       "aiu_prefixset_match (NOCASE|FIRST)", s, n);
+        }
+    }
+}
+
+/****************************************************************************/
+/* test_gmtime() - aiu_gmtime() and aiu_format_iso8601() against gmtime_r() */
+/*                                                                          */
+/* Random seconds over the whole struct tm range (most of them in years     */
+/* 1..9999, around leap days and century years), visited in runs that       */
+/* repeat a second, step by a second or a day, and go backwards, so the     */
+/* per-thread day and second caches are hit and invalidated every way.      */
+/* aiu_gmtime() must fill the same fields as safe_gmtime(), and fail only   */
+/* where gmtime_r() does or past its documented limit; the ISO-8601 text    */
+/* must match strftime() for years 0..9999 and be "" otherwise.             */
+/****************************************************************************/
+#define TEST_GMTIME_MAX (INT64_C(784000000000) * 86400)  /* aiu_gmtime() limit */
+
+static void test_gmtime_one(int64_t secs) {
+    struct tm got, want;
+    time_t t = (time_t)secs;
+    char iso[AIU_ISO8601_LEN + 1], ref[64], txt[24];
+    int ok = aiu_gmtime(secs, &got);
+    int ref_ok = (int64_t)t == secs && safe_gmtime(&t, &want) != NULL;
+    size_t n;
+
+    snprintf(txt, sizeof(txt), "%lld", (long long)secs);
+    if (ok && ref_ok)
+        TEST_CHECK(got.tm_sec == want.tm_sec && got.tm_min == want.tm_min &&
+                   got.tm_hour == want.tm_hour && got.tm_mday == want.tm_mday &&
+                   got.tm_mon == want.tm_mon && got.tm_year == want.tm_year &&
+                   got.tm_wday == want.tm_wday && got.tm_yday == want.tm_yday &&
+                   got.tm_isdst == 0, "aiu_gmtime", txt, strlen(txt));
+    else
+        TEST_CHECK(!ok && (!ref_ok || secs > TEST_GMTIME_MAX || secs < -TEST_GMTIME_MAX),
+                   "aiu_gmtime (range)", txt, strlen(txt));
+
+    memset(iso, 'x', sizeof(iso));
+    n = aiu_format_iso8601(secs, iso, sizeof(iso));
+    if (ok && ref_ok && want.tm_year >= -1900 && want.tm_year <= 9999 - 1900) {
+        snprintf(ref, sizeof(ref), "%04d-%02d-%02dT%02d:%02d:%02dZ", want.tm_year + 1900,
+                 want.tm_mon + 1, want.tm_mday, want.tm_hour, want.tm_min, want.tm_sec);
+        TEST_CHECK(n == AIU_ISO8601_LEN && !strcmp(iso, ref), "aiu_format_iso8601", txt, strlen(txt));
+    } else {
+        TEST_CHECK(n == 0 && iso[0] == '\0', "aiu_format_iso8601 (range)", txt, strlen(txt));
+    }
+}
+
+static void test_gmtime(void) {
+    static const int64_t steps[] = { 0, 1, -1, 59, 86400, -86400, 86399 };
+    char small[AIU_ISO8601_LEN];
+    unsigned long i;
+    int k;
+
+    for (i = 0; i < g_iters / 10 + 1; i++) {
+        uint32_t r = test_rand();
+        int64_t secs = ((int64_t)test_rand() << 24) ^ test_rand(), step = steps[r % 7];
+
+        if (r % 8 < 5)                  /* years 1..9999                    */
+            secs = INT64_C(-62135596800) + (int64_t)((uint64_t)secs % UINT64_C(315537897600));
+        else if (r % 8 == 5)            /* midnight around a leap day       */
+            secs = (((int64_t)(test_rand() % 2000) - 1000) * 1461 + 59) * 86400 - r % 3;
+        else if (r % 8 == 6)            /* past aiu_gmtime()'s limit        */
+            secs = (r & 256 ? 1 : -1) * (TEST_GMTIME_MAX + (secs & 0xFFFFFF) - 0x7FFFFF);
+        if (sizeof(time_t) < 8) secs = (int32_t)secs;
+        for (k = 0; k < 8; k++, secs += step) test_gmtime_one(secs);
+    }
+
+    memset(small, 'x', sizeof(small));
+    TEST_CHECK(aiu_format_iso8601(0, small, sizeof(small)) == 0 && small[0] == '\0' &&
+               small[1] == 'x', "aiu_format_iso8601 (small buffer)", "0", 1);
+    TEST_CHECK(safe_gmtime(NULL, NULL) == NULL && aiu_gmtime(0, NULL) == 0,
+               "safe_gmtime (NULL)", "", 0);
+}
+
+/****************************************************************************/
+/* test_strcmpii_n() - strcmpii_n() and the keyword table                   */
+/*                                                                          */
+/* strcmpii_n() must return exactly what a byte loop over the ASCII fold    */
+/* returns: every pair of 0..1-byte strings, then random pairs (one a       */
+/* case-flipped copy of the other with a change or a cut, past a 16-byte    */
+/* SIMD block) including the bytes next to 'A'-'Z' and 0x80 and up. On      */
+/* ASCII strings without nulls the sign must match strcmpii().              */
+/*                                                                          */
+/* aiu_kwtable_find() must give the first ID whose keyword has the same     */
+/* length and compares equal: random tables of up to 200 keywords with      */
+/* NULLs and repeats in other case, probed with case-flipped keywords and   */
+/* near misses.                                                             */
+/****************************************************************************/
+static int test_sign(int x) { return (x > 0) - (x < 0); }
+
+/* "s" with the case of some letters flipped, one char changed or a cut */
+static size_t test_case_copy(char *d, const char *s, size_t len) {
+    size_t i;
+    uint32_t r = test_rand();
+
+    for (i = 0; i < len; i++)
+        d[i] = (char)(isalpha((unsigned char)s[i]) && test_rand() % 2 ? s[i] ^ 0x20 : s[i]);
+    if (len > 0 && r % 4 == 0) d[test_rand() % len] = "@[`{Zza\x80"[(r >> 4) % 8];
+    if (len > 0 && r % 8 == 1) len = test_rand() % len;
+    return len;
+}
+
+static int test_strcmpii_n_one(const char *s, size_t len) {
+    int ok = 1;
+    size_t i;
+
+    for (i = 0; i <= len; i++)
+        ok &= TEST_CHECK(strcmpii_n(s, i, s + i, len - i) ==
+                         ref_strcmpii_n(s, i, s + i, len - i), "strcmpii_n", s, len);
+    return ok;
+}
+
+static void test_strcmpii_n(void) {
+    static const char alpha[] = "abcxyzABCXYZ@[`{-_0\x80\xe9";
+    static char mem[1 << 16];
+    char a[48], b[48], words[200][12], probe[12];
+    const char *table[200];
+    unsigned long i;
+    size_t n, m, j;
+
+    for (n = 0; n <= 2; n++) test_every(n, NULL, test_strcmpii_n_one);
+    for (i = 0; i < g_iters; i++) {
+        n = test_text(a, 40, alpha);
+        m = test_case_copy(b, a, n);
+        TEST_CHECK(strcmpii_n(a, n, b, m) == ref_strcmpii_n(a, n, b, m) &&
+                   strcmpii_n(b, m, a, n) == ref_strcmpii_n(b, m, a, n), "strcmpii_n", a, n);
+        for (j = 0; j < n && (unsigned char)a[j] - 1u < 0x7F; j++) {}
+        if (j == n && !memchr(b, '\0', m) && !memchr(b, 0x80, m)) {
+            a[n] = b[m] = '\0';
+            for (j = 0; j < m && (unsigned char)b[j] < 0x80; j++) {}
+            if (j == m)
+                TEST_CHECK(test_sign(strcmpii_n(a, n, b, m)) == test_sign(strcmpii(a, b)),
+                           "strcmpii_n (vs strcmpii)", a, n);
+        }
+    }
+
+    for (i = 0; i < g_iters / 1000 + 1; i++) {
+        size_t count = test_rand() % 201;
+        aiu_kwtable kw;
+        aiu_arena arena;
+
+        for (j = 0; j < count; j++) {
+            if (j > 0 && test_rand() % 8 == 0) {        /* repeat, other case */
+                const char *w = words[test_rand() % j];
+
+                n = test_case_copy(words[j], w, strlen(w));
+            } else {
+                n = test_text(words[j], 10, "abcAB-_x");
+            }
+            words[j][n] = '\0';
+            table[j] = test_rand() % 32 ? words[j] : NULL;
+        }
+        aiu_arena_init(&arena, mem, sizeof(mem));
+        if (!TEST_CHECK(aiu_kwtable_build(&kw, table, count, &arena), "aiu_kwtable_build", "", 0))
+            continue;
+
+        for (j = 0; j < 400; j++) {
+            int got, want = -1;
+            size_t k;
+
+            if (count && j % 4) {
+                const char *w = words[test_rand() % count];
+
+                n = test_case_copy(probe, w, strlen(w));
+            } else {
+                n = test_text(probe, 10, "abcAB-_x");
+            }
+            for (k = 0; k < count && want < 0; k++)
+                if (table[k] && strlen(table[k]) == n && ref_strcmpii_n(table[k], n, probe, n) == 0)
+                    want = (int)k;
+            got = aiu_kwtable_find(&kw, probe, n);
+            TEST_CHECK(got == want, "aiu_kwtable_find", probe, n);
+        }
+    }
+}
+
+/****************************************************************************/
+/* test_csv() - aiu_csv_parse_record() and aiu_csv_parse() per byte         */
+/*                                                                          */
+/* Random records of up to 200 chars (several 64-byte mask blocks) full of  */
+/* delimiters and quotes, so there are "" escapes, text after a closing     */
+/* quote, unclosed quotes and quotes inside fields, plus records built to   */
+/* put a "" pair across a block edge. They are split by a byte loop that    */
+/* follows the documented rules, with ',' or ';' and '"', '\'' or no quote  */
+/* at all, and stored through an all-span schema and a numeric one, with    */
+/* short and long records. aiu_csv_parse() gets the records as lines with   */
+/* empty and "\r\n" ones among them, a few rows per call, resumed at        */
+/* "*consumed" until the data ends. The SWAR mask is checked by the plain   */
+/* build, the SSE2 one with AIUTILS_SIMD.                                   */
+/****************************************************************************/
+#define TEST_CSV_COLS 6
+#define TEST_CSV_ROWS 4
+
+static size_t ref_csv_split(const char *s, size_t len, char delim, char quote,
+                            aiu_str *f, size_t max) {
+    size_t n = 0, start = 0, i;
+
+    for (;;) {
+        aiu_str span;
+        int last = 1;
+
+        if (quote && start < len && s[start] == quote) {
+            for (i = start + 1; i < len; i++) {
+                if (s[i] != quote) continue;
+                if (i + 1 < len && s[i + 1] == quote) i++;
+                else break;
+            }
+            span.ptr = s + start + 1;
+            span.len = (i < len ? i : len) - start - 1;
+            for (; i < len && s[i] != delim; i++) {}
+        } else {
+            for (i = start; i < len && s[i] != delim; i++) {}
+            span.ptr = s + start;
+            span.len = i - start;
+        }
+        if (i < len) last = 0;
+        if (n < max) f[n] = span;
+        n++;
+        if (last) return n;
+        start = i + 1;
+    }
+}
+
+static const int test_csv_types[2][TEST_CSV_COLS] = {
+    { AIU_COL_STR, AIU_COL_STR, AIU_COL_STR, AIU_COL_STR, AIU_COL_STR, AIU_COL_STR },
+    { AIU_COL_DEC, AIU_COL_TRIM, AIU_COL_HEX, AIU_COL_SKIP, AIU_COL_OCT, AIU_COL_STR },
+};
+
+/* Check row "row" of "cols" against the reference split of s[0..len) */
+static void test_csv_row(const aiu_csvcol *cols, const int *types, size_t row,
+                         const char *s, size_t len, char delim, char quote, int nf) {
+    aiu_str f[TEST_CSV_COLS];
+    size_t n = ref_csv_split(s, len, delim, quote, f, TEST_CSV_COLS), k;
+
+    if (nf >= 0) TEST_CHECK((size_t)nf == n, "aiu_csv_parse_record count", s, len);
+    for (k = 0; k < TEST_CSV_COLS; k++) {
+        aiu_str want, t;
+        const aiu_str *got = &cols[k].strs[row];
+        int64_t v = -7;
+        int rc = 1;
+
+        want.ptr = k < n ? f[k].ptr : s + len;
+        want.len = k < n ? f[k].len : 0;
+        t = trim_span(want.ptr, want.len, 'b');
+        switch (types[k]) {
+        case AIU_COL_STR:
+            TEST_CHECK(got->ptr == want.ptr && got->len == want.len, "aiu_csv str", s, len);
+            continue;
+        case AIU_COL_TRIM:
+            TEST_CHECK(got->ptr == t.ptr && got->len == t.len, "aiu_csv trim", s, len);
+            continue;
+        case AIU_COL_DEC: rc = decatoi(t.ptr, t.len, &v); break;
+        case AIU_COL_HEX: rc = hexatoi(t.ptr, t.len, &v); rc = (rc == 0 || rc == 4); break;
+        case AIU_COL_OCT: rc = octatoi(t.ptr, t.len, &v); break;
+        default: continue;
+        }
+        TEST_CHECK(cols[k].ints[row] == v && cols[k].rcs[row] == rc, "aiu_csv number", s, len);
+    }
+}
+
+/* Random record text; the caller picks the delimiter and quote */
+static size_t test_csv_record(char *s, unsigned long i, char delim, char quote) {
+    size_t len, k;
+
+    if (i % 8 == 0) {                   /* "" across a 64-byte block edge   */
+        size_t edge = (test_rand() % 2 + 1) * 64 - 1, open = test_rand() % 40;
+
+        for (k = 0; k < open; k++) s[k] = (k + 1 == open) ? ',' : 'b';
+        s[open] = '"';
+        for (k = open + 1; k < edge; k++) s[k] = (test_rand() % 8) ? 'a' : ',';
+        memcpy(s + edge, "\"\"x\",yz", 7);
+        len = edge + 7;
+    } else {
+        len = test_text(s, 200, i % 2 ? "ab ,,\"" : "0x1f -,\"\"7");
+    }
+    for (k = 0; k < len; k++) {
+        if (s[k] == ',') s[k] = delim;
+        else if (s[k] == '"') s[k] = quote ? quote : '"';
+        else if (s[k] == '\n' || s[k] == '\r') s[k] = 'n';
+    }
+    return len;
+}
+
+static void test_csv(void) {
+    static const char quotes[] = { '"', '\'', '\0' };
+    static char data[TEST_CSV_ROWS * 4 * 216];
+    char rec[216];
+    size_t roff[TEST_CSV_ROWS * 4], rlen[TEST_CSV_ROWS * 4];
+    int64_t ints[TEST_CSV_COLS][TEST_CSV_ROWS];
+    aiu_str strs[TEST_CSV_COLS][TEST_CSV_ROWS];
+    int rcs[TEST_CSV_COLS][TEST_CSV_ROWS];
+    aiu_csvcol cols[TEST_CSV_COLS];
+    aiu_csv csv;
+    unsigned long i;
+    size_t k;
+
+    for (i = 0; i < g_iters / 20; i++) {
+        const int *types = test_csv_types[i % 2];
+        char delim = (i / 2 % 2) ? ';' : ',', quote = quotes[i / 4 % 3];
+        size_t nrec = test_rand() % (TEST_CSV_ROWS * 4), len = 0, pos, r, row;
+
+        for (k = 0; k < TEST_CSV_COLS; k++) {
+            cols[k].type = types[k];
+            cols[k].ints = ints[k];
+            cols[k].strs = strs[k];
+            cols[k].rcs = rcs[k];
+        }
+        for (k = 0; k < TEST_CSV_COLS; k++) for (r = 0; r < TEST_CSV_ROWS; r++) ints[k][r] = -7;
+        aiu_csv_init(&csv, cols, TEST_CSV_COLS, TEST_CSV_ROWS, delim, quote);
+
+        /* One record at a time, until the arrays are full */
+        for (row = 0; row <= TEST_CSV_ROWS; row++) {
+            size_t n = test_csv_record(rec, i + row, delim, quote);
+            int nf = aiu_csv_parse_record(&csv, rec, n);
+
+            if (row == TEST_CSV_ROWS) {
+                TEST_CHECK(nf == -1 && csv.rows == TEST_CSV_ROWS, "aiu_csv_parse_record full",
+                           rec, n);
+                break;
+            }
+            test_csv_row(cols, types, row, rec, n, delim, quote, nf);
+        }
+
+        /* The same through aiu_csv_parse(), a few rows per call */
+        for (r = 0; r < nrec; r++) {
+            if (test_rand() % 4 == 0) data[len++] = '\n';
+            roff[r] = len;
+            rlen[r] = test_csv_record(data + len, i + r + 1, delim, quote);
+            if (rlen[r] == 0) data[len + rlen[r]++] = 'e';
+            len += rlen[r];
+            if (r + 1 < nrec || test_rand() % 2) {
+                if (test_rand() % 3 == 0) data[len++] = '\r';
+                data[len++] = '\n';
+            }
+        }
+        for (pos = 0, r = 0;;) {
+            size_t used, got;
+
+            for (k = 0; k < TEST_CSV_COLS; k++) for (row = 0; row < TEST_CSV_ROWS; row++)
+                ints[k][row] = -7;
+            csv.rows = 0;
+            got = aiu_csv_parse(&csv, data + pos, len - pos, &used);
+            TEST_CHECK(got == csv.rows && used <= len - pos, "aiu_csv_parse rows", data, len);
+            for (row = 0; row < got && r < nrec; row++, r++) {
+                test_csv_row(cols, types, row, data + roff[r], rlen[r], delim, quote, -1);
+            }
+            pos += used;
+            if (got < TEST_CSV_ROWS) break;
+        }
+        TEST_CHECK(r == nrec && pos == len, "aiu_csv_parse consumed", data, len);
+    }
+}
+
+/****************************************************************************/
+/* test_stats() - AIUTILS_STATS counters across many thread lifetimes       */
+/*                                                                          */
+/* Runs aiu_parallel_lines() with 8 threads 40 times over (280 thread       */
+/* starts, more than AIU_STATS_SLOTS) with a callback that strzcpy()s each  */
+/* line into a small buffer. As threads exit their slots are reused, and    */
+/* the snapshot must still grow by exactly the calls, chars written and     */
+/* cuts made. Skipped unless built with -DAIUTILS_STATS.                    */
+/****************************************************************************/
+typedef struct test_stats_acc {
+    uint64_t calls, bytes, cuts;
+} test_stats_acc;
+
+static void test_stats_line(void *state, const aiu_str *line) {
+    test_stats_acc *acc = (test_stats_acc *)state;
+    char line0[64], d[8];
+    size_t n = line->len < sizeof(line0) ? line->len : sizeof(line0) - 1;
+
+    memcpy(line0, line->ptr, n);
+    line0[n] = '\0';
+    strzcpy(d, line0, sizeof(d));
+    acc->calls++;
+    acc->bytes += strlen(d);
+    acc->cuts += strlen(line0) >= sizeof(d);
+}
+
+static void test_stats(void) {
+    static char data[8 * 80000];
+    aiu_stat before[AIU_STAT_COUNT], after[AIU_STAT_COUNT];
+    test_stats_acc accs[8], sum = { 0, 0, 0 };
+    size_t len = 0, i;
+    int round;
+
+    if (!aiu_stats_snapshot(before)) return;
+    while (len + 20 <= sizeof(data)) {
+        len += test_text(data + len, 16, "abcdefgh");
+        data[len++] = '\n';
+    }
+    for (round = 0; round < 40; round++) {
+        memset(accs, 0, sizeof(accs));
+        aiu_parallel_lines(data, len, 8, test_stats_line, accs, sizeof(accs[0]));
+        for (i = 0; i < 8; i++) {
+            sum.calls += accs[i].calls;
+            sum.bytes += accs[i].bytes;
+            sum.cuts += accs[i].cuts;
+        }
+    }
+    aiu_stats_snapshot(after);
+    TEST_CHECK(after[AIU_STAT_STRZCPY].calls - before[AIU_STAT_STRZCPY].calls == sum.calls &&
+               after[AIU_STAT_STRZCPY].bytes - before[AIU_STAT_STRZCPY].bytes == sum.bytes &&
+               after[AIU_STAT_STRZCPY].truncations - before[AIU_STAT_STRZCPY].truncations ==
+                   sum.cuts, "aiu_stats_snapshot", "", 0);
+}
+
+/****************************************************************************/
+/* test_fitoa() - fitoa(), fitoa64(), fitoa_column() and fitoa_batch()      */
+/*                                                                          */
+/* Against the legacy digit loop at every width 0..21: every value below    */
+/* 20000, then random values of every magnitude and the powers of ten and   */
+/* their neighbours, where a field stops fitting. Each output buffer is     */
+/* pre-filled with 'x' and compared whole, so a stray write shows up.       */
+/****************************************************************************/
+static void test_fitoa_batch(const uint32_t *vals, size_t count, size_t wid) {
+    char got[32 * 23 + 1], want[32 * 23 + 1];
+    int rcs[32], fit[32];
+    size_t i, ok, ref_ok = 0;
+
+    memset(got, 'x', sizeof(got));
+    memset(want, 'x', sizeof(want));
+    fitoa_column(vals, count, wid, got, wid + 1);
+    for (i = 0; i < count; i++) {
+        fit[i] = ref_fitoa(vals[i], wid, want + i * (wid + 1));
+        want[i * (wid + 1) + wid] = 'x';    /* fitoa_column() writes no null */
+        ref_ok += (size_t)fit[i];
+    }
+    TEST_CHECK(!memcmp(got, want, sizeof(got)), "fitoa_column", got, count * (wid + 1));
+
+    memset(got, 'x', sizeof(got));
+    for (i = 0; i < count; i++) want[i * (wid + 1) + wid] = '\0';
+    ok = fitoa_batch(vals, count, wid, got, rcs);
+    for (i = 0; i < count; i++)
+        TEST_CHECK(rcs[i] == fit[i], "fitoa_batch code", want + i * (wid + 1), wid);
+    TEST_CHECK(!memcmp(got, want, sizeof(got)) && ok == ref_ok, "fitoa_batch",
+               got, count * (wid + 1));
+}
+
+static void test_fitoa(void) {
+    char got[24], want[24];
+    uint32_t vals[32];
+    unsigned long i;
+    size_t wid, j;
+
+    for (wid = 0; wid <= 21; wid++) {
+        for (i = 0; i < 20000 + g_iters / 4; i++) {
+            uint64_t v = i < 20000 ? i : ((uint64_t)test_rand() << 40) ^ ((uint64_t)test_rand() << 20)
+                                         ^ test_rand();
+            uint64_t p10 = 1;
+
+            if (i >= 20000) v >>= test_rand() % 64;
+            if (i >= 20000 && i % 4 == 0) {     /* 10^k - 1, 10^k, 10^k + 1 */
+                for (j = test_rand() % 20; j > 0; j--) p10 *= 10;
+                v = p10 - 1 + test_rand() % 3;
+            }
+            memset(got, 'x', sizeof(got));
+            memset(want, 'x', sizeof(want));
+            fitoa((uint32_t)v, wid, got);
+            ref_fitoa((uint32_t)v, wid, want);
+            TEST_CHECK(!memcmp(got, want, sizeof(got)), "fitoa", want, wid);
+            fitoa64(v, wid, got);
+            ref_fitoa(v, wid, want);
+            TEST_CHECK(!memcmp(got, want, sizeof(got)), "fitoa64", want, wid);
+
+            vals[i % 32] = (uint32_t)v;
+            if (i % 32 == 31) test_fitoa_batch(vals, 1 + test_rand() % 32, wid);
+        }
+    }
+}
+
+static const struct {
+    const char *name;
+    void (*run)(void);
+} g_tests[] = {
+    { "hexatoi",        test_hexatoi },
+    { "decatoi",        test_decatoi },
+    { "octatoi",        test_octatoi },
+    { "casesearch",     test_casesearch },
+    { "laststrstr",     test_laststrstr },
+    { "split",          test_split },
+    { "mapfile",        test_mapfile },
+    { "inplace_n",      test_inplace_n },
+    { "trim_span",      test_trim_span },
+    { "translate",      test_translate },
+    { "sb",             test_sb },
+    { "prefixset",      test_prefixset },
+    { "gmtime",         test_gmtime },
+    { "strcmpii_n",     test_strcmpii_n },
+    { "csv",            test_csv },
+    { "stats",          test_stats },
+    { "fitoa",          test_fitoa },
+};
+#define TEST_COUNT (sizeof(g_tests) / sizeof(g_tests[0]))
+
+int main(int argc, char **argv) {
+    size_t t;
+    int a, names = 0;
+
+    for (a = 1; a < argc; a++) {
+        if (!strcmp(argv[a], "-n") && a + 1 < argc) g_iters = strtoul(argv[++a], NULL, 10);
+        else if (!strcmp(argv[a], "-s") && a + 1 < argc)
+            test_rand_state = (uint32_t)strtoul(argv[++a], NULL, 10);
+        else names++;
+    }
+
+    for (t = 0; t < TEST_COUNT; t++) {
+        unsigned long before = g_failures;
+        int run = !names;
+
+        for (a = 1; a < argc && !run; a++) {
+            if (!strcmp(argv[a], "-n") || !strcmp(argv[a], "-s")) a++;
+            else if (strstr(g_tests[t].name, argv[a])) run = 1;
+        }
+        if (!run) continue;
+        g_tests[t].run();
+        printf("%-16s %s\n", g_tests[t].name, g_failures == before ? "ok" : "FAILED");
+    }
+
+    printf("aiutils_test: %lu checks, %lu failed (kernels: %s)\n",
+           g_checks, g_failures, aiu_cpu_variant_name());
+    return g_failures ? 1 : 0;
+}